@@ -0,0 +1,67 @@
+#ifndef ACCOUNTINGSAMPLER_H
+#define ACCOUNTINGSAMPLER_H
+
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "MemorySnapshot.h"
+#include "ProcessCache.h"
+#include "ProcessCollector.h"
+
+// Keeps PSS / USS / swap (ProcessAccounting) for every process without
+// paying for a full smaps_rollup pass per sample. Each update re-reads the
+// topCount largest processes by RSS, then continues a round-robin walk over
+// the rest until the per-update time budget is spent; every process is
+// reached eventually and each value carries the time it was read, so the
+// UI can show how stale it is.
+//
+// Used from the collector thread only.
+class AccountingSampler {
+public:
+    static constexpr size_t kDefaultTopCount = 20;
+    static constexpr uint64_t kDefaultBudgetUs = 5000;
+
+    AccountingSampler();
+
+    // Always refreshed, even if that alone exceeds the budget
+    void setTopCount(size_t count) { m_topCount = count; }
+    size_t topCount() const { return m_topCount; }
+
+    // Time per update for the round-robin tail
+    void setBudget(uint64_t microseconds) { m_budgetUs = microseconds; }
+    uint64_t budget() const { return m_budgetUs; }
+
+    // Reads through collector and stores the results under each process's
+    // identity; forgets processes the snapshot reports as exited
+    void update(const MemorySnapshot& snapshot, ProcessCollector& collector, uint64_t nowMs);
+
+    // Fills columns parallel to snapshot's processes; sampledAtMs is 0 for
+    // processes not read yet (their other values are 0 too)
+    void fill(const MemorySnapshot& snapshot,
+              std::vector<uint64_t>& proportional, std::vector<uint64_t>& unique,
+              std::vector<uint64_t>& swap, std::vector<uint64_t>& sampledAtMs) const;
+
+    void clear();
+
+    // Processes read by the last update, top included
+    size_t lastReadCount() const { return m_lastReadCount; }
+
+private:
+    struct Entry {
+        ProcessAccounting accounting;
+        uint64_t sampledAtMs = 0;
+    };
+
+    size_t m_topCount;
+    uint64_t m_budgetUs;
+    std::unordered_map<ProcessKey, Entry, ProcessKeyHash> m_entries;
+    size_t m_cursor;  // next row of the round-robin walk
+    size_t m_lastReadCount;
+
+    std::vector<uint8_t> m_isTop;  // scratch, per row
+
+    bool read(const MemorySnapshot& snapshot, size_t row, ProcessCollector& collector, uint64_t nowMs);
+};
+
+#endif // ACCOUNTINGSAMPLER_H
@@ -0,0 +1,143 @@
+#ifndef ALERTENGINE_H
+#define ALERTENGINE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "MemorySnapshot.h"
+
+// An alert rule changing state
+struct AlertEvent {
+    const std::string& rule;
+    bool active;             // raised, or cleared
+    const std::string& message;
+    uint64_t timestampMs;
+};
+
+// Receives alert state changes, on the thread that calls evaluate()
+class AlertSink {
+public:
+    virtual ~AlertSink() = default;
+    virtual void onAlert(const AlertEvent& event) = 0;
+};
+
+// Threshold rules evaluated against every snapshot. Rules are compiled once
+// from text, one per line ('#' starts a comment):
+//
+//   [name:] process [name|path "glob"] rss|vsz|growth <op> <value> [for <duration>]
+//   [name:] sum rss|vsz|growth [name|path "glob"] <op> <value> [for <duration>]
+//   [name:] count [name|path "glob"] <op> <number> [for <duration>]
+//   [name:] system free|used|active|inactive|wired <op> <value> [for <duration>]
+//
+//   op:       > >= < <=
+//   value:    number with B, KB, MB, GB, TB (binary), or % of total RAM;
+//             growth takes a rate such as 100MB/h (per s, m or h)
+//   duration: number with ms, s, m or h
+//
+// e.g.  java-big: process name "java" rss > 8GB
+//       low-free: system free < 5% for 30s
+//       chrome:   sum rss name "chrome*" > 40%
+//
+// "process" is true while any matching process satisfies the comparison.
+// A rule is raised once its condition has held for its duration, and
+// cleared when the value is back past the threshold by 5% (hysteresis).
+//
+// Glob patterns are matched once per distinct string of the snapshot's
+// StringPool, so each string id carries the list of rules it feeds.
+// Evaluation is a single pass over the snapshot columns that touches only
+// those lists plus one shared aggregate per metric for unfiltered rules.
+//
+// Not thread-safe; SystemMonitor evaluates on the collector thread.
+class AlertEngine {
+public:
+    AlertEngine();
+    ~AlertEngine();
+
+    AlertEngine(const AlertEngine&) = delete;
+    AlertEngine& operator=(const AlertEngine&) = delete;
+
+    // Replaces the rules; on error keeps the old ones and describes the
+    // bad line in error. Rules that were active are cleared (through
+    // the sink) when they are replaced.
+    bool compile(const std::string& text, std::string& error);
+
+    // Not owned; null drops events
+    void setSink(AlertSink *sink) { m_sink = sink; }
+
+    void evaluate(const MemorySnapshot& snapshot);
+
+    size_t ruleCount() const { return m_rules.size(); }
+    size_t activeCount() const;
+
+private:
+    enum class Scope : uint8_t { Process, Sum, Count, System };
+    enum class Metric : uint8_t { ResidentSize, VirtualSize, Growth, MetricCount };
+    enum class Counter : uint8_t { Free, Used, Active, Inactive, Wired };
+    enum class Field : uint8_t { Any, Name, Path };
+    enum class Compare : uint8_t { Greater, GreaterEqual, Less, LessEqual };
+
+    // Per-pass result over the rows a rule looks at
+    struct Aggregate {
+        double max;
+        double min;
+        double sum;
+        uint64_t count;
+        uint32_t maxRow;
+        uint32_t minRow;
+
+        void reset();
+        void add(double value, uint32_t row);
+    };
+
+    struct Rule {
+        std::string name;
+        std::string text;
+        Scope scope;
+        Metric metric;
+        Counter counter;
+        Field field;
+        uint32_t pattern;   // index into m_patterns when field != Any
+        Compare compare;
+        double threshold;   // bytes, bytes/s or a count
+        bool percent;       // threshold is % of total RAM
+        uint64_t forMs;
+
+        Aggregate aggregate;
+        uint64_t sinceMs;   // when the condition started holding
+        bool holding;
+        bool active;
+    };
+
+    std::vector<Rule> m_rules;
+    std::vector<std::string> m_patterns;
+    std::vector<char> m_patternHits;  // scratch for indexStrings
+    AlertSink *m_sink;
+
+    // Rules fed by each string id as a name and as a path, flattened:
+    // string id s feeds rules[offsets[s]..offsets[s + 1]). A pool only
+    // grows, so each evaluation indexes just the strings added since the
+    // last; a new pool (after the cache compacts) is indexed from scratch.
+    // Held so a later pool cannot reuse the address.
+    struct RuleIndex {
+        std::vector<uint32_t> offsets;
+        std::vector<uint16_t> rules;
+    };
+
+    std::shared_ptr<const StringPool> m_pool;
+    RuleIndex m_byName;
+    RuleIndex m_byPath;
+
+    // Over every process, for the metrics unfiltered rules read
+    Aggregate m_all[static_cast<int>(Metric::MetricCount)];
+    bool m_needAll[static_cast<int>(Metric::MetricCount)];
+
+    bool parseRule(const std::string& line, Rule& rule, std::string& error);
+    void indexStrings(const std::shared_ptr<const StringPool>& strings);
+    void update(Rule& rule, double value, double threshold, const MemorySnapshot& snapshot);
+    std::string describe(const Rule& rule, double value, double threshold,
+                         const MemorySnapshot& snapshot) const;
+};
+
+#endif // ALERTENGINE_H
@@ -0,0 +1,18 @@
+#ifndef CUMULATIVEPERCENTDELEGATE_H
+#define CUMULATIVEPERCENTDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+// Colors a Cumulative % cell from its value at paint time, so nothing has
+// to be written back into the model when the cumulative values move
+class CumulativePercentDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    explicit CumulativePercentDelegate(QObject *parent = nullptr);
+
+protected:
+    void initStyleOption(QStyleOptionViewItem *option, const QModelIndex& index) const override;
+};
+
+#endif // CUMULATIVEPERCENTDELEGATE_H
@@ -0,0 +1,84 @@
+#ifndef GROWTHANALYZER_H
+#define GROWTHANALYZER_H
+
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "MemorySnapshot.h"
+#include "ProcessCache.h"
+
+// Streaming RSS growth estimate for every process, updated once per sample
+// in O(1) per process:
+//
+//  - a least-squares slope over the last `window` samples, kept as running
+//    sums (x is the sample time relative to the newest sample, so shifting
+//    the window is one multiply-add per process), and
+//  - an EWMA of the sample-to-sample slope, for "still growing right now".
+//
+// A process is flagged once its window is full, the regression slope is at
+// or above the threshold and the EWMA is positive; it stays flagged until
+// the slope drops below half the threshold.
+//
+// Not thread-safe; SystemMonitor runs it on the collector thread before
+// publishing each snapshot.
+class GrowthAnalyzer {
+public:
+    static constexpr uint32_t kDefaultWindow = 120;
+    static constexpr double kDefaultThreshold = 50.0 * 1024 * 1024 / 3600;  // 50 MB/h, in bytes/s
+
+    explicit GrowthAnalyzer(uint32_t window = kDefaultWindow, double threshold = kDefaultThreshold);
+
+    // Bytes per second; takes effect on the next update
+    void setThreshold(double bytesPerSecond) { m_threshold = bytesPerSecond; }
+    double threshold() const { return m_threshold; }
+
+    // Discards all state
+    void setWindow(uint32_t samples);
+    void clear();
+
+    // Fills rates (bytes/s per row of snapshot, 0 until two samples) and
+    // growing (rows currently flagged, fastest first)
+    void update(const MemorySnapshot& snapshot, std::vector<float>& rates, std::vector<uint32_t>& growing);
+
+private:
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+    struct State {
+        ProcessKey key;
+        uint64_t lastTick;
+        double sumY;      // KiB
+        double sumXY;     // s * KiB, x relative to the newest sample
+        float ewma;       // KiB/s
+        uint32_t lastValue;
+        uint32_t count;   // samples in the window
+        uint32_t head;    // next ring position
+        bool flagged;
+        bool used;
+    };
+
+    uint32_t m_window;
+    double m_threshold;
+
+    std::vector<State> m_states;
+    std::vector<uint32_t> m_values;  // m_window KiB values per state, a ring each
+    std::vector<uint32_t> m_freeSlots;
+    std::unordered_map<ProcessKey, uint32_t, ProcessKeyHash> m_slotByKey;
+    std::vector<uint32_t> m_rowSlots;  // slot of each row of the previous snapshot
+
+    // Sample times (ms) of the last m_window + 1 ticks, a ring indexed by tick
+    std::vector<uint64_t> m_times;
+    uint64_t m_tick;
+    double m_delta;  // seconds between the last two samples
+
+    // Sum of x and x^2 over the newest n samples, n = 0..m_window
+    std::vector<double> m_sumX;
+    std::vector<double> m_sumXX;
+
+    uint32_t slotFor(const ProcessKey& key);
+    void release(uint32_t slot);
+    double x(uint64_t tick) const;
+    void recompute(State& state, const uint32_t *ring) const;
+};
+
+#endif // GROWTHANALYZER_H
@@ -0,0 +1,170 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Latency histogram with HDR-style log-linear buckets: 16 linear
+// sub-buckets per power of two, so any recorded value is reported within
+// 1/16 (~6%) of itself from 1 ns up to hours, in a fixed 8 KB. Recording is
+// two relaxed atomic adds plus min/max updates that rarely write; reading
+// may run concurrently with recording and sees a slightly torn but usable
+// view.
+class LatencyHistogram {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t min = 0;   // ns
+        uint64_t max = 0;
+        uint64_t mean = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t ns);
+    void reset();
+
+    Summary summarize() const;
+
+private:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr uint64_t kSubBuckets = 1u << kSubBucketBits;
+    static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    static size_t bucketFor(uint64_t ns);
+    static uint64_t lowestValue(size_t bucket);
+
+    std::atomic<uint64_t> m_buckets[kBucketCount];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_min;
+    std::atomic<uint64_t> m_max;
+};
+
+// Process-wide timings of the collection and render pipeline phases plus
+// event counters, recorded through the MM_* macros below. Built with
+// MEMORYMONITOR_INSTRUMENTATION=0 the macros expand to nothing, so none of
+// this costs anything at the call sites.
+class Instrumentation {
+public:
+    enum Phase {
+        CollectPhase = 0,     // SystemMonitor::collectData, end to end
+        SystemMemoryPhase,
+        EnumeratePhase,       // listing pids
+        ReadPhase,            // parallel per-pid reads
+        ApplyPhase,           // merging reads into the process cache
+        PublishPhase,         // filling and publishing the snapshot, growth and accounting included
+        GrowthPhase,
+        AccountingPhase,      // PSS / USS reads within their budget
+        AlertPhase,
+        HistoryPhase,
+        RollupPhase,
+        SortPhase,            // snapshot top-K / full order
+        TableUpdatePhase,     // ProcessTableModel::setSnapshot, proxy re-sort included
+        CumulativePhase,      // Cumulative % prefix sum
+        PhaseCount
+    };
+
+    enum Counter {
+        PidsScanned = 0,
+        PidsVanished,         // exited between listing and reading
+        PidsFailed,           // unreadable or unparsable
+        BytesRead,
+        Allocations,          // on the collector and UI threads, see threadAllocations()
+        RowsTouched,          // table rows removed, changed or inserted
+        FullScans,            // refreshes that listed every pid (see ProcessEventSource)
+        LifecycleEvents,      // process start / exit notifications received
+        ShortLivedProcesses,  // started and exited between two refreshes
+        Syscalls,             // file system calls made by the scan workers
+        StringsDropped,       // names and paths blanked because the StringPool was full
+        StringCompactions,    // StringPool rebuilds from the live ids
+        CounterCount
+    };
+
+    static Instrumentation& instance();
+
+    static constexpr bool enabled() {
+#if MEMORYMONITOR_INSTRUMENTATION
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static const char *phaseName(Phase phase);
+    static const char *counterName(Counter counter);
+
+    void record(Phase phase, uint64_t ns) { m_phases[phase].record(ns); }
+    void add(Counter counter, uint64_t amount) {
+        m_counters[counter].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    const LatencyHistogram& histogram(Phase phase) const { return m_phases[phase]; }
+    uint64_t counter(Counter counter) const {
+        return m_counters[counter].load(std::memory_order_relaxed);
+    }
+
+    void reset();
+
+    // Plain-text table of every phase and counter, for logs and the
+    // headless output
+    std::string report() const;
+
+    // Heap allocations made so far by the calling thread. Counted only in
+    // executables that link src/AllocationCounter.cpp (the app and the
+    // headless collector); 0 elsewhere.
+    static uint64_t threadAllocations() { return t_allocations; }
+    static void countAllocation() { ++t_allocations; }
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Phase phase)
+            : m_phase(phase), m_start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            auto elapsed = std::chrono::steady_clock::now() - m_start;
+            Instrumentation::instance().record(m_phase, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Phase m_phase;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+private:
+    Instrumentation();
+
+    LatencyHistogram m_phases[PhaseCount];
+    std::atomic<uint64_t> m_counters[CounterCount];
+
+    static thread_local uint64_t t_allocations;
+};
+
+#if MEMORYMONITOR_INSTRUMENTATION
+#define MM_CONCAT_IMPL(a, b) a##b
+#define MM_CONCAT(a, b) MM_CONCAT_IMPL(a, b)
+// Times the rest of the enclosing scope as phase, an Instrumentation::Phase
+// name such as ReadPhase
+#define MM_TIME_SCOPE(phase) \
+    Instrumentation::ScopedTimer MM_CONCAT(mmScopedTimer, __LINE__)(Instrumentation::phase)
+// Adds amount to counter, an Instrumentation::Counter name; amount is not
+// evaluated when instrumentation is compiled out
+#define MM_COUNT(counter, amount) Instrumentation::instance().add(Instrumentation::counter, (amount))
+// Statement only compiled with instrumentation, e.g. bookkeeping for MM_COUNT
+#define MM_INSTRUMENT(...) __VA_ARGS__
+#else
+#define MM_TIME_SCOPE(phase) do {} while (0)
+#define MM_COUNT(counter, amount) do {} while (0)
+#define MM_INSTRUMENT(...)
+#endif
+
+#endif // INSTRUMENTATION_H
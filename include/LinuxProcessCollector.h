@@ -0,0 +1,68 @@
+#ifndef LINUXPROCESSCOLLECTOR_H
+#define LINUXPROCESSCOLLECTOR_H
+
+#include "ProcessCollector.h"
+#include <limits.h>
+#include <memory>
+#include <vector>
+
+class IoUringReader;
+
+// /proc backend. Enumerates with getdents64 on a long-lived /proc dirfd and
+// reads per-pid files with openat() into fixed member buffers, so a steady
+// state scan does not touch the heap.
+//
+// collectCountersBatch reads the stat files through an IoUringReader, one
+// io_uring_enter per 256 files instead of three syscalls each. Where
+// io_uring is unavailable (old kernel, sysctl, seccomp) it loops over
+// collectCounters instead.
+//
+// procRoot may point at any procfs-shaped tree (see tools/ProcFixture.cpp);
+// everything, including total RAM, is then read from there.
+class LinuxProcessCollector : public ProcessCollector {
+public:
+    explicit LinuxProcessCollector(const std::string& procRoot = "/proc");
+    ~LinuxProcessCollector() override;
+
+    LinuxProcessCollector(const LinuxProcessCollector&) = delete;
+    LinuxProcessCollector& operator=(const LinuxProcessCollector&) = delete;
+
+    uint64_t queryTotalPhysicalRAM() override;
+    bool collectSystemMemoryInfo(SystemMemoryInfo& info) override;
+    bool collectMemoryPressure(PressureStats& stats) override;
+    std::string queryBootId() override;
+    bool listProcesses(std::vector<pid_t>& pids) override;
+    bool collectProcess(pid_t pid, ProcessInfo& info) override;
+    bool collectCounters(pid_t pid, ProcessCounters& counters) override;
+    void collectCountersBatch(const pid_t *pids, size_t count,
+                              ProcessCounters *counters, bool *ok) override;
+    bool collectAccounting(pid_t pid, ProcessAccounting& accounting) override;
+    bool collectMappings(pid_t pid, SmapsParser& parser) override;
+
+private:
+    int m_procFd;
+    int m_meminfoFd;
+    int m_pressureFd;  // -1 without PSI (kernel option or psi=0)
+    uint64_t m_pageSize;
+
+    char m_direntBuffer[32768];
+    char m_readBuffer[4096];
+    char m_pathBuffer[PATH_MAX];
+    std::vector<char> m_mappingBuffer;  // sized on first collectMappings
+
+    bool m_uringTried = false;
+    std::unique_ptr<IoUringReader> m_uring;  // created on the first batch
+    std::vector<char> m_statNames;           // "<pid>/stat" per ring slot
+
+    // Reads name relative to dirFd into m_readBuffer (NUL terminated)
+    ssize_t readFileAt(int dirFd, const char *name);
+
+    // Files as vanished or failed in m_readStats by errno
+    void countFailure(int error);
+
+    // Extracts comm, start time and memory from a stat line in buffer
+    bool parseStat(const char *buffer, ssize_t length, ProcessCounters& counters,
+                   const char *&comm, size_t& commLength);
+};
+
+#endif // LINUXPROCESSCOLLECTOR_H
@@ -0,0 +1,22 @@
+#ifndef MACPROCESSCOLLECTOR_H
+#define MACPROCESSCOLLECTOR_H
+
+#include "ProcessCollector.h"
+
+// libproc / Mach host statistics backend
+class MacProcessCollector : public ProcessCollector {
+public:
+    MacProcessCollector() = default;
+
+    uint64_t queryTotalPhysicalRAM() override;
+    bool collectSystemMemoryInfo(SystemMemoryInfo& info) override;
+    bool listProcesses(std::vector<pid_t>& pids) override;
+    bool collectProcess(pid_t pid, ProcessInfo& info) override;
+    bool collectCounters(pid_t pid, ProcessCounters& counters) override;
+
+private:
+    // A failed proc_pidinfo as vanished (ESRCH) or failed in m_readStats
+    void countFailure();
+};
+
+#endif // MACPROCESSCOLLECTOR_H
@@ -2,13 +2,23 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QTableWidget>
-#include <QTimer>
+#include <QTableView>
 #include <QThread>
+#include <QMap>
 #include <QtCharts/QChartView>
 #include <QtCharts/QPieSeries>
 #include <memory>
 #include "SystemMonitor.h"
+#include "ProcessTableModel.h"
+#include "ProcessSortModel.h"
+#include "ReplaySource.h"
+#include "MappingMonitor.h"
+
+class QDialog;
+class QLabel;
+class QPushButton;
+class QSlider;
+class QTableWidget;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -19,31 +29,85 @@ public:
 
 private slots:
     void updateUI();
-    void onTableRowClicked(int row, int column);
+    void onTableContextMenu(const QPoint& position);
+    void onTableRowDoubleClicked(const QModelIndex& index);
     void onPieSliceClicked(QPieSlice *slice);
     void onRefreshIntervalChanged(int seconds);
+    void onRefreshIntervalAdjusted(int ms);
+    void onCpuBudgetChanged(double percent);
+    void onAdaptiveRefreshToggled(bool checked);
     void onChartProcessCountChanged(int count);
+    void onGrowthThresholdChanged(int megabytesPerHour);
     void onManualRefresh();
     void onPauseResume();
     void handleError(const QString& error);
-    void recalculateCumulativePercentage();
     void onPurgeMemory();
     void onAlwaysOnTopChanged(bool checked);
     void onAutoRefreshToggled(bool checked);
+    void onRecordingToggled(bool checked);
+    void onOpenRecording();
+    void onReturnToLive();
+    void onReplayData();
+    void onReplayPositionChanged(int index, int count);
+    void onAlertChanged(const QString& rule, bool active, const QString& message);
+    void onPressureStall(const QString& source, const QString& message);
+    void onEditAlertRules();
+    void onShowDiagnostics();
+    void onAccountingToggled(bool checked);
+    void onAccountingBudget();
+    void onMappingSampleReady();
+    void onMappingUnavailable(pid_t pid, const QString& reason);
 
 private:
     // UI Components
-    QTableWidget *m_processTable;
+    QTableView *m_processTable;
+    ProcessTableModel *m_processModel;
+    ProcessSortModel *m_sortModel;
     QChartView *m_chartView;
     QPieSeries *m_pieSeries;
-    QTimer *m_refreshTimer;
 
     // System monitoring
     SystemMonitor *m_monitor;
     QThread *m_workerThread;
+    SnapshotPtr m_snapshot;  // sample currently on screen
+
+    // Recording playback; while set, live samples are not shown
+    ReplaySource *m_replay;
+    QWidget *m_replayControls;
+    QSlider *m_replaySlider;
+    QLabel *m_replayLabel;
+    QPushButton *m_replayPlayButton;
+    QAction *m_recordAction;
+
+    // Raised alert rules and their messages, shown in the status bar
+    QLabel *m_alertLabel;
+    QMap<QString, QString> m_activeAlerts;
+    QString m_alertRulesPath;
+
+    // Memory stalls are shown with the alerts until this fires
+    QTimer *m_stallTimer;
+
+    // Pipeline timings and counters (see Instrumentation), refreshed with
+    // every sample while open
+    QDialog *m_diagnosticsDialog;
+    QTableWidget *m_phaseTable;
+    QTableWidget *m_counterTable;
+
+    // Per-mapping breakdown of the process picked from the table's context
+    // menu, re-read on its own thread while the dialog is open
+    QDialog *m_mappingDialog;
+    QLabel *m_mappingSummary;
+    QTableWidget *m_mappingTable;
+    MappingMonitor *m_mappingMonitor;
+    QThread *m_mappingThread;
+    pid_t m_mappingPid;
+    QString m_mappingProcessName;
 
     // State
-    int m_refreshInterval;  // in seconds
+    int m_refreshInterval;  // in seconds, as set by the user
+    int m_effectiveIntervalMs;  // what the monitor's scheduler is using; 0 = off
+    double m_cpuBudget;  // percent of one core
+    int m_accountingBudgetMs;  // time per sample for PSS/USS reads
     int m_chartProcessCount;  // number of processes to show in chart
     bool m_isPaused;
 
@@ -54,8 +118,10 @@ private:
     void setupControls();
     void setupMenuBar();
     void setupStatusBar();
+    void setupReplayControls();
 
     // UI Updates
+    void showSnapshot(SnapshotPtr snapshot);
     void updateTable();
     void updateChart();
     void updateStatusBar();
@@ -63,8 +129,13 @@ private:
     void highlightTableRow(const QString& processName);
     void highlightChartSlice(const QString& processName);
     void showOthersBreakdown();
+    void showProcessHistory(const ProcessRef& process);
+    void showMappingBreakdown(const ProcessRef& process);
+    void updateAlertLabel();
+    void updateDiagnostics();
 
     // Helper methods
+    void applyRefreshSchedule();
     QString formatMemorySize(uint64_t bytes) const;
     QString formatPercentage(double percentage) const;
 };
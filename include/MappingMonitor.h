@@ -0,0 +1,72 @@
+#ifndef MAPPINGMONITOR_H
+#define MAPPINGMONITOR_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+#include "ProcessCollector.h"
+#include "SmapsParser.h"
+
+// One parse of a process's smaps
+struct MappingSample {
+    pid_t pid = 0;
+    uint64_t startTime = 0;
+    uint64_t timestampMs = 0;  // wall clock, ms since the Unix epoch
+    uint64_t readUs = 0;       // reading and parsing, together
+    uint64_t bytesRead = 0;
+    MappingBreakdown breakdown;
+};
+
+using MappingSamplePtr = std::shared_ptr<const MappingSample>;
+
+// Re-reads one process's per-mapping breakdown while it is being looked
+// at. Runs on its own thread, like SystemMonitor, so a process with 100k
+// mappings never blocks the GUI or delays the regular samples; results
+// are published the same way (atomic pointer, then a signal).
+//
+// The process is re-read every kMinIntervalMs, or ten times as long as the
+// last read took if that is longer, so watching a huge process stays under
+// ~10% of a core.
+class MappingMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr uint64_t kMinIntervalMs = 1000;
+
+    explicit MappingMonitor(QObject *parent = nullptr);
+    ~MappingMonitor();
+
+    // Latest breakdown; safe from any thread. Null until the first read.
+    MappingSamplePtr sample() const { return std::atomic_load(&m_published); }
+
+public slots:
+    // Reads pid now and keeps re-reading it until stop() or until it exits.
+    // startTime guards against a recycled pid.
+    void watch(pid_t pid, uint64_t startTime);
+    void stop();
+
+signals:
+    void sampleReady();
+
+    // pid exited or its smaps can't be read (another user's process, a
+    // kernel thread); watching stops
+    void unavailable(pid_t pid, const QString& reason);
+
+private:
+    std::unique_ptr<ProcessCollector> m_collector;
+    SmapsParser m_parser;
+    QTimer *m_timer;
+    pid_t m_pid;
+    uint64_t m_startTime;
+
+    MappingSamplePtr m_published;
+    std::vector<std::shared_ptr<MappingSample>> m_samplePool;
+
+    void readMappings();
+};
+
+#endif // MAPPINGMONITOR_H
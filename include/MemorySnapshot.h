@@ -0,0 +1,271 @@
+#ifndef MEMORYSNAPSHOT_H
+#define MEMORYSNAPSHOT_H
+
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include "ProcessCache.h"
+#include "ProcessCollector.h"
+#include "StringPool.h"
+
+class ProcessRef;
+class ProcessView;
+
+// One complete sample produced by SystemMonitor::collectData. Once published
+// a snapshot is never modified, so any thread holding a SnapshotPtr can read
+// it without locking while the collector builds the next one.
+//
+// Processes are stored column-wise (one dense array per field) so passes
+// such as sums, sorts and percentages only touch the column they need.
+// Names and paths are ids into a StringPool shared by all snapshots.
+class MemorySnapshot {
+public:
+    MemorySnapshot() = default;
+
+    // Increments with every published sample
+    uint64_t getSequence() const { return m_sequence; }
+
+    // Wall-clock time the sample was taken, ms since the Unix epoch
+    uint64_t getTimestampMs() const { return m_timestampMs; }
+
+    // System memory statistics
+    uint64_t getTotalPhysicalRAM() const { return m_totalPhysicalRAM; }
+    uint64_t getFreeMemory() const { return m_memory.freeMemory; }
+    uint64_t getActiveMemory() const { return m_memory.activeMemory; }
+    uint64_t getInactiveMemory() const { return m_memory.inactiveMemory; }
+    uint64_t getWiredMemory() const { return m_memory.wiredMemory; }
+    uint64_t getUsedMemory() const;
+
+    // Process columns, in no particular order; all have getProcessCount() entries
+    size_t getProcessCount() const { return m_pids.size(); }
+    const std::vector<pid_t>& getPids() const { return m_pids; }
+    const std::vector<uint64_t>& getStartTimes() const { return m_startTimes; }
+    const std::vector<uint64_t>& getResidentSizes() const { return m_residentSizes; }
+    const std::vector<uint64_t>& getVirtualSizes() const { return m_virtualSizes; }
+    const std::vector<uint32_t>& getNameIds() const { return m_nameIds; }
+    const std::vector<uint32_t>& getPathIds() const { return m_pathIds; }
+    const StringPool& getStrings() const { return *m_strings; }
+    const std::shared_ptr<const StringPool>& getStringPool() const { return m_strings; }
+
+    // Sum of the resident size column
+    uint64_t getTotalResidentSize() const;
+
+    // Row accessor for code that wants one process at a time
+    ProcessRef process(size_t index) const;
+
+    // Largest count processes by resident size, descending. Selected with
+    // nth_element over a compact (size, index) array unless the full order
+    // has already been computed for this snapshot.
+    ProcessView getTopProcessesByMemory(size_t count) const;
+
+    // Every process by resident size, descending; sorted on first use and
+    // then shared by all callers of this snapshot
+    ProcessView getProcessesByMemory() const;
+
+    // RSS growth in bytes/s per row (see GrowthAnalyzer), and the rows whose
+    // growth is flagged as sustained, fastest first. Empty for samples that
+    // were not analyzed (replays, synthetic samples).
+    const std::vector<float>& getGrowthRates() const { return m_growthRates; }
+    const std::vector<uint32_t>& getGrowingProcesses() const { return m_growing; }
+
+    // PSS / USS / swap per row and the wall-clock time each was read (see
+    // AccountingSampler); 0 where not read yet. Empty unless accounting is
+    // enabled on the monitor.
+    bool hasAccounting() const { return !m_accountedAtMs.empty(); }
+    const std::vector<uint64_t>& getProportionalSizes() const { return m_proportionalSizes; }
+    const std::vector<uint64_t>& getUniqueSizes() const { return m_uniqueSizes; }
+    const std::vector<uint64_t>& getSwapSizes() const { return m_swapSizes; }
+    const std::vector<uint64_t>& getAccountedTimes() const { return m_accountedAtMs; }
+
+    // Processes that started / exited since the previous sample
+    const std::vector<ProcessKey>& getAddedProcesses() const { return m_added; }
+    const std::vector<ProcessKey>& getRemovedProcesses() const { return m_removed; }
+
+    // Processes that started and exited since the previous sample, too
+    // briefly to be read; 0 unless the netlink event source is in use
+    uint64_t getShortLivedProcessCount() const { return m_shortLivedCount; }
+
+    // System-wide memory pressure (PSI) when the sample was taken, where
+    // the kernel provides it
+    bool hasMemoryPressure() const { return m_hasPressure; }
+    const PressureStats& getMemoryPressure() const { return m_pressure; }
+
+    // Pressure triggers that fired since the previous sample (see
+    // SystemMonitor::setPressureTrigger); nonzero marks a sample taken
+    // out of schedule because of a stall
+    uint64_t getPressureStallCount() const { return m_pressureStalls; }
+
+    // Provisional sample published while the first scan is still running:
+    // only the pids read so far, no growth rates. getPendingProcessCount()
+    // pids are still to be read.
+    bool isPartial() const { return m_pendingCount > 0; }
+    size_t getPendingProcessCount() const { return m_pendingCount; }
+
+    // Filling, before the snapshot is published. Used by SystemMonitor and
+    // by tools that build synthetic samples. Columns reuse their capacity.
+    void assignSystemMemory(uint64_t sequence, uint64_t timestampMs,
+                            uint64_t totalPhysicalRAM, const SystemMemoryInfo& memory);
+    void assignProcesses(const std::vector<ProcessRecord>& records,
+                         std::shared_ptr<const StringPool> strings);
+
+private:
+    friend class SystemMonitor;
+
+    uint64_t m_sequence = 0;
+    uint64_t m_timestampMs = 0;
+    uint64_t m_totalPhysicalRAM = 0;
+    SystemMemoryInfo m_memory;
+
+    std::vector<pid_t> m_pids;
+    std::vector<uint64_t> m_startTimes;
+    std::vector<uint64_t> m_residentSizes;
+    std::vector<uint64_t> m_virtualSizes;
+    std::vector<uint32_t> m_nameIds;
+    std::vector<uint32_t> m_pathIds;
+    std::shared_ptr<const StringPool> m_strings;
+
+    std::vector<float> m_growthRates;
+    std::vector<uint32_t> m_growing;
+
+    std::vector<uint64_t> m_proportionalSizes;
+    std::vector<uint64_t> m_uniqueSizes;
+    std::vector<uint64_t> m_swapSizes;
+    std::vector<uint64_t> m_accountedAtMs;
+
+    std::vector<ProcessKey> m_added;
+    std::vector<ProcessKey> m_removed;
+    uint64_t m_shortLivedCount = 0;
+    bool m_hasPressure = false;
+    PressureStats m_pressure;
+    uint64_t m_pressureStalls = 0;
+    size_t m_pendingCount = 0;
+
+    // Lazily computed full order; the only state that changes after publishing
+    mutable std::mutex m_orderMutex;
+    mutable std::vector<uint32_t> m_order;
+    mutable bool m_orderValid = false;
+};
+
+using SnapshotPtr = std::shared_ptr<const MemorySnapshot>;
+
+// One process of a MemorySnapshot, read through its columns
+class ProcessRef {
+public:
+    ProcessRef(const MemorySnapshot *snapshot, size_t index)
+        : m_snapshot(snapshot), m_index(index) {}
+
+    size_t index() const { return m_index; }
+    pid_t getPid() const { return m_snapshot->getPids()[m_index]; }
+    uint64_t getStartTime() const { return m_snapshot->getStartTimes()[m_index]; }
+    uint64_t getResidentSize() const { return m_snapshot->getResidentSizes()[m_index]; }
+    uint64_t getVirtualSize() const { return m_snapshot->getVirtualSizes()[m_index]; }
+    double getGrowthRate() const {
+        const auto& rates = m_snapshot->getGrowthRates();
+        return m_index < rates.size() ? rates[m_index] : 0.0;
+    }
+    // 0 when the snapshot has no accounting or this process was not read yet
+    uint64_t getAccountedTimeMs() const {
+        const auto& times = m_snapshot->getAccountedTimes();
+        return m_index < times.size() ? times[m_index] : 0;
+    }
+    uint64_t getProportionalSize() const {
+        return getAccountedTimeMs() ? m_snapshot->getProportionalSizes()[m_index] : 0;
+    }
+    uint64_t getUniqueSize() const {
+        return getAccountedTimeMs() ? m_snapshot->getUniqueSizes()[m_index] : 0;
+    }
+    uint64_t getSwapSize() const {
+        return getAccountedTimeMs() ? m_snapshot->getSwapSizes()[m_index] : 0;
+    }
+    const std::string& getName() const {
+        return m_snapshot->getStrings().str(m_snapshot->getNameIds()[m_index]);
+    }
+    const std::string& getPath() const {
+        return m_snapshot->getStrings().str(m_snapshot->getPathIds()[m_index]);
+    }
+
+    double getMemoryPercentage(uint64_t totalPhysicalRAM) const {
+        if (totalPhysicalRAM == 0) {
+            return 0.0;
+        }
+        return (static_cast<double>(getResidentSize()) / static_cast<double>(totalPhysicalRAM)) * 100.0;
+    }
+
+private:
+    const MemorySnapshot *m_snapshot;
+    size_t m_index;
+};
+
+inline ProcessRef MemorySnapshot::process(size_t index) const {
+    return ProcessRef(this, index);
+}
+
+// Non-owning, ordered selection of the processes in a MemorySnapshot.
+// Only valid while the caller keeps the snapshot's SnapshotPtr alive.
+class ProcessView {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ProcessRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = ProcessRef;
+
+        const_iterator(const MemorySnapshot *snapshot, const uint32_t *index)
+            : m_snapshot(snapshot), m_index(index) {}
+
+        ProcessRef operator*() const { return ProcessRef(m_snapshot, *m_index); }
+        const_iterator& operator++() { ++m_index; return *this; }
+        bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+    private:
+        const MemorySnapshot *m_snapshot;
+        const uint32_t *m_index;
+    };
+
+    ProcessView() = default;
+    ProcessView(ProcessView&&) = default;
+    ProcessView& operator=(ProcessView&&) = default;
+
+    // Copies would have to re-point m_indices into their own m_owned
+    ProcessView(const ProcessView&) = delete;
+    ProcessView& operator=(const ProcessView&) = delete;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    ProcessRef operator[](size_t i) const { return ProcessRef(m_snapshot, m_indices[i]); }
+
+    // Position of the i-th entry in the snapshot's columns
+    uint32_t indexAt(size_t i) const { return m_indices[i]; }
+
+    const_iterator begin() const { return const_iterator(m_snapshot, m_indices); }
+    const_iterator end() const { return const_iterator(m_snapshot, m_indices + m_size); }
+
+private:
+    friend class MemorySnapshot;
+
+    // Borrows indices owned by the snapshot
+    ProcessView(const MemorySnapshot *snapshot, const uint32_t *indices, size_t size)
+        : m_snapshot(snapshot), m_indices(indices), m_size(size) {}
+
+    // Owns its indices (moving a vector keeps its buffer, so m_indices stays valid)
+    ProcessView(const MemorySnapshot *snapshot, std::vector<uint32_t>&& indices)
+        : m_snapshot(snapshot), m_owned(std::move(indices)) {
+        m_indices = m_owned.data();
+        m_size = m_owned.size();
+    }
+
+    const MemorySnapshot *m_snapshot = nullptr;
+    const uint32_t *m_indices = nullptr;
+    size_t m_size = 0;
+    std::vector<uint32_t> m_owned;
+};
+
+#endif // MEMORYSNAPSHOT_H
@@ -0,0 +1,37 @@
+#ifndef METRICSFORMATTER_H
+#define METRICSFORMATTER_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "MemorySnapshot.h"
+
+// Renders a snapshot in the Prometheus text exposition format (0.0.4):
+// the system counters as memorymonitor_memory_*_bytes gauges plus resident
+// and virtual size of the topCount largest processes, labelled by pid and
+// name. Output goes into a caller-owned string that is cleared but keeps
+// its capacity, and the top-N selection reuses its own scratch array, so
+// rendering allocates nothing once the buffers have grown to size.
+class MetricsFormatter {
+public:
+    explicit MetricsFormatter(size_t topCount = 20);
+
+    void setTopCount(size_t topCount) { m_topCount = topCount; }
+    size_t topCount() const { return m_topCount; }
+
+    void render(const MemorySnapshot& snapshot, std::string& out);
+
+    static constexpr const char *kContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+private:
+    size_t m_topCount;
+    std::vector<std::pair<uint64_t, uint32_t>> m_top;  // (resident size, row)
+
+    static void appendGauge(std::string& out, const char *name, const char *help, uint64_t value);
+    static void appendNumber(std::string& out, uint64_t value);
+    static void appendLabelValue(std::string& out, const std::string& value);
+};
+
+#endif // METRICSFORMATTER_H
@@ -0,0 +1,111 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <poll.h>
+#include "MemorySnapshot.h"
+#include "MetricsFormatter.h"
+
+// Prometheus scrape endpoint: answers "GET /metrics" over HTTP/1.1 on a TCP
+// port and/or a Unix socket, from its own thread.
+//
+// The server only ever reads the latest published snapshot through source,
+// so scrapes never wait for or hold up the collector. The exposition text
+// is rendered once per new sample into one of a few reused body buffers;
+// every scrape of the same sample writes that buffer as is. A buffer is
+// re-rendered only once no connection is still sending it, so a slow
+// client delays nothing but its own response. Connections are
+// non-blocking, keep-alive and multiplexed with poll(), with fixed request
+// and header buffers, so steady-state scrapes allocate nothing.
+class MetricsServer {
+public:
+    using SnapshotSource = std::function<SnapshotPtr()>;
+
+    explicit MetricsServer(SnapshotSource source, size_t topCount = 20);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Call before start(). Port 0 picks a free port, see tcpPort().
+    bool listenTcp(const std::string& host, uint16_t port, std::string& error);
+    // Replaces a stale socket file at path; removed again by stop()
+    bool listenUnix(const std::string& path, std::string& error);
+
+    bool start(std::string& error);
+    void stop();
+
+    uint16_t tcpPort() const { return m_tcpPort; }
+    uint64_t scrapeCount() const { return m_scrapes.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kMaxConnections = 128;
+    static constexpr size_t kRequestBufferSize = 2048;
+    static constexpr size_t kBodyCount = 4;
+    static constexpr uint64_t kIdleTimeoutMs = 60 * 1000;
+
+    struct Connection {
+        int fd = -1;
+        uint64_t lastActivityMs = 0;
+
+        char request[kRequestBufferSize];
+        size_t requestLength = 0;
+        size_t requestEnd = 0;  // bytes of request taken by the one being answered
+
+        // Response being sent: header, then either a body buffer or a
+        // static error text
+        char header[256];
+        size_t headerLength = 0;
+        int body = -1;
+        const char *errorBody = nullptr;
+        size_t bodyLength = 0;
+        size_t sent = 0;
+        bool writing = false;
+        bool closeAfter = false;
+    };
+
+    struct Body {
+        std::string text;
+        uint64_t sequence = 0;
+        bool valid = false;
+        uint32_t users = 0;  // connections still sending it
+    };
+
+    SnapshotSource m_source;
+    MetricsFormatter m_formatter;
+
+    int m_tcpFd;
+    int m_unixFd;
+    uint16_t m_tcpPort;
+    std::string m_unixPath;
+    int m_wakePipe[2];
+
+    std::vector<Connection> m_connections;  // fixed kMaxConnections slots
+    std::vector<pollfd> m_pollFds;
+    std::vector<int> m_pollSlots;           // connection slot per m_pollFds entry, -1 otherwise
+    Body m_bodies[kBodyCount];
+    int m_currentBody;
+
+    std::thread m_thread;
+    std::atomic<bool> m_stopping;
+    std::atomic<uint64_t> m_scrapes;
+
+    void run();
+    void acceptAll(int listenFd);
+    void readRequest(Connection& connection, uint64_t nowMs);
+    void respond(Connection& connection);
+    void setError(Connection& connection, int status, const char *reason, const char *text);
+    bool sendPending(Connection& connection);
+    void finishResponse(Connection& connection);
+    void closeConnection(Connection& connection);
+    int acquireBody();
+    void closeListeners();
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,78 @@
+#ifndef PRESSUREMONITOR_H
+#define PRESSUREMONITOR_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "ProcessCollector.h"
+
+// A PSI trigger fired
+struct PressureEvent {
+    const std::string& source;   // "system" or the cgroup directory
+    const PressureStats& stats;  // read right after the wake-up
+    uint64_t timestampMs;        // wall clock
+};
+
+// Kernel-triggered memory stall notifications (Linux PSI, 5.2+), from its
+// own thread. Each watched pressure file gets a "some <stall> <window>"
+// trigger; the kernel then wakes the thread's poll() with POLLPRI as soon
+// as tasks have been stalled on memory for that long within one window,
+// at most once per window. Nothing is sampled in between, so short stalls
+// are seen within milliseconds at no polling cost.
+//
+// Without CAP_SYS_RESOURCE (Linux 6.5+ allows unprivileged triggers) the
+// window must be a multiple of 2 s; watch() rounds it up and retries. Such
+// triggers are checked by the kernel's 2 s averaging work rather than its
+// polling thread, so they fire up to 2 s after the stall.
+class PressureMonitor {
+public:
+    using Handler = std::function<void(const PressureEvent& event)>;
+
+    // handler runs on the monitor's thread
+    explicit PressureMonitor(Handler handler);
+    ~PressureMonitor();
+
+    PressureMonitor(const PressureMonitor&) = delete;
+    PressureMonitor& operator=(const PressureMonitor&) = delete;
+
+    // Call before start(). path is /proc/pressure/memory or a cgroup v2
+    // memory.pressure file; source names it in events.
+    bool watch(const std::string& source, const std::string& path,
+               uint64_t stallUs, uint64_t windowUs, std::string& error);
+
+    bool start(std::string& error);
+    void stop();
+
+    size_t watchCount() const { return m_watches.size(); }
+
+    // Window in effect for the last successful watch(), after rounding
+    uint64_t windowUs() const { return m_windowUs; }
+
+    uint64_t eventCount() const { return m_events.load(std::memory_order_relaxed); }
+
+    // Parses the "some ..." / "full ..." lines of a pressure file
+    static bool parseStats(const char *text, size_t length, PressureStats& stats);
+
+private:
+    struct Watch {
+        std::string source;
+        int fd;
+    };
+
+    Handler m_handler;
+    std::vector<Watch> m_watches;
+    uint64_t m_windowUs;
+    int m_wakePipe[2];
+
+    std::thread m_thread;
+    std::atomic<bool> m_stopping;
+    std::atomic<uint64_t> m_events;
+
+    void run();
+};
+
+#endif // PRESSUREMONITOR_H
@@ -0,0 +1,155 @@
+#ifndef PROCESSCACHE_H
+#define PROCESSCACHE_H
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+#include "ProcessEventSource.h"
+#include "ProcessInfo.h"
+#include "StringPool.h"
+
+class ProcessCollector;
+class ProcessScanPool;
+
+// A live process: pid alone is not enough because pids get reused
+struct ProcessKey {
+    pid_t pid;
+    uint64_t startTime;
+
+    bool operator==(const ProcessKey& other) const {
+        return pid == other.pid && startTime == other.startTime;
+    }
+};
+
+struct ProcessKeyHash {
+    size_t operator()(const ProcessKey& key) const {
+        return std::hash<uint64_t>()(key.startTime * 0x9e3779b97f4a7c15ull ^ static_cast<uint64_t>(key.pid));
+    }
+};
+
+// Compact cached process; name and path are ids into the cache's StringPool
+struct ProcessRecord {
+    pid_t pid;
+    uint32_t nameId;
+    uint32_t pathId;
+    uint64_t startTime;
+    uint64_t residentSize;
+    uint64_t virtualSize;
+};
+
+// Persistent process table. Name and path are read once when a process is
+// first seen; afterwards each refresh only re-reads the volatile counters.
+// Processes that appeared or exited since the previous refresh are reported
+// in added() / removed().
+//
+// A refresh reads every pid in parallel through a ProcessScanPool, each
+// worker writing only its own slots of m_scan, then applies the results
+// serially in pid order so the outcome does not depend on the worker count.
+//
+// With a ProcessEventSource the pid list is not re-read every refresh: the
+// cached pids plus reported starts, minus reported exits, are read instead.
+// The full list is read again whenever the events may be incomplete, after
+// a cancelled refresh, and at least every kReconcileMs.
+//
+// With batched reads each pool task re-reads up to kBatchedReadSize known
+// processes through ProcessCollector::collectCountersBatch (one io_uring
+// submission on Linux) instead of one collectCounters call per pid.
+//
+// The StringPool only grows, so names and paths of exited processes pile
+// up on hosts with churn. Once it holds kCompactMinStrings and at least
+// half of them are no longer used by any cached process, a complete
+// refresh rebuilds it from the live ids and strings() returns the new pool.
+// Snapshots keep the pool they were published with.
+class ProcessCache {
+public:
+    static constexpr uint64_t kReconcileMs = 60 * 1000;
+    static constexpr size_t kBatchedReadSize = 256;
+    static constexpr size_t kCompactMinStrings = 64 * 1024;
+
+    ProcessCache();
+    ~ProcessCache();
+
+    // Set before the first refresh; null goes back to listing every time
+    void setEventSource(std::unique_ptr<ProcessEventSource> events);
+    const char *eventSourceName() const { return m_events ? m_events->name() : "none"; }
+
+    void setBatchedReads(bool enabled) { m_batchedReads = enabled; }
+
+    // Called between batches of a progressive refresh with the number of
+    // pids read so far and the total; processes() then holds every process
+    // read so far. Returning false abandons the refresh.
+    using BatchCallback = std::function<bool(size_t scanned, size_t total)>;
+
+    // Re-scans the process list through pool and updates the cache. With
+    // onBatch the pids are read and applied in growing batches (256 up to
+    // 4096) and onBatch runs after each one but the last. Returns false if
+    // the process list could not be read or onBatch cancelled; a cancelled
+    // refresh leaves the cache usable and the next one completes it.
+    bool refresh(ProcessScanPool& pool, const BatchCallback& onBatch = nullptr);
+
+    const std::vector<ProcessRecord>& processes() const { return m_processes; }
+    const std::shared_ptr<StringPool>& strings() const { return m_strings; }
+    const std::vector<ProcessKey>& added() const { return m_added; }
+    const std::vector<ProcessKey>& removed() const { return m_removed; }
+
+    // Sum of |RSS change| over the last refresh, processes that started
+    // or exited counted in full
+    uint64_t residentChange() const { return m_residentChange; }
+
+    // Processes that started and exited between the last two refreshes,
+    // never read; only counted with the netlink event source
+    uint64_t shortLivedCount() const { return m_shortLived; }
+
+    // Names and paths dropped because the StringPool was full, ever
+    uint64_t droppedStrings() const { return m_droppedStrings; }
+
+    // StringPool rebuilds that freed dead names and paths, ever
+    uint64_t stringCompactions() const { return m_stringCompactions; }
+
+private:
+    std::vector<ProcessRecord> m_processes;
+    std::shared_ptr<StringPool> m_strings;
+    std::unordered_map<pid_t, size_t> m_indexByPid;  // pid -> m_processes index
+    std::vector<uint32_t> m_lastSeen;                // generation, parallel to m_processes
+    uint32_t m_generation = 0;
+
+    // Per-pid outcome of the parallel read phase
+    enum class ScanState : uint8_t { Vanished, Updated, New };
+    struct ScanResult {
+        ScanState state;
+        uint64_t residentSize;
+        uint64_t virtualSize;
+    };
+
+    std::vector<pid_t> m_pids;
+    std::vector<ScanResult> m_scan;      // parallel to m_pids
+    std::vector<ProcessInfo> m_newInfo;  // parallel to m_pids, used for New; strings reused
+    std::vector<ProcessKey> m_added;
+    std::vector<ProcessKey> m_removed;
+    uint64_t m_residentChange = 0;
+
+    std::unique_ptr<ProcessEventSource> m_events;
+    ProcessEvents m_pendingEvents;
+    std::vector<uint8_t> m_exited;  // scratch, parallel to m_processes
+    uint64_t m_lastListMs = 0;
+    bool m_needsList = true;
+    uint64_t m_shortLived = 0;
+    bool m_batchedReads = false;
+    uint64_t m_droppedStrings = 0;
+    uint64_t m_stringCompactions = 0;
+    std::vector<uint8_t> m_liveStrings;  // scratch for compactStrings, by string id
+
+    bool listPids(ProcessCollector& collector);
+    uint32_t intern(const std::string& value);
+    void compactStrings();
+    void scanProcess(ProcessCollector& collector, size_t item);
+    void scanBatch(ProcessCollector& collector, size_t begin, size_t end);
+    void applyRange(size_t begin, size_t end);
+    void addProcess(const ProcessInfo& info);
+    void removeAt(size_t index);
+};
+
+#endif // PROCESSCACHE_H
@@ -0,0 +1,142 @@
+#ifndef PROCESSCOLLECTOR_H
+#define PROCESSCOLLECTOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+
+class ProcessInfo;
+class SmapsParser;
+
+// System-wide memory counters in bytes
+struct SystemMemoryInfo {
+    uint64_t freeMemory = 0;
+    uint64_t activeMemory = 0;
+    uint64_t inactiveMemory = 0;
+    uint64_t wiredMemory = 0;
+};
+
+// Memory stall figures from a PSI pressure file: percentage of wall time
+// in which some (or all non-idle) tasks were stalled waiting for memory,
+// averaged over 10 s and 60 s, and the cumulative stall time
+struct PressureStats {
+    double someAvg10 = 0.0;
+    double someAvg60 = 0.0;
+    double fullAvg10 = 0.0;
+    double fullAvg60 = 0.0;
+    uint64_t someTotalUs = 0;
+    uint64_t fullTotalUs = 0;
+};
+
+// Values that change over a process's lifetime, plus the start time that
+// identifies the process together with its pid
+struct ProcessCounters {
+    uint64_t startTime = 0;
+    uint64_t residentSize = 0;
+    uint64_t virtualSize = 0;
+};
+
+// Memory a process is actually charged for, from Linux smaps_rollup:
+// proportional set size (shared pages split between their users), unique
+// set size (private pages only, freed if the process exits) and swap
+struct ProcessAccounting {
+    uint64_t proportionalSize = 0;
+    uint64_t uniqueSize = 0;
+    uint64_t swapSize = 0;
+};
+
+// What a collector has read since its stats were last taken, for
+// Instrumentation. Kept per collector so scan workers never share a counter.
+struct CollectorReadStats {
+    uint64_t bytesRead = 0;
+    uint64_t vanished = 0;  // process gone before or while it was read
+    uint64_t failed = 0;    // present but unreadable or unparsable
+    uint64_t syscalls = 0;  // file system calls made reading them
+};
+
+// Platform backend used by SystemMonitor and ProcessInfo to read from the OS.
+// Implementations keep their scratch buffers between calls, so an instance
+// must only be used from one thread at a time.
+class ProcessCollector {
+public:
+    virtual ~ProcessCollector() = default;
+
+    // Creates the backend for the platform we were built for
+    static std::unique_ptr<ProcessCollector> create();
+
+    // Root of the procfs tree read by collectors created afterwards (Linux
+    // only; ignored elsewhere). Defaults to $MEMORYMONITOR_PROC_ROOT, else
+    // "/proc". Set it before constructing SystemMonitor or a ProcessScanPool.
+    static void setProcRoot(const std::string& root);
+    static const std::string& procRoot();
+
+    virtual uint64_t queryTotalPhysicalRAM() = 0;
+    virtual bool collectSystemMemoryInfo(SystemMemoryInfo& info) = 0;
+
+    // System-wide memory pressure (Linux 4.20+ with PSI); false elsewhere
+    virtual bool collectMemoryPressure(PressureStats& stats) {
+        (void)stats;
+        return false;
+    }
+
+    // Identifies the current boot where start stamps count from boot and
+    // repeat after a reboot (Linux); empty where they are absolute
+    virtual std::string queryBootId() {
+        return std::string();
+    }
+
+    // Replaces the contents of pids, reusing its capacity
+    virtual bool listProcesses(std::vector<pid_t>& pids) = 0;
+
+    // Fills info for pid in place, reusing its string capacity.
+    // Returns false (and marks info invalid) if the process is gone.
+    virtual bool collectProcess(pid_t pid, ProcessInfo& info) = 0;
+
+    // Cheap re-read for a process whose name and path are already known
+    virtual bool collectCounters(pid_t pid, ProcessCounters& counters) = 0;
+
+    // collectCounters for count pids at once; ok[i] is its result. Backends
+    // with a batched I/O engine (io_uring on Linux) override this; the
+    // default simply loops.
+    virtual void collectCountersBatch(const pid_t *pids, size_t count,
+                                      ProcessCounters *counters, bool *ok) {
+        for (size_t i = 0; i < count; ++i) {
+            ok[i] = collectCounters(pids[i], counters[i]);
+        }
+    }
+
+    // PSS / USS / swap for pid. Expensive (the kernel walks the page
+    // tables), so see AccountingSampler. Backends without the data return
+    // false.
+    virtual bool collectAccounting(pid_t pid, ProcessAccounting& accounting) {
+        (void)pid;
+        (void)accounting;
+        return false;
+    }
+
+    // Streams pid's per-mapping smaps into parser (begin() already called;
+    // finish() is left to the caller). The kernel takes longer to generate
+    // the text than SmapsParser takes to parse it, ~100 ms for 65k mappings,
+    // so call it off the GUI thread (see MappingMonitor). Backends without
+    // smaps return false.
+    virtual bool collectMappings(pid_t pid, SmapsParser& parser) {
+        (void)pid;
+        (void)parser;
+        return false;
+    }
+
+    // Returns the read stats and starts counting from zero; only counted
+    // when built with MEMORYMONITOR_INSTRUMENTATION
+    CollectorReadStats takeReadStats() {
+        CollectorReadStats stats = m_readStats;
+        m_readStats = CollectorReadStats();
+        return stats;
+    }
+
+protected:
+    CollectorReadStats m_readStats;
+};
+
+#endif // PROCESSCOLLECTOR_H
@@ -0,0 +1,67 @@
+#ifndef PROCESSEVENTSOURCE_H
+#define PROCESSEVENTSOURCE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+
+// What happened to the process set since the previous poll
+struct ProcessEvents {
+    std::vector<pid_t> started;  // still running at poll time
+    std::vector<pid_t> exited;   // started before the previous poll
+    uint64_t shortLived = 0;     // started and exited in between; never read
+    uint64_t eventCount = 0;     // raw notifications received
+
+    // False when started may be missing processes (events were dropped, or
+    // the backend can't tell); the caller must then list every pid
+    bool complete = true;
+
+    void clear() {
+        started.clear();
+        exited.clear();
+        shortLived = 0;
+        eventCount = 0;
+        complete = true;
+    }
+};
+
+// Incremental process lifecycle notifications, so ProcessCache can follow
+// process starts and exits without listing /proc on every refresh. Linux
+// only; two backends, picked by create():
+//
+//   netlink  The proc connector (CAP_NET_ADMIN, initial pid namespace).
+//            Reports every fork and exit, including processes that live
+//            for less than one refresh.
+//   pidfd    Unprivileged fallback. Exits arrive through a pidfd per
+//            tracked process in an epoll set. Starts are found by probing
+//            the pids allocated since the last poll (from
+//            /proc/sys/kernel/ns_last_pid) with pidfd_open, which fails for
+//            threads and exited pids. The poll comes back incomplete when
+//            more pids were allocated than probing them is worth. Processes
+//            that exit before the probe are missed, as is a full wrap of
+//            the pid space between two polls.
+//
+// Not thread-safe; owned and polled by the collector thread.
+class ProcessEventSource {
+public:
+    virtual ~ProcessEventSource() = default;
+
+    // Best backend available for procRoot, or null: a fixture tree,
+    // another platform, or a kernel without either interface
+    static std::unique_ptr<ProcessEventSource> create(const std::string& procRoot);
+
+    virtual const char *name() const = 0;
+
+    // Replaces the contents of events with what arrived since the last
+    // poll; never blocks. The first poll is always incomplete.
+    virtual void poll(ProcessEvents& events) = 0;
+
+    // The caller's process set gained or lost pid (the pidfd backend
+    // watches exactly these; netlink ignores them)
+    virtual void track(pid_t pid) { (void)pid; }
+    virtual void untrack(pid_t pid) { (void)pid; }
+};
+
+#endif // PROCESSEVENTSOURCE_H
@@ -0,0 +1,131 @@
+#ifndef PROCESSHISTORY_H
+#define PROCESSHISTORY_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "MemorySnapshot.h"
+#include "ProcessCache.h"
+
+// RSS history of every process over the last N hours, at the sample rate,
+// within a fixed memory budget.
+//
+// Each process (pid + start time) has a chain of fixed 256-byte blocks. A
+// block holds its first value in full and then one token per change:
+// zigzag varint RSS delta in KiB, prefixed by the count of unchanged samples
+// when there were any. Samples that repeat the previous value cost nothing
+// until the next change, so idle processes take almost no space.
+//
+// Blocks are handed out in time order and recorded in one FIFO, so the
+// oldest block of the whole store is always the first block of its chain.
+// Eviction (budget full, or data older than the retention) pops that block
+// in O(1). A block that is still being appended to when it reaches the
+// retention edge is re-encoded from the first retained sample instead.
+//
+// append() is called from the collector thread; query() may be called from
+// any thread.
+class ProcessHistory {
+public:
+    struct Point {
+        uint64_t timestampMs;
+        uint64_t residentSize;
+    };
+
+    static constexpr size_t kDefaultMemoryBudget = size_t(64) << 20;
+    static constexpr uint64_t kDefaultRetentionMs = 24ull * 3600 * 1000;
+
+    explicit ProcessHistory(size_t memoryBudget = kDefaultMemoryBudget,
+                            uint64_t retentionMs = kDefaultRetentionMs);
+    ~ProcessHistory();
+
+    ProcessHistory(const ProcessHistory&) = delete;
+    ProcessHistory& operator=(const ProcessHistory&) = delete;
+
+    // Discards the stored history and applies the new limits
+    void setLimits(size_t memoryBudget, uint64_t retentionMs);
+    void clear();
+
+    // Records every process of snapshot as one sample
+    void append(const MemorySnapshot& snapshot);
+
+    // Points of key at or after sinceMs, oldest first; false when the
+    // process has no retained history
+    bool query(const ProcessKey& key, uint64_t sinceMs, std::vector<Point>& points) const;
+
+    // Bytes held: blocks, series index and sample timestamps
+    size_t memoryUsage() const;
+    size_t seriesCount() const;
+    size_t sampleCount() const;
+    uint64_t oldestTimestampMs() const;
+
+private:
+    static constexpr size_t kBlockSize = 256;
+    static constexpr uint32_t kBlocksPerChunk = 1024;
+    static constexpr uint32_t kNoBlock = UINT32_MAX;
+
+    struct Block {
+        uint64_t firstSample;  // global sample index of firstValue
+        uint64_t firstValue;   // KiB
+        uint32_t series;
+        uint32_t next;         // following block of the same series
+        uint32_t sampleCount;  // samples covered, including trailing repeats
+        uint16_t used;         // bytes of data in use
+        uint16_t reserved;
+        uint8_t data[kBlockSize - 32];
+    };
+    static_assert(sizeof(Block) == kBlockSize, "block layout");
+
+    struct Series {
+        ProcessKey key;
+        uint32_t firstBlock;
+        uint32_t lastBlock;
+        uint64_t lastSample;
+        uint64_t lastValue;  // KiB
+        uint32_t gap;        // unchanged samples since the last token
+    };
+
+    mutable std::mutex m_mutex;
+
+    size_t m_memoryBudget;
+    uint64_t m_retentionMs;
+
+    // Block arena, allocated a chunk at a time up to m_maxBlocks
+    std::vector<std::unique_ptr<Block[]>> m_chunks;
+    uint32_t m_maxBlocks;
+    uint32_t m_blockCount;
+    std::vector<uint32_t> m_freeBlocks;
+    std::deque<uint32_t> m_order;  // blocks in use, oldest first
+
+    std::vector<Series> m_series;
+    std::vector<uint32_t> m_freeSeries;
+    std::unordered_map<ProcessKey, uint32_t, ProcessKeyHash> m_seriesByKey;
+
+    // Timestamps of the retained samples; m_timestamps[0] is m_firstSample
+    std::deque<uint64_t> m_timestamps;
+    uint64_t m_firstSample;
+    uint64_t m_nextSample;
+
+    std::vector<std::pair<uint64_t, uint64_t>> m_scratch;  // (sample, value) for re-encoding
+
+    Block& block(uint32_t index) { return m_chunks[index / kBlocksPerChunk][index % kBlocksPerChunk]; }
+    const Block& block(uint32_t index) const { return m_chunks[index / kBlocksPerChunk][index % kBlocksPerChunk]; }
+
+    void record(Series& series, uint32_t seriesId, uint64_t sample, uint64_t value);
+    void startBlock(Series& series, uint32_t seriesId, uint64_t sample, uint64_t value);
+    uint32_t allocateBlock();
+    void evictOldestBlock();
+    void rebaseOldestBlock();
+    void expire();
+    void releaseSeries(uint32_t seriesId);
+    void reset();
+
+    // Calls visit(sample, value) for every sample the block covers
+    template <typename Visit>
+    static void decode(const Block& block, Visit&& visit);
+};
+
+#endif // PROCESSHISTORY_H
@@ -12,16 +12,29 @@ public:
 
     // Getters
     pid_t getPid() const { return m_pid; }
-    std::string getName() const { return m_name; }
-    std::string getPath() const { return m_path; }
+    const std::string& getName() const { return m_name; }
+    const std::string& getPath() const { return m_path; }
     uint64_t getResidentSize() const { return m_residentSize; }
     uint64_t getVirtualSize() const { return m_virtualSize; }
+    uint64_t getStartTime() const { return m_startTime; }
     double getMemoryUsageGB() const;
     double getMemoryPercentage(uint64_t totalPhysicalRAM) const;
 
     // Update process information from system
     bool update();
 
+    // Populated in place by ProcessCollector backends; assign() keeps the
+    // existing string capacity so reused slots don't reallocate
+    void setPid(pid_t pid) { m_pid = pid; }
+    void setName(const char *name, size_t length) { m_name.assign(name, length); }
+    void setPath(const char *path, size_t length) { m_path.assign(path, length); }
+    void setMemory(uint64_t residentSize, uint64_t virtualSize) {
+        m_residentSize = residentSize;
+        m_virtualSize = virtualSize;
+    }
+    void setStartTime(uint64_t startTime) { m_startTime = startTime; }
+    void setValid(bool valid) { m_valid = valid; }
+
     // Validation
     bool isValid() const { return m_valid; }
 
@@ -31,6 +44,7 @@ private:
     std::string m_path;
     uint64_t m_residentSize;  // Resident memory in bytes
     uint64_t m_virtualSize;   // Virtual memory in bytes
+    uint64_t m_startTime;     // Backend-specific start stamp, tells reused pids apart
     bool m_valid;
 
     bool collectProcessInfo();
@@ -0,0 +1,72 @@
+#ifndef PROCESSSCANPOOL_H
+#define PROCESSSCANPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "ProcessCollector.h"
+
+// Bounded pool that runs a per-item task over [0, count) on a fixed number
+// of workers. The range is split into one shard per worker; a worker that
+// drains its shard steals the back half of another worker's remainder, so
+// a few slow or blocked pids don't hold up the whole scan. Each worker owns
+// its own ProcessCollector since collectors are single-threaded.
+class ProcessScanPool {
+public:
+    using Task = std::function<void(ProcessCollector& collector, size_t item)>;
+
+    // workerCount 0 means one worker per hardware thread
+    explicit ProcessScanPool(size_t workerCount = 0);
+    ~ProcessScanPool();
+
+    ProcessScanPool(const ProcessScanPool&) = delete;
+    ProcessScanPool& operator=(const ProcessScanPool&) = delete;
+
+    size_t workerCount() const { return m_collectors.size(); }
+    void setWorkerCount(size_t workerCount);
+
+    // Collector of the calling thread, usable between runs
+    ProcessCollector& collector() { return *m_collectors[0]; }
+
+    // Runs task for every item and returns once all items are done.
+    // The calling thread participates as worker 0. itemWeight is the
+    // number of pids one item stands for (a batch of reads), which scales
+    // the serial cut-off and the chunk size down accordingly.
+    void run(size_t count, const Task& task, size_t itemWeight = 1);
+
+    // Read stats of every worker's collector, summed; call between runs
+    CollectorReadStats takeReadStats();
+
+private:
+    // Packed [begin, end) item range, stolen from with CAS
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> range{0};
+    };
+
+    std::vector<std::unique_ptr<ProcessCollector>> m_collectors;
+    std::unique_ptr<Shard[]> m_shards;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Task *m_task = nullptr;
+    size_t m_chunkSize = 1;
+    uint64_t m_runId = 0;
+    size_t m_pendingWorkers = 0;
+    bool m_stopping = false;
+
+    void startWorkers(size_t workerCount);
+    void stopWorkers();
+    void workerLoop(size_t worker, uint64_t lastRunId);
+    void drain(size_t worker);
+    bool takeChunk(size_t worker, size_t& begin, size_t& end);
+    bool steal(size_t thief);
+};
+
+#endif // PROCESSSCANPOOL_H
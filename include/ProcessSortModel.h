@@ -0,0 +1,35 @@
+#ifndef PROCESSSORTMODEL_H
+#define PROCESSSORTMODEL_H
+
+#include <QSortFilterProxyModel>
+#include <vector>
+
+class ProcessTableModel;
+
+// Sorting proxy for ProcessTableModel that also owns the Cumulative % column,
+// since that value depends on the display order. It is a prefix sum over the
+// sorted % of Total values, extended lazily up to the highest row a view has
+// asked for and thrown away whenever the order or the values change. The
+// column is reported changed once per ProcessTableModel::setSnapshot.
+class ProcessSortModel : public QSortFilterProxyModel {
+    Q_OBJECT
+
+public:
+    explicit ProcessSortModel(QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+protected:
+    bool lessThan(const QModelIndex& left, const QModelIndex& right) const override;
+
+private:
+    ProcessTableModel *m_processModel;
+    mutable std::vector<double> m_prefix;  // cumulative % for proxy rows [0, size)
+
+    double cumulativeAt(int row) const;
+    void invalidatePrefix();
+    void onSnapshotApplied();
+};
+
+#endif // PROCESSSORTMODEL_H
@@ -0,0 +1,82 @@
+#ifndef PROCESSTABLEMODEL_H
+#define PROCESSTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include "MemorySnapshot.h"
+
+// Table model reading straight from a MemorySnapshot. Rows are kept in a
+// stable order (one per process identity) and each new snapshot is diffed
+// against them, so only exited, started and changed processes produce
+// rowsRemoved / rowsInserted / dataChanged (one, spanning the changed rows).
+// Views and proxies therefore keep their selection and scroll position
+// across refreshes.
+//
+// Cumulative % depends on display order and is supplied by ProcessSortModel.
+class ProcessTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        NameColumn = 0,
+        PathColumn,
+        MemoryColumn,
+        PercentColumn,
+        CumulativeColumn,
+        GrowthColumn,
+        ProportionalColumn,  // PSS, USS and swap: empty unless the
+        UniqueColumn,        // snapshot carries accounting
+        SwapColumn,
+        ColumnCount
+    };
+
+    // Raw value used for sorting (numbers for the numeric columns)
+    static constexpr int SortRole = Qt::UserRole;
+
+    explicit ProcessTableModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    // Moves the model to snapshot, emitting only the row changes needed
+    void setSnapshot(SnapshotPtr snapshot);
+
+    ProcessRef processAt(int row) const;
+    double percentageAt(int row) const;
+
+    static QString formatMemorySize(uint64_t bytes);
+    static QString formatPercentage(double percentage);
+    static QString formatGrowthRate(double bytesPerSecond);
+
+    // Accounting values older than this are drawn greyed out
+    static constexpr uint64_t kStaleAccountingMs = 30 * 1000;
+
+signals:
+    // Emitted once at the end of every setSnapshot, after all row signals
+    void snapshotApplied();
+
+private:
+    struct Row {
+        ProcessKey key;
+        uint32_t index;  // into m_snapshot's process columns
+        uint32_t next;   // index in the incoming snapshot while diffing
+    };
+
+    SnapshotPtr m_snapshot;
+    std::vector<Row> m_rows;
+
+    // Scratch space for setSnapshot, kept to avoid reallocating every refresh
+    std::unordered_map<pid_t, uint32_t> m_nextIndexByPid;
+    std::vector<bool> m_claimed;
+
+    bool findInNext(const MemorySnapshot& next, Row& row);
+    QVariant accountingData(const ProcessRef& proc, int column, int role) const;
+};
+
+#endif // PROCESSTABLEMODEL_H
@@ -0,0 +1,81 @@
+#ifndef RECORDINGFORMAT_H
+#define RECORDINGFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// On-disk layout of a snapshot recording (.mmrec), shared by
+// SnapshotRecorder and SnapshotRecording. All integers are little-endian.
+//
+//   RecordingFileHeader
+//   { RecordingSampleHeader, body } ...      appended one per sample
+//   string table                             written on close
+//   uint64_t offset[sampleCount]             written on close
+//   RecordingFooter                          written on close
+//
+// A sample body holds the strings first interned since the previous sample
+// (ids continue from the running total, as in StringPool), then the process
+// columns encoded against the previous sample's columns:
+//
+//   varint changedCount, then per changed row:
+//       varint rowDelta (row index minus previous changed row index, -1 at start),
+//       varint pid, varint startTime, varint nameId, varint pathId
+//   zigzag varint RSS delta per row (against the previous sample's row)
+//   zigzag varint VSZ delta per row
+//
+// A changed row is one whose identity differs from the same row of the
+// previous sample (or did not exist there); its deltas are against 0. A
+// keyframe is encoded against an empty sample, so decoding any sample
+// needs at most keyframeDistance earlier samples. The footer index makes
+// seeking O(1); without a footer (crash) a reader walks the headers.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Recordings are written in host order, which must be little-endian"
+#endif
+
+constexpr uint32_t kRecordingMagic = 0x43524d4d;        // "MMRC"
+constexpr uint32_t kRecordingSampleMagic = 0x4c504d53;  // "SMPL"
+constexpr uint32_t kRecordingFooterMagic = 0x5844494d;  // "MIDX"
+constexpr uint32_t kRecordingVersion = 1;
+
+struct RecordingFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t keyframeInterval;
+    uint64_t totalPhysicalRAM;
+    uint64_t reserved[5];
+};
+
+enum RecordingSampleFlags : uint32_t {
+    RecordingKeyframe = 1u << 0
+};
+
+struct RecordingSampleHeader {
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t sequence;
+    uint64_t timestampMs;
+    uint64_t freeMemory;
+    uint64_t activeMemory;
+    uint64_t inactiveMemory;
+    uint64_t wiredMemory;
+    uint32_t processCount;
+    uint32_t newStringCount;
+    uint32_t keyframeDistance;  // samples back to the keyframe, 0 for keyframes
+    uint32_t bodySize;          // bytes following this header
+};
+
+struct RecordingFooter {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t sampleCount;
+    uint64_t indexOffset;
+    uint64_t stringsOffset;
+};
+
+static_assert(sizeof(RecordingFileHeader) == 64, "file header layout");
+static_assert(sizeof(RecordingSampleHeader) == 72, "sample header layout");
+static_assert(sizeof(RecordingFooter) == 32, "footer layout");
+
+#endif // RECORDINGFORMAT_H
@@ -0,0 +1,55 @@
+#ifndef REFRESHSCHEDULER_H
+#define REFRESHSCHEDULER_H
+
+#include <cstdint>
+
+// Chooses the delay between collections. Each sample reports what the
+// last refresh cycle cost in CPU time and how fast resident memory moved.
+//
+// With adaptive scheduling on, the interval halves toward a quarter of
+// the base interval while memory moves quickly, and stretches toward
+// eight times the base after a few quiet samples. Either way the interval
+// never drops below the point where the measured cycle cost would exceed
+// the CPU budget, so an expensive scan (many processes, slow procfs)
+// slows sampling down instead of piling up.
+class RefreshScheduler {
+public:
+    RefreshScheduler();
+
+    // Interval chosen by the user; 0 turns automatic refresh off
+    void setBaseInterval(uint64_t ms);
+    uint64_t baseInterval() const { return m_baseMs; }
+
+    void setAdaptive(bool adaptive);
+    bool adaptive() const { return m_adaptive; }
+
+    // Share of one core the monitor may use, e.g. 0.02 for 2%; 0 = no limit
+    void setCpuBudget(double fraction);
+    double cpuBudget() const { return m_cpuBudget; }
+
+    // cycleCpuNs: process CPU time since the previous sample started.
+    // activity: resident memory that changed, as a fraction of physical
+    // RAM per second.
+    void recordSample(uint64_t cycleCpuNs, double activity);
+
+    // Delay from the start of the last collection to the next; 0 when
+    // automatic refresh is off
+    uint64_t nextInterval() const;
+
+    uint64_t averageCycleCpuNs() const { return static_cast<uint64_t>(m_cycleCpuNs); }
+
+private:
+    uint64_t m_baseMs;
+    bool m_adaptive;
+    double m_cpuBudget;
+
+    double m_intervalMs;   // adaptive interval before the budget floor
+    double m_cycleCpuNs;   // moving average
+    bool m_haveCost;
+    int m_quietSamples;
+
+    double minInterval() const;
+    double maxInterval() const;
+};
+
+#endif // REFRESHSCHEDULER_H
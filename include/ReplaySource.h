@@ -0,0 +1,61 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <memory>
+#include <vector>
+#include "MemorySnapshot.h"
+#include "SnapshotRecording.h"
+
+// Plays a recording back as a stream of snapshots, standing in for
+// SystemMonitor when reviewing an incident. Samples are spaced by their
+// recorded timestamps divided by the playback speed. Lives on the GUI
+// thread: decoding a sample is a keyframe plus a few deltas at most.
+class ReplaySource : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ReplaySource(QObject *parent = nullptr);
+
+    bool open(const QString& path);
+
+    // Sample currently shown; null before the first one is decoded
+    SnapshotPtr snapshot() const { return m_current; }
+
+    int sampleCount() const { return static_cast<int>(m_recording.sampleCount()); }
+    int position() const { return static_cast<int>(m_position); }
+    bool isPlaying() const { return m_playing; }
+    double speed() const { return m_speed; }
+
+public slots:
+    void play();
+    void pause();
+    void seek(int index);
+    void step();
+
+    // Multiple of real time, e.g. 60 plays a minute per second
+    void setSpeed(double speed);
+
+signals:
+    void dataReady();
+    void positionChanged(int index, int count);
+    void finished();
+    void errorOccurred(const QString& error);
+
+private:
+    SnapshotRecording m_recording;
+    QTimer *m_timer;
+    SnapshotPtr m_current;
+    std::vector<std::shared_ptr<MemorySnapshot>> m_snapshotPool;
+    size_t m_position;
+    double m_speed;
+    bool m_playing;
+
+    bool showSample(size_t index);
+    void scheduleNext();
+    void onTimer();
+};
+
+#endif // REPLAYSOURCE_H
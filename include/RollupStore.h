@@ -0,0 +1,160 @@
+#ifndef ROLLUPSTORE_H
+#define ROLLUPSTORE_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "MemorySnapshot.h"
+#include "ProcessCache.h"
+
+// Min / max / average / last of every process's RSS and of the system
+// counters, per minute (kept 1 day) and per hour (kept 35 days).
+//
+// Each sample updates the open bucket of both tiers in place; a bucket is
+// closed when a sample lands in a later one. A closed bucket identical to
+// the previous one (an idle process) is not stored: a bucket covers every
+// bucket up to the next stored one. Range queries binary-search the tier and
+// touch at most one entry per bucket in range, so "peak RSS of postgres
+// over the last week" is ~170 hourly entries per postgres process.
+//
+// save() / load() persist the whole store (see the .cpp for the layout).
+// Process keys only mean the same process within one boot, so the file
+// records the boot it was written in. Series loaded from another boot are
+// detached: they still count towards nameStats() but no live process key
+// matches them.
+// append() and save() are called from the collector thread; the queries may
+// be called from any thread.
+class RollupStore {
+public:
+    enum Tier {
+        MinuteTier = 0,
+        HourTier,
+        TierCount
+    };
+
+    enum SystemCounter {
+        FreeMemory = 0,
+        ActiveMemory,
+        InactiveMemory,
+        WiredMemory,
+        SystemCounterCount
+    };
+
+    // Values in bytes; buckets == 0 means no data in the range
+    struct Stats {
+        uint64_t min = 0;
+        uint64_t max = 0;
+        uint64_t average = 0;
+        uint64_t last = 0;
+        uint64_t buckets = 0;
+    };
+
+    static constexpr uint64_t kMinuteMs = 60 * 1000;
+    static constexpr uint64_t kHourMs = 60 * kMinuteMs;
+
+    RollupStore();
+
+    RollupStore(const RollupStore&) = delete;
+    RollupStore& operator=(const RollupStore&) = delete;
+
+    void append(const MemorySnapshot& snapshot);
+    void clear();
+
+    // ProcessCollector::queryBootId(); set before load()
+    void setBootId(const std::string& bootId);
+
+    // Replaces the file atomically (write + rename)
+    bool save(const std::string& path) const;
+    // Replaces the store with the file's contents; the store is left empty
+    // on failure
+    bool load(const std::string& path);
+
+    // Stats over [fromMs, toMs), from the minute tier when it covers a range
+    // of up to a day and from the hour tier otherwise. Buckets overlapping
+    // the range count whole.
+    Stats processStats(const ProcessKey& key, uint64_t fromMs, uint64_t toMs) const;
+    // Over every process with this name: the largest single-process peak,
+    // the smallest minimum, the mean of their averages and the latest value
+    Stats nameStats(const std::string& name, uint64_t fromMs, uint64_t toMs) const;
+    Stats systemStats(SystemCounter counter, uint64_t fromMs, uint64_t toMs) const;
+
+    // Timestamp of the latest sample appended or loaded
+    uint64_t latestTimestampMs() const;
+    size_t seriesCount() const;
+    size_t memoryUsage() const;
+
+private:
+    // Values in KiB, bucket = timestamp / tier interval
+    struct Entry {
+        uint32_t bucket;
+        uint32_t min;
+        uint32_t max;
+        uint32_t average;
+        uint32_t last;
+    };
+
+    struct OpenBucket {
+        uint32_t bucket;
+        uint32_t min;
+        uint32_t max;
+        uint32_t last;
+        uint64_t sum;
+        uint32_t count;  // 0 when nothing is open
+    };
+
+    struct TierSeries {
+        std::deque<Entry> entries;  // oldest first
+        uint32_t lastBucket = 0;    // last bucket covered by entries.back()
+        OpenBucket open = {};
+    };
+
+    struct Series {
+        ProcessKey key;
+        uint32_t name;  // index into m_names
+        TierSeries tiers[TierCount];
+    };
+
+    struct Accumulator;
+
+    mutable std::mutex m_mutex;
+
+    std::vector<Series> m_series;
+    std::vector<uint32_t> m_freeSeries;
+    std::unordered_map<ProcessKey, uint32_t, ProcessKeyHash> m_seriesByKey;
+    std::vector<uint32_t> m_detached;  // from an earlier boot, not in m_seriesByKey
+    std::string m_bootId;
+
+    std::vector<std::string> m_names;
+    std::vector<std::vector<uint32_t>> m_seriesByName;  // parallel to m_names
+    std::unordered_map<std::string, uint32_t> m_nameIndex;
+
+    TierSeries m_system[SystemCounterCount][TierCount];
+    uint64_t m_latestTimestampMs;
+    uint32_t m_lastSweepHour;
+
+    static uint64_t interval(int tier);
+    static uint32_t retentionBuckets(int tier);
+
+    uint32_t allocateSeries(const ProcessKey& key, const std::string& name);
+    uint32_t seriesFor(const ProcessKey& key, const std::string& name);
+    void releaseSeries(uint32_t seriesId);
+    void sweep(uint32_t hour);
+    void reset();
+
+    static void add(TierSeries& series, int tier, uint32_t bucket, uint32_t value);
+    static void close(TierSeries& series, int tier);
+    static void store(TierSeries& series, const Entry& entry);
+    static void expire(TierSeries& series, int tier, uint32_t currentBucket);
+    static void collect(const TierSeries& series, uint32_t fromBucket, uint32_t toBucket,
+                        Accumulator& accumulator);
+    static int tierFor(uint64_t fromMs, uint64_t toMs, uint64_t latestMs);
+
+    static void writeTier(std::string& out, const TierSeries& series);
+    static bool readTier(const uint8_t *&p, const uint8_t *end, TierSeries& series);
+};
+
+#endif // ROLLUPSTORE_H
@@ -0,0 +1,56 @@
+#ifndef SAMPLEWRITER_H
+#define SAMPLEWRITER_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "MemorySnapshot.h"
+
+// Serializes snapshots for the headless collector, one sample at a time.
+//
+// NDJSON writes one object per sample with the system counters, memory
+// pressure where available ("pressure", plus "pressure_stalls" on samples
+// taken because a trigger fired) and a "processes" array. CSV writes one row per process, repeating the sample's
+// sequence, timestamp and system totals on each row, after a single header.
+//
+// Output is formatted into an internal buffer and handed to the file
+// descriptor with write(2) only once bufferSize bytes have accumulated, so
+// a 10 Hz stream costs one system call every few samples. The buffer is
+// flushed on destruction.
+class SampleWriter {
+public:
+    enum class Format { Ndjson, Csv };
+
+    // fd stays owned by the caller. bufferSize 0 writes every sample as
+    // soon as it is formatted.
+    SampleWriter(int fd, Format format, size_t bufferSize);
+    ~SampleWriter();
+
+    SampleWriter(const SampleWriter&) = delete;
+    SampleWriter& operator=(const SampleWriter&) = delete;
+
+    // Appends one sample. topCount limits the processes written to the
+    // largest by resident size (0 = all, in snapshot order).
+    bool write(const MemorySnapshot& snapshot, uint64_t timestampMs, size_t topCount);
+
+    // Writes out everything buffered so far
+    bool flush();
+
+private:
+    int m_fd;
+    Format m_format;
+    size_t m_bufferSize;
+    bool m_headerWritten;
+    std::string m_buffer;
+
+    void appendNdjson(const MemorySnapshot& snapshot, uint64_t timestampMs, size_t topCount);
+    void appendCsv(const MemorySnapshot& snapshot, uint64_t timestampMs, size_t topCount);
+    void appendNdjsonProcess(const ProcessRef& process, bool first);
+    void appendCsvProcess(const std::string& samplePrefix, const ProcessRef& process);
+    void appendNumber(uint64_t value);
+    void appendDecimal(double value);
+    void appendJsonString(const std::string& value);
+    void appendCsvField(const std::string& value);
+};
+
+#endif // SAMPLEWRITER_H
@@ -0,0 +1,89 @@
+#ifndef SMAPSPARSER_H
+#define SMAPSPARSER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// What a group of mappings in a process's address space is backed by
+enum class MappingKind {
+    Heap,          // [heap]
+    Stack,         // [stack], [stack:<tid>]
+    Anonymous,     // no backing file, or named with prctl ([anon:<name>])
+    Library,       // shared objects (*.so, *.so.N)
+    File,          // any other mapped file
+    SharedMemory,  // /dev/shm, memfd and System V segments
+    Other,         // [vdso], [vvar], [vsyscall], ...
+    KindCount
+};
+
+const char *mappingKindName(MappingKind kind);
+
+// One process's memory by mapping, from /proc/<pid>/smaps. Mappings with
+// the same backing (all segments of a library, all unnamed anonymous
+// regions) are summed into one Region.
+struct MappingBreakdown {
+    struct Totals {
+        uint64_t size = 0;          // virtual
+        uint64_t resident = 0;
+        uint64_t proportional = 0;  // PSS
+        uint64_t unique = 0;        // USS: Private_Clean + Private_Dirty
+        uint64_t swap = 0;
+        uint32_t mappings = 0;
+    };
+
+    struct Region {
+        MappingKind kind = MappingKind::Other;
+        std::string name;  // path, [heap], [anon:<name>], ... "" for unnamed anonymous
+        Totals totals;
+    };
+
+    std::vector<Region> regions;  // in order of first appearance
+    Totals kinds[static_cast<size_t>(MappingKind::KindCount)];
+    Totals total;
+
+    void clear();
+};
+
+// Streaming parser for the smaps format. Data is fed in arbitrary chunks
+// (typically straight from read() on the procfs file); complete lines are
+// parsed in place and only a line split across two chunks is copied.
+// Lines are found with memchr, which libc vectorizes, and only the six
+// fields the breakdown needs are decoded.
+//
+// Allocates per distinct region, never per mapping or line, so a JVM with
+// 100k anonymous mappings costs about as much as its few hundred files.
+// Used from one thread at a time.
+class SmapsParser {
+public:
+    SmapsParser();
+
+    // Starts a new file; out is cleared and filled by feed() and finish()
+    void begin(MappingBreakdown& out);
+    void feed(const char *data, size_t length);
+    void finish();
+
+    // Bytes fed since begin()
+    uint64_t bytesParsed() const { return m_bytesParsed; }
+
+private:
+    MappingBreakdown *m_out;
+    MappingBreakdown::Totals m_current;  // mapping whose fields are being read
+    size_t m_currentRegion;              // index into m_out->regions, or npos
+    bool m_inMapping;
+
+    // Region index by name; m_key is scratch so lookups reuse its capacity
+    std::unordered_map<std::string, size_t> m_regionByName;
+    std::string m_key;
+
+    std::string m_partial;  // unterminated tail of the previous chunk
+    uint64_t m_bytesParsed;
+
+    void parseLine(const char *line, const char *end);
+    void beginMapping(const char *line, const char *end);
+    void endMapping();
+};
+
+#endif // SMAPSPARSER_H
@@ -0,0 +1,69 @@
+#ifndef SNAPSHOTRECORDER_H
+#define SNAPSHOTRECORDER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include "MemorySnapshot.h"
+
+// Appends snapshots to a recording file (format in RecordingFormat.h).
+// Each sample is encoded against the previous one and handed to the file
+// with a single write(2), so a crash loses at most the sample being
+// written; close() adds the string table and seek index.
+//
+// Strings are written under the recording's own ids, so snapshots may
+// switch StringPools (the process cache compacts its pool); the pool's
+// strings are then looked up again and only unseen ones are written.
+class SnapshotRecorder {
+public:
+    // keyframeInterval bounds how many samples a random seek decodes
+    explicit SnapshotRecorder(uint32_t keyframeInterval = 60);
+    ~SnapshotRecorder();
+
+    SnapshotRecorder(const SnapshotRecorder&) = delete;
+    SnapshotRecorder& operator=(const SnapshotRecorder&) = delete;
+
+    // Creates (or truncates) path
+    bool open(const std::string& path, uint64_t totalPhysicalRAM);
+    bool isOpen() const { return m_fd >= 0; }
+
+    bool append(const MemorySnapshot& snapshot);
+
+    // Writes string table, index and footer, then closes the file
+    bool close();
+
+    uint64_t sampleCount() const { return m_offsets.size(); }
+    uint64_t bytesWritten() const { return m_fileSize; }
+
+private:
+    // Identity and counters of one row, as last written
+    struct Row {
+        pid_t pid;
+        uint64_t startTime;
+        uint32_t nameId;
+        uint32_t pathId;
+        uint64_t residentSize;
+        uint64_t virtualSize;
+    };
+
+    int m_fd;
+    uint32_t m_keyframeInterval;
+    uint64_t m_fileSize;
+    uint32_t m_sinceKeyframe;
+    uint32_t m_stringCount;                       // m_recorded ids already written
+    std::shared_ptr<const StringPool> m_strings;  // pool of the last snapshot
+    std::unique_ptr<StringPool> m_recorded;       // every string in the file, by recorded id
+    std::vector<uint32_t> m_recordedIds;          // m_strings id -> recorded id
+
+    std::vector<uint64_t> m_offsets;
+    std::vector<Row> m_previous;
+    std::vector<uint32_t> m_changedRows;
+    std::string m_buffer;
+
+    bool writeAll(const void *data, size_t size);
+};
+
+#endif // SNAPSHOTRECORDER_H
@@ -0,0 +1,68 @@
+#ifndef SNAPSHOTRECORDING_H
+#define SNAPSHOTRECORDING_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "MemorySnapshot.h"
+#include "RecordingFormat.h"
+
+// Read-only view of a recording written by SnapshotRecorder. The file is
+// memory-mapped; opening only reads the footer and string table, and any
+// sample is decoded from its keyframe, at most keyframeInterval samples
+// back. Sequential reads decode one delta each.
+//
+// Recordings without a footer (the recorder died) are still readable: open()
+// then walks the sample headers once to rebuild the index.
+class SnapshotRecording {
+public:
+    SnapshotRecording();
+    ~SnapshotRecording();
+
+    SnapshotRecording(const SnapshotRecording&) = delete;
+    SnapshotRecording& operator=(const SnapshotRecording&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    size_t sampleCount() const { return m_sampleCount; }
+    uint64_t totalPhysicalRAM() const { return m_totalPhysicalRAM; }
+
+    // O(1): straight from the sample header
+    uint64_t timestampAt(size_t index) const;
+
+    // First sample taken at or after timestampMs (binary search over headers)
+    size_t indexAtTime(uint64_t timestampMs) const;
+
+    // Decodes sample index into snapshot, reusing its column capacity
+    bool readSample(size_t index, MemorySnapshot& snapshot);
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+    uint64_t m_totalPhysicalRAM;
+    size_t m_sampleCount;
+
+    // Index from the footer (inside the mapping) or rebuilt by a scan
+    const uint8_t *m_indexData;
+    std::vector<uint64_t> m_scannedIndex;
+
+    std::shared_ptr<StringPool> m_strings;
+
+    // Decoder state: the rows of sample m_decodedIndex
+    std::vector<ProcessRecord> m_rows;
+    size_t m_decodedIndex;
+    bool m_decodedValid;
+
+    uint64_t offsetAt(size_t index) const;
+    bool sampleHeaderAt(size_t index, RecordingSampleHeader& header) const;
+    bool readFooter();
+    bool scanSamples();
+    bool readStrings(const uint8_t *&p, const uint8_t *end, uint64_t count);
+    bool applySample(size_t index);
+};
+
+#endif // SNAPSHOTRECORDING_H
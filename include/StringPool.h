@@ -0,0 +1,49 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+// Append-only intern table for process names and paths, shared by the
+// process cache and every snapshot. Each distinct string is stored once and
+// identified by a dense 32-bit id; id 0 is the empty string. The cache
+// replaces its pool with a compacted one when most ids are dead (see
+// ProcessCache), so consumers that keep ids must notice a new pool.
+//
+// intern() must only be called from the collector thread. str() may be
+// called from any thread for ids it got through a published snapshot:
+// strings live in fixed chunks that never move and are never modified.
+class StringPool {
+public:
+    StringPool();
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // 0 for every new string once kMaxChunks chunks are full
+    uint32_t intern(std::string_view value);
+
+    const std::string& str(uint32_t id) const {
+        return m_chunks[id >> kChunkBits][id & (kChunkSize - 1)];
+    }
+
+    size_t size() const { return m_count; }
+
+    // Bytes held by the pool, including its index
+    size_t memoryUsage() const;
+
+private:
+    static constexpr uint32_t kChunkBits = 10;
+    static constexpr uint32_t kChunkSize = 1u << kChunkBits;
+    static constexpr uint32_t kMaxChunks = 4096;  // 4M distinct strings
+
+    std::unique_ptr<std::string[]> m_chunks[kMaxChunks];
+    std::unordered_map<std::string_view, uint32_t> m_index;  // views into m_chunks
+    uint32_t m_count;
+};
+
+#endif // STRINGPOOL_H
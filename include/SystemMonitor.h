@@ -2,45 +2,182 @@
 #define SYSTEMMONITOR_H
 
 #include <QObject>
+#include <QStringList>
+#include <atomic>
+#include <string>
 #include <vector>
+#include <memory>
 #include <cstdint>
-#include "ProcessInfo.h"
+#include "ProcessCollector.h"
+#include "ProcessCache.h"
+#include "ProcessScanPool.h"
+#include "MemorySnapshot.h"
+#include "AccountingSampler.h"
+#include "AlertEngine.h"
+#include "GrowthAnalyzer.h"
+#include "PressureMonitor.h"
+#include "ProcessHistory.h"
+#include "RefreshScheduler.h"
+#include "RollupStore.h"
+#include "SnapshotRecorder.h"
 
-class SystemMonitor : public QObject {
+class QTimer;
+
+class SystemMonitor : public QObject, private AlertSink {
     Q_OBJECT
 
 public:
     explicit SystemMonitor(QObject *parent = nullptr);
+    ~SystemMonitor() override;
 
-    // System memory statistics
+    // Total physical RAM never changes, safe to read from any thread
     uint64_t getTotalPhysicalRAM() const { return m_totalPhysicalRAM; }
-    uint64_t getFreeMemory() const { return m_freeMemory; }
-    uint64_t getActiveMemory() const { return m_activeMemory; }
-    uint64_t getInactiveMemory() const { return m_inactiveMemory; }
-    uint64_t getWiredMemory() const { return m_wiredMemory; }
-    uint64_t getUsedMemory() const;
 
-    // Process information
-    const std::vector<ProcessInfo>& getProcesses() const { return m_processes; }
-    std::vector<ProcessInfo> getTopProcessesByMemory(size_t count) const;
+    // Latest completed sample; safe to call from any thread. Returns null
+    // until the first collection has finished.
+    SnapshotPtr snapshot() const { return std::atomic_load(&m_published); }
+
+    // RSS history of every process seen in the last 24 hours; query() is
+    // safe from any thread
+    const ProcessHistory& history() const { return m_history; }
+
+    // Minute and hour rollups of process RSS and system counters, 35 days;
+    // queries are safe from any thread
+    const RollupStore& rollups() const { return m_rollups; }
+
+    // Safe from any thread: asks the monitor's thread for a collection.
+    // Requests made while one is still queued are merged into it, so at
+    // most one collection runs and one waits, however often this is called.
+    void requestCollect();
+
+    // Kernel-triggered memory stall alerts (Linux PSI). Whenever tasks have
+    // stalled on memory for stallMs within windowMs, system-wide or in one
+    // of cgroups (cgroup v2 directories), pressureStall is emitted and a
+    // sample is collected at once, outside the refresh schedule. stallMs 0
+    // stops watching. Call from the monitor's thread or before moving it;
+    // on failure nothing is watched and error says why.
+    bool setPressureTrigger(int stallMs, int windowMs, const QStringList& cgroups = QStringList(),
+                            QString *error = nullptr);
+
+    // Safe from any thread: abandons a progressive first scan at its next
+    // batch, e.g. when the window closes, and stops further collections
+    void cancel();
 
 public slots:
+    // Collects now, then arms the refresh timer for the next sample
     void collectData();
 
+    // Automatic refresh (see RefreshScheduler); interval 0 stops it
+    void setRefreshInterval(int ms);
+    void setAdaptiveRefresh(bool adaptive);
+    void setCpuBudget(double percent);
+
+    // Publishes provisional samples (MemorySnapshot::isPartial) while the
+    // first scan runs, so a large host shows its first processes at once.
+    // Off by default: streams and recordings only want complete samples.
+    void setProgressiveScan(bool progressive);
+
+    // PSS / USS / swap columns in every snapshot (see AccountingSampler);
+    // off by default. The budget bounds the time spent per sample; the
+    // largest processes are read even when they alone exceed it.
+    void setAccountingEnabled(bool enabled);
+    void setAccountingBudget(int microseconds);
+
+    // Number of threads reading per-process data; 0 = one per core
+    void setScanWorkerCount(int count);
+
+    // Follows process starts and exits through a ProcessEventSource instead
+    // of listing every pid per sample, where one is available; on by default
+    void setProcessEvents(bool enabled);
+
+    // Re-reads known processes in batches through io_uring where the
+    // kernel allows it (see LinuxProcessCollector); plain reads otherwise
+    void setBatchedReads(bool enabled);
+
+    // Sustained RSS growth above this is flagged in each snapshot
+    void setGrowthThreshold(double bytesPerSecond);
+
+    // Appends every published sample to a recording file (see
+    // SnapshotRecording for playback) until stopRecording(). False (after
+    // errorOccurred) when the file cannot be created.
+    bool startRecording(const QString& path);
+    void stopRecording();
+
+    // Loads the rollups saved at path, then saves them there every 15
+    // minutes and on destruction. Call before the first collectData().
+    void setRollupPath(const QString& path);
+
+    // Replaces the alert rules (see AlertEngine for the syntax); on a
+    // syntax error the previous rules stay and errorOccurred is emitted
+    void setAlertRules(const QString& rules);
+
 signals:
     void dataReady();
     void errorOccurred(const QString& error);
 
+    // An alert rule was raised (active) or cleared
+    void alertChanged(const QString& rule, bool active, const QString& message);
+
+    // A pressure trigger fired, on source "system" or a cgroup directory;
+    // emitted from the pressure thread as soon as the kernel reports it
+    void pressureStall(const QString& source, const QString& message);
+
+    // The automatic refresh interval moved (adaptive scheduling or budget)
+    void refreshIntervalChanged(int ms);
+
 private:
     uint64_t m_totalPhysicalRAM;
-    uint64_t m_freeMemory;
-    uint64_t m_activeMemory;
-    uint64_t m_inactiveMemory;
-    uint64_t m_wiredMemory;
-    std::vector<ProcessInfo> m_processes;
+    SystemMemoryInfo m_memory;
+    uint64_t m_sequence;
+
+    ProcessScanPool m_scanPool;
+    ProcessCache m_cache;
+    uint64_t m_reportedDroppedStrings;  // m_cache.droppedStrings() last seen
+    uint64_t m_seenCompactions;         // m_cache.stringCompactions() last seen
+    bool m_stringTableFull;             // reported; latched until a compaction
 
+    // Published sample, swapped atomically. Retired snapshots are kept in
+    // m_snapshotPool and refilled in place once no reader holds them.
+    SnapshotPtr m_published;
+    std::vector<std::shared_ptr<MemorySnapshot>> m_snapshotPool;
+
+    GrowthAnalyzer m_growth;
+    AccountingSampler m_accounting;
+    bool m_accountingEnabled;
+    ProcessHistory m_history;
+    RollupStore m_rollups;
+    std::string m_rollupPath;
+    uint64_t m_lastRollupSaveMs;
+    SnapshotRecorder m_recorder;
+    AlertEngine m_alerts;
+
+    bool m_hasPressure;
+    PressureStats m_pressure;
+    std::unique_ptr<PressureMonitor> m_pressureMonitor;
+    std::atomic<uint64_t> m_pendingStalls;  // triggers since the last publish
+
+    // Single-shot, re-armed after each collection so scans never overlap
+    QTimer *m_refreshTimer;
+    RefreshScheduler m_scheduler;
+    std::atomic<bool> m_collectRequested;
+    uint64_t m_lastCollectStartMs;  // steady clock; 0 before the first
+    uint64_t m_lastCycleCpuNs;      // process CPU time when the last collection ended
+    uint64_t m_lastFreeMemory;
+    uint64_t m_announcedIntervalMs;
+
+    bool m_progressiveScan;
+    std::atomic<bool> m_cancelled;
+
+    void runRequestedCollect();
+    void scheduleNext(uint64_t startMs);
+    bool collectAndPublish();
     bool collectSystemMemoryInfo();
     bool collectAllProcesses();
+    void publishSnapshot(size_t pendingCount = 0);
+    void saveRollups();
+
+    void onAlert(const AlertEvent& event) override;
+    void onPressureStall(const PressureEvent& event);
 };
 
 #endif // SYSTEMMONITOR_H
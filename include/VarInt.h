@@ -0,0 +1,58 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// LEB128 helpers for the recording and history formats
+
+inline void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Raw-buffer variant for fixed-size blocks; p must have varintSize(value) bytes
+inline void writeVarint(uint8_t *&p, uint64_t value) {
+    while (value >= 0x80) {
+        *p++ = static_cast<uint8_t>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(value);
+}
+
+inline size_t varintSize(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+// Maps small negative and positive deltas to small unsigned values
+inline uint64_t zigzagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Reads a varint at p, advancing it; false on truncated input
+inline bool readVarint(const uint8_t *&p, const uint8_t *end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // VARINT_H
@@ -0,0 +1,83 @@
+#include "AccountingSampler.h"
+#include <chrono>
+
+AccountingSampler::AccountingSampler()
+    : m_topCount(kDefaultTopCount)
+    , m_budgetUs(kDefaultBudgetUs)
+    , m_cursor(0)
+    , m_lastReadCount(0)
+{
+}
+
+void AccountingSampler::clear() {
+    m_entries.clear();
+    m_cursor = 0;
+    m_lastReadCount = 0;
+}
+
+bool AccountingSampler::read(const MemorySnapshot& snapshot, size_t row,
+                             ProcessCollector& collector, uint64_t nowMs) {
+    ProcessAccounting accounting;
+    if (!collector.collectAccounting(snapshot.getPids()[row], accounting)) {
+        return false;  // exited, kernel thread or not ours to read
+    }
+    Entry& entry = m_entries[{snapshot.getPids()[row], snapshot.getStartTimes()[row]}];
+    entry.accounting = accounting;
+    entry.sampledAtMs = nowMs;
+    return true;
+}
+
+void AccountingSampler::update(const MemorySnapshot& snapshot, ProcessCollector& collector, uint64_t nowMs) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    for (const ProcessKey& key : snapshot.getRemovedProcesses()) {
+        m_entries.erase(key);
+    }
+
+    size_t count = snapshot.getProcessCount();
+    m_isTop.assign(count, 0);
+    m_lastReadCount = 0;
+    for (ProcessRef process : snapshot.getTopProcessesByMemory(m_topCount)) {
+        read(snapshot, process.index(), collector, nowMs);
+        m_isTop[process.index()] = 1;
+        ++m_lastReadCount;
+    }
+
+    // Round-robin over the rest by row; rows move a little as processes
+    // come and go, which at worst delays a process by one lap
+    auto deadline = start + std::chrono::microseconds(m_budgetUs);
+    for (size_t visited = 0; visited < count && Clock::now() < deadline; ++visited) {
+        if (m_cursor >= count) {
+            m_cursor = 0;
+        }
+        size_t row = m_cursor++;
+        if (!m_isTop[row]) {
+            read(snapshot, row, collector, nowMs);
+            ++m_lastReadCount;
+        }
+    }
+}
+
+void AccountingSampler::fill(const MemorySnapshot& snapshot,
+                             std::vector<uint64_t>& proportional, std::vector<uint64_t>& unique,
+                             std::vector<uint64_t>& swap, std::vector<uint64_t>& sampledAtMs) const {
+    size_t count = snapshot.getProcessCount();
+    proportional.assign(count, 0);
+    unique.assign(count, 0);
+    swap.assign(count, 0);
+    sampledAtMs.assign(count, 0);
+
+    const std::vector<pid_t>& pids = snapshot.getPids();
+    const std::vector<uint64_t>& startTimes = snapshot.getStartTimes();
+    for (size_t row = 0; row < count; ++row) {
+        auto it = m_entries.find({pids[row], startTimes[row]});
+        if (it == m_entries.end()) {
+            continue;
+        }
+        proportional[row] = it->second.accounting.proportionalSize;
+        unique[row] = it->second.accounting.uniqueSize;
+        swap[row] = it->second.accounting.swapSize;
+        sampledAtMs[row] = it->second.sampledAtMs;
+    }
+}
@@ -0,0 +1,592 @@
+#include "AlertEngine.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <fnmatch.h>
+
+namespace {
+
+constexpr double kHysteresis = 0.05;
+constexpr size_t kMaxRules = std::numeric_limits<uint16_t>::max();
+
+// Words, quoted strings (quotes stripped) and comparison operators
+std::vector<std::string> tokenize(const std::string& line, std::string& error) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < line.size()) {
+        char c = line[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '"') {
+            size_t end = line.find('"', i + 1);
+            if (end == std::string::npos) {
+                error = "unterminated quote";
+                return {};
+            }
+            tokens.push_back(line.substr(i + 1, end - i - 1));
+            i = end + 1;
+        } else if (c == '<' || c == '>') {
+            size_t length = i + 1 < line.size() && line[i + 1] == '=' ? 2 : 1;
+            tokens.push_back(line.substr(i, length));
+            i += length;
+        } else {
+            size_t start = i;
+            while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))
+                   && line[i] != '"' && line[i] != '<' && line[i] != '>') {
+                ++i;
+            }
+            tokens.push_back(line.substr(start, i - start));
+        }
+    }
+    return tokens;
+}
+
+std::string lower(std::string value) {
+    for (char& c : value) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return value;
+}
+
+// Strips a trailing comment, outside quotes
+std::string stripComment(const std::string& line) {
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (line[i] == '"') {
+            quoted = !quoted;
+        } else if (line[i] == '#' && !quoted) {
+            return line.substr(0, i);
+        }
+    }
+    return line;
+}
+
+std::string trim(const std::string& value) {
+    size_t start = 0;
+    size_t end = value.size();
+    while (start < end && std::isspace(static_cast<unsigned char>(value[start]))) {
+        ++start;
+    }
+    while (end > start && std::isspace(static_cast<unsigned char>(value[end - 1]))) {
+        --end;
+    }
+    return value.substr(start, end - start);
+}
+
+bool sizeUnit(const std::string& unit, double& multiplier) {
+    static const struct { const char *name; double multiplier; } kUnits[] = {
+        {"", 1.0}, {"b", 1.0},
+        {"k", 1024.0}, {"kb", 1024.0}, {"kib", 1024.0},
+        {"m", 1024.0 * 1024}, {"mb", 1024.0 * 1024}, {"mib", 1024.0 * 1024},
+        {"g", 1024.0 * 1024 * 1024}, {"gb", 1024.0 * 1024 * 1024}, {"gib", 1024.0 * 1024 * 1024},
+        {"t", 1024.0 * 1024 * 1024 * 1024}, {"tb", 1024.0 * 1024 * 1024 * 1024},
+        {"tib", 1024.0 * 1024 * 1024 * 1024},
+    };
+    for (const auto& entry : kUnits) {
+        if (unit == entry.name) {
+            multiplier = entry.multiplier;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool timeUnit(const std::string& unit, double& seconds) {
+    if (unit == "ms") {
+        seconds = 0.001;
+    } else if (unit.empty() || unit == "s" || unit == "sec") {
+        seconds = 1.0;
+    } else if (unit == "m" || unit == "min") {
+        seconds = 60.0;
+    } else if (unit == "h") {
+        seconds = 3600.0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// A number and its unit, either in one token ("8GB") or two ("8 GB"); the
+// unit is lowercased
+bool readQuantity(const std::vector<std::string>& tokens, size_t& i, double& number, std::string& unit) {
+    if (i >= tokens.size()) {
+        return false;
+    }
+    const std::string& token = tokens[i];
+    char *end = nullptr;
+    number = std::strtod(token.c_str(), &end);
+    if (end == token.c_str() || !std::isfinite(number)) {
+        return false;
+    }
+    unit = lower(std::string(end));
+    ++i;
+    if (unit.empty() && i < tokens.size() && lower(tokens[i]) != "for"
+        && !std::isdigit(static_cast<unsigned char>(tokens[i][0]))) {
+        unit = lower(tokens[i]);
+        ++i;
+    }
+    return true;
+}
+
+bool isGlob(const std::string& pattern) {
+    return pattern.find_first_of("*?[") != std::string::npos;
+}
+
+std::string formatBytes(double bytes) {
+    static const char *const kUnits[] = {"B", "KB", "MB", "GB", "TB"};
+    int unit = 0;
+    double magnitude = std::fabs(bytes);
+    while (magnitude >= 1024.0 && unit < 4) {
+        magnitude /= 1024.0;
+        bytes /= 1024.0;
+        ++unit;
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), unit == 0 ? "%.0f %s" : "%.1f %s", bytes, kUnits[unit]);
+    return buffer;
+}
+
+std::string formatRate(double bytesPerSecond) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%+.1f MB/h", bytesPerSecond * 3600.0 / (1024.0 * 1024.0));
+    return buffer;
+}
+
+} // namespace
+
+void AlertEngine::Aggregate::reset() {
+    max = -std::numeric_limits<double>::infinity();
+    min = std::numeric_limits<double>::infinity();
+    sum = 0.0;
+    count = 0;
+    maxRow = 0;
+    minRow = 0;
+}
+
+void AlertEngine::Aggregate::add(double value, uint32_t row) {
+    if (value > max) {
+        max = value;
+        maxRow = row;
+    }
+    if (value < min) {
+        min = value;
+        minRow = row;
+    }
+    sum += value;
+    ++count;
+}
+
+AlertEngine::AlertEngine()
+    : m_sink(nullptr)
+{
+    for (bool& need : m_needAll) {
+        need = false;
+    }
+}
+
+AlertEngine::~AlertEngine() = default;
+
+bool AlertEngine::parseRule(const std::string& line, Rule& rule, std::string& error) {
+    std::vector<std::string> tokens = tokenize(line, error);
+    if (tokens.empty()) {
+        return false;
+    }
+
+    size_t i = 0;
+    rule.name = line;
+    if (tokens[0].size() > 1 && tokens[0].back() == ':') {
+        rule.name = tokens[0].substr(0, tokens[0].size() - 1);
+        ++i;
+    }
+    rule.text = line;
+    rule.metric = Metric::ResidentSize;
+    rule.counter = Counter::Free;
+    rule.field = Field::Any;
+    rule.pattern = 0;
+    rule.percent = false;
+    rule.forMs = 0;
+    rule.sinceMs = 0;
+    rule.holding = false;
+    rule.active = false;
+
+    std::string scope = i < tokens.size() ? lower(tokens[i++]) : std::string();
+    if (scope == "process") {
+        rule.scope = Scope::Process;
+    } else if (scope == "sum") {
+        rule.scope = Scope::Sum;
+    } else if (scope == "count") {
+        rule.scope = Scope::Count;
+    } else if (scope == "system") {
+        rule.scope = Scope::System;
+    } else {
+        error = "expected process, sum, count or system";
+        return false;
+    }
+
+    // Filter, metric and counter words in any order, up to the operator
+    bool haveMetric = false;
+    std::string pattern;
+    while (i < tokens.size() && tokens[i][0] != '<' && tokens[i][0] != '>') {
+        std::string word = lower(tokens[i++]);
+        if ((word == "name" || word == "path") && rule.scope != Scope::System) {
+            if (rule.field != Field::Any || i >= tokens.size()) {
+                error = "expected one name or path pattern";
+                return false;
+            }
+            rule.field = word == "name" ? Field::Name : Field::Path;
+            pattern = tokens[i++];
+        } else if (rule.scope == Scope::System) {
+            static const struct { const char *name; Counter counter; } kCounters[] = {
+                {"free", Counter::Free}, {"used", Counter::Used}, {"active", Counter::Active},
+                {"inactive", Counter::Inactive}, {"wired", Counter::Wired},
+            };
+            bool known = false;
+            for (const auto& entry : kCounters) {
+                if (word == entry.name) {
+                    rule.counter = entry.counter;
+                    known = true;
+                }
+            }
+            if (!known || haveMetric) {
+                error = "expected one of free, used, active, inactive, wired";
+                return false;
+            }
+            haveMetric = true;
+        } else if (rule.scope != Scope::Count && !haveMetric
+                   && (word == "rss" || word == "vsz" || word == "growth")) {
+            rule.metric = word == "rss" ? Metric::ResidentSize
+                : word == "vsz" ? Metric::VirtualSize : Metric::Growth;
+            haveMetric = true;
+        } else {
+            error = "unexpected '" + word + "'";
+            return false;
+        }
+    }
+    if (!haveMetric && rule.scope != Scope::Count) {
+        error = rule.scope == Scope::System ? "expected a system counter" : "expected rss, vsz or growth";
+        return false;
+    }
+
+    if (i >= tokens.size()) {
+        error = "expected a comparison";
+        return false;
+    }
+    const std::string& op = tokens[i++];
+    if (op == ">") {
+        rule.compare = Compare::Greater;
+    } else if (op == ">=") {
+        rule.compare = Compare::GreaterEqual;
+    } else if (op == "<") {
+        rule.compare = Compare::Less;
+    } else {
+        rule.compare = Compare::LessEqual;
+    }
+
+    double number;
+    std::string unit;
+    if (!readQuantity(tokens, i, number, unit)) {
+        error = "expected a number after " + op;
+        return false;
+    }
+    if (rule.scope == Scope::Count) {
+        if (!unit.empty()) {
+            error = "count takes a plain number";
+            return false;
+        }
+        rule.threshold = number;
+    } else if (rule.metric == Metric::Growth) {
+        size_t slash = unit.find('/');
+        double multiplier;
+        double seconds = 1.0;
+        if (!sizeUnit(unit.substr(0, slash), multiplier)
+            || (slash != std::string::npos && !timeUnit(unit.substr(slash + 1), seconds))) {
+            error = "bad rate unit '" + unit + "' (e.g. 100MB/h)";
+            return false;
+        }
+        rule.threshold = number * multiplier / seconds;
+    } else if (unit == "%") {
+        rule.percent = true;
+        rule.threshold = number;
+    } else {
+        double multiplier;
+        if (!sizeUnit(unit, multiplier)) {
+            error = "bad size unit '" + unit + "'";
+            return false;
+        }
+        rule.threshold = number * multiplier;
+    }
+
+    if (i < tokens.size() && lower(tokens[i]) == "for") {
+        ++i;
+        double seconds;
+        if (!readQuantity(tokens, i, number, unit) || !timeUnit(unit, seconds) || number < 0) {
+            error = "expected a duration after 'for' (e.g. 30s)";
+            return false;
+        }
+        rule.forMs = static_cast<uint64_t>(number * seconds * 1000.0);
+    }
+    if (i < tokens.size()) {
+        error = "unexpected '" + tokens[i] + "'";
+        return false;
+    }
+
+    if (rule.field != Field::Any) {
+        auto it = std::find(m_patterns.begin(), m_patterns.end(), pattern);
+        rule.pattern = static_cast<uint32_t>(it - m_patterns.begin());
+        if (it == m_patterns.end()) {
+            m_patterns.push_back(pattern);
+        }
+    }
+    return true;
+}
+
+bool AlertEngine::compile(const std::string& text, std::string& error) {
+    std::vector<Rule> rules;
+    std::vector<std::string> previousPatterns;
+    previousPatterns.swap(m_patterns);
+
+    size_t start = 0;
+    int lineNumber = 0;
+    while (start <= text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        ++lineNumber;
+        std::string line = trim(stripComment(text.substr(start, end - start)));
+        start = end + 1;
+        if (line.empty()) {
+            continue;
+        }
+
+        Rule rule;
+        std::string lineError;
+        if (!parseRule(line, rule, lineError) || rules.size() == kMaxRules) {
+            if (lineError.empty()) {
+                lineError = "too many rules";
+            }
+            error = "line " + std::to_string(lineNumber) + ": " + lineError;
+            m_patterns.swap(previousPatterns);
+            return false;
+        }
+        rules.push_back(std::move(rule));
+    }
+
+    // Rules that were raised will never be cleared by evaluate() now
+    static const std::string kReplaced = "rules replaced";
+    for (const Rule& rule : m_rules) {
+        if (rule.active && m_sink) {
+            m_sink->onAlert(AlertEvent{rule.name, false, kReplaced, 0});
+        }
+    }
+
+    m_rules = std::move(rules);
+    for (bool& need : m_needAll) {
+        need = false;
+    }
+    for (const Rule& rule : m_rules) {
+        if (rule.scope != Scope::System && rule.scope != Scope::Count && rule.field == Field::Any) {
+            m_needAll[static_cast<int>(rule.metric)] = true;
+        }
+    }
+    m_patternHits.assign(m_patterns.size(), 0);
+    m_pool.reset();  // re-index every string on the next evaluation
+    return true;
+}
+
+size_t AlertEngine::activeCount() const {
+    return std::count_if(m_rules.begin(), m_rules.end(), [](const Rule& rule) { return rule.active; });
+}
+
+void AlertEngine::indexStrings(const std::shared_ptr<const StringPool>& strings) {
+    const StringPool& pool = *strings;
+    if (m_pool != strings) {
+        m_pool = strings;
+        m_byName.offsets.assign(1, 0);
+        m_byName.rules.clear();
+        m_byPath.offsets.assign(1, 0);
+        m_byPath.rules.clear();
+    }
+
+    // Each new string is matched once against each distinct pattern
+    for (size_t id = m_byName.offsets.size() - 1; id < pool.size(); ++id) {
+        const std::string& value = pool.str(static_cast<uint32_t>(id));
+        for (size_t p = 0; p < m_patterns.size(); ++p) {
+            const std::string& pattern = m_patterns[p];
+            m_patternHits[p] = isGlob(pattern)
+                ? fnmatch(pattern.c_str(), value.c_str(), 0) == 0
+                : pattern == value;
+        }
+        for (size_t r = 0; r < m_rules.size(); ++r) {
+            const Rule& rule = m_rules[r];
+            if (rule.field != Field::Any && m_patternHits[rule.pattern]) {
+                RuleIndex& index = rule.field == Field::Name ? m_byName : m_byPath;
+                index.rules.push_back(static_cast<uint16_t>(r));
+            }
+        }
+        m_byName.offsets.push_back(static_cast<uint32_t>(m_byName.rules.size()));
+        m_byPath.offsets.push_back(static_cast<uint32_t>(m_byPath.rules.size()));
+    }
+}
+
+void AlertEngine::evaluate(const MemorySnapshot& snapshot) {
+    if (m_rules.empty()) {
+        return;
+    }
+    indexStrings(snapshot.getStringPool());
+
+    for (Aggregate& aggregate : m_all) {
+        aggregate.reset();
+    }
+    for (Rule& rule : m_rules) {
+        rule.aggregate.reset();
+    }
+
+    const auto& residentSizes = snapshot.getResidentSizes();
+    const auto& virtualSizes = snapshot.getVirtualSizes();
+    const auto& growthRates = snapshot.getGrowthRates();
+    const auto& nameIds = snapshot.getNameIds();
+    const auto& pathIds = snapshot.getPathIds();
+    const uint32_t *nameOffsets = m_byName.offsets.data();
+    const uint32_t *pathOffsets = m_byPath.offsets.data();
+    const uint16_t *nameRules = m_byName.rules.data();
+    const uint16_t *pathRules = m_byPath.rules.data();
+    size_t count = snapshot.getProcessCount();
+    bool haveRates = growthRates.size() == count;
+
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t row = static_cast<uint32_t>(i);
+        double values[static_cast<int>(Metric::MetricCount)] = {
+            static_cast<double>(residentSizes[i]),
+            static_cast<double>(virtualSizes[i]),
+            haveRates ? growthRates[i] : 0.0,
+        };
+        for (int m = 0; m < static_cast<int>(Metric::MetricCount); ++m) {
+            if (m_needAll[m]) {
+                m_all[m].add(values[m], row);
+            }
+        }
+        for (uint32_t k = nameOffsets[nameIds[i]]; k < nameOffsets[nameIds[i] + 1]; ++k) {
+            Rule& rule = m_rules[nameRules[k]];
+            rule.aggregate.add(values[static_cast<int>(rule.metric)], row);
+        }
+        for (uint32_t k = pathOffsets[pathIds[i]]; k < pathOffsets[pathIds[i] + 1]; ++k) {
+            Rule& rule = m_rules[pathRules[k]];
+            rule.aggregate.add(values[static_cast<int>(rule.metric)], row);
+        }
+    }
+
+    double totalRAM = static_cast<double>(snapshot.getTotalPhysicalRAM());
+    for (Rule& rule : m_rules) {
+        const Aggregate& aggregate = rule.field == Field::Any
+            ? m_all[static_cast<int>(rule.metric)] : rule.aggregate;
+        bool greater = rule.compare == Compare::Greater || rule.compare == Compare::GreaterEqual;
+        double value;
+        switch (rule.scope) {
+        case Scope::Process:
+            value = aggregate.count == 0 ? std::numeric_limits<double>::quiet_NaN()
+                : greater ? aggregate.max : aggregate.min;
+            break;
+        case Scope::Sum:
+            value = aggregate.sum;
+            break;
+        case Scope::Count:
+            value = static_cast<double>(rule.field == Field::Any ? count : aggregate.count);
+            break;
+        case Scope::System:
+        default:
+            switch (rule.counter) {
+            case Counter::Free: value = static_cast<double>(snapshot.getFreeMemory()); break;
+            case Counter::Used: value = static_cast<double>(snapshot.getUsedMemory()); break;
+            case Counter::Active: value = static_cast<double>(snapshot.getActiveMemory()); break;
+            case Counter::Inactive: value = static_cast<double>(snapshot.getInactiveMemory()); break;
+            case Counter::Wired:
+            default: value = static_cast<double>(snapshot.getWiredMemory()); break;
+            }
+            break;
+        }
+        double threshold = rule.percent ? rule.threshold * totalRAM / 100.0 : rule.threshold;
+        update(rule, value, threshold, snapshot);
+    }
+}
+
+void AlertEngine::update(Rule& rule, double value, double threshold, const MemorySnapshot& snapshot) {
+    // An active rule holds until the value is back past the threshold by
+    // the hysteresis margin; NaN (no matching process) never holds
+    double margin = rule.active ? std::fabs(threshold) * kHysteresis : 0.0;
+    bool holds;
+    switch (rule.compare) {
+    case Compare::Greater: holds = value > threshold - margin; break;
+    case Compare::GreaterEqual: holds = value >= threshold - margin; break;
+    case Compare::Less: holds = value < threshold + margin; break;
+    case Compare::LessEqual:
+    default: holds = value <= threshold + margin; break;
+    }
+
+    uint64_t nowMs = snapshot.getTimestampMs();
+    if (holds) {
+        if (!rule.holding) {
+            rule.holding = true;
+            rule.sinceMs = nowMs;
+        }
+        if (!rule.active && nowMs - rule.sinceMs >= rule.forMs) {
+            rule.active = true;
+            if (m_sink) {
+                m_sink->onAlert(AlertEvent{rule.name, true, describe(rule, value, threshold, snapshot), nowMs});
+            }
+        }
+    } else {
+        rule.holding = false;
+        if (rule.active) {
+            rule.active = false;
+            if (m_sink) {
+                m_sink->onAlert(AlertEvent{rule.name, false, describe(rule, value, threshold, snapshot), nowMs});
+            }
+        }
+    }
+}
+
+std::string AlertEngine::describe(const Rule& rule, double value, double threshold,
+                                  const MemorySnapshot& snapshot) const {
+    static const char *const kMetrics[] = {"RSS", "VSZ", "growth"};
+    static const char *const kCounters[] = {"free", "used", "active", "inactive", "wired"};
+    static const char *const kCompares[] = {">", ">=", "<", "<="};
+
+    bool rate = rule.scope != Scope::System && rule.metric == Metric::Growth;
+    auto format = [&](double amount) {
+        if (rule.scope == Scope::Count) {
+            return std::to_string(static_cast<uint64_t>(amount));
+        }
+        return rate ? formatRate(amount) : formatBytes(amount);
+    };
+
+    std::string subject;
+    switch (rule.scope) {
+    case Scope::Process: {
+        if (std::isnan(value)) {
+            return "no matching process";
+        }
+        const Aggregate& aggregate = rule.field == Field::Any
+            ? m_all[static_cast<int>(rule.metric)] : rule.aggregate;
+        bool greater = rule.compare == Compare::Greater || rule.compare == Compare::GreaterEqual;
+        ProcessRef process = snapshot.process(greater ? aggregate.maxRow : aggregate.minRow);
+        subject = process.getName() + " (pid " + std::to_string(process.getPid()) + ") "
+            + kMetrics[static_cast<int>(rule.metric)];
+        break;
+    }
+    case Scope::Sum:
+        subject = std::string("total ") + kMetrics[static_cast<int>(rule.metric)];
+        break;
+    case Scope::Count:
+        subject = "process count";
+        break;
+    case Scope::System:
+        subject = std::string(kCounters[static_cast<int>(rule.counter)]) + " memory";
+        break;
+    }
+    return subject + " " + format(value) + " (limit " + kCompares[static_cast<int>(rule.compare)]
+        + " " + format(threshold) + ")";
+}
@@ -0,0 +1,27 @@
+// Global operator new replacement feeding Instrumentation::threadAllocations().
+// Linked into the executables only (not MemoryMonitorCore), so tools that
+// count allocations themselves, like MemoryBench, keep their own.
+
+#include "Instrumentation.h"
+#include <cstdlib>
+#include <new>
+
+#if MEMORYMONITOR_INSTRUMENTATION
+
+void *operator new(size_t size) {
+    Instrumentation::countAllocation();
+    if (void *memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+#endif
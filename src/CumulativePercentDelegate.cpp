@@ -0,0 +1,28 @@
+#include "CumulativePercentDelegate.h"
+#include "ProcessTableModel.h"
+#include <QColor>
+#include <QPalette>
+
+CumulativePercentDelegate::CumulativePercentDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void CumulativePercentDelegate::initStyleOption(QStyleOptionViewItem *option,
+                                                const QModelIndex& index) const {
+    QStyledItemDelegate::initStyleOption(option, index);
+
+    double cumulativePercent = index.data(ProcessTableModel::SortRole).toDouble();
+
+    // Color code cumulative percentage with better contrast
+    if (cumulativePercent > 75.0) {
+        option->backgroundBrush = QColor(255, 180, 180);  // Light red
+    } else if (cumulativePercent > 50.0) {
+        option->backgroundBrush = QColor(255, 255, 180);  // Light yellow
+    } else if (cumulativePercent > 25.0) {
+        option->backgroundBrush = QColor(180, 255, 180);  // Light green
+    } else {
+        option->backgroundBrush = QColor(240, 240, 240);  // Light gray
+    }
+    option->palette.setColor(QPalette::Text, QColor(0, 0, 0));  // Black text
+}
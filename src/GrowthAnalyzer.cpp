@@ -0,0 +1,179 @@
+#include "GrowthAnalyzer.h"
+#include <algorithm>
+
+GrowthAnalyzer::GrowthAnalyzer(uint32_t window, double threshold)
+    : m_window(std::max<uint32_t>(window, 2))
+    , m_threshold(threshold)
+    , m_tick(0)
+    , m_delta(0.0)
+{
+    clear();
+}
+
+void GrowthAnalyzer::setWindow(uint32_t samples) {
+    m_window = std::max<uint32_t>(samples, 2);
+    clear();
+}
+
+void GrowthAnalyzer::clear() {
+    m_states.clear();
+    m_values.clear();
+    m_freeSlots.clear();
+    m_slotByKey.clear();
+    m_rowSlots.clear();
+    m_times.assign(m_window + 1, 0);
+    m_sumX.assign(m_window + 1, 0.0);
+    m_sumXX.assign(m_window + 1, 0.0);
+    m_tick = 0;
+    m_delta = 0.0;
+}
+
+double GrowthAnalyzer::x(uint64_t tick) const {
+    // Exact from the integer times, so the window never drifts
+    int64_t ms = static_cast<int64_t>(m_times[tick % m_times.size()])
+        - static_cast<int64_t>(m_times[m_tick % m_times.size()]);
+    return ms / 1000.0;
+}
+
+uint32_t GrowthAnalyzer::slotFor(const ProcessKey& key) {
+    auto inserted = m_slotByKey.try_emplace(key, 0);
+    if (!inserted.second) {
+        return inserted.first->second;
+    }
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(m_states.size());
+        m_states.emplace_back();
+        m_values.resize(m_values.size() + m_window);
+    }
+    State& state = m_states[slot];
+    state = State{};
+    state.key = key;
+    state.used = true;
+    inserted.first->second = slot;
+    return slot;
+}
+
+void GrowthAnalyzer::release(uint32_t slot) {
+    m_slotByKey.erase(m_states[slot].key);
+    m_states[slot].used = false;
+    m_freeSlots.push_back(slot);
+}
+
+void GrowthAnalyzer::recompute(State& state, const uint32_t *ring) const {
+    // Re-derive the running sums, oldest sample first
+    state.sumY = 0.0;
+    state.sumXY = 0.0;
+    uint32_t oldest = (state.head + m_window - state.count) % m_window;
+    for (uint32_t j = 0; j < state.count; ++j) {
+        double value = ring[(oldest + j) % m_window];
+        state.sumY += value;
+        state.sumXY += x(m_tick - (state.count - 1 - j)) * value;
+    }
+}
+
+void GrowthAnalyzer::update(const MemorySnapshot& snapshot, std::vector<float>& rates,
+                            std::vector<uint32_t>& growing) {
+    ++m_tick;
+    uint64_t previousMs = m_times[(m_tick - 1) % m_times.size()];
+    uint64_t nowMs = snapshot.getTimestampMs();
+    m_times[m_tick % m_times.size()] = nowMs;
+    m_delta = m_tick > 1 && nowMs > previousMs ? (nowMs - previousMs) / 1000.0 : 0.0;
+
+    // Per window length n: sums over the newest n sample times, shared by
+    // every process whose window holds n samples
+    for (uint32_t n = 1; n <= m_window && n <= m_tick; ++n) {
+        double xn = x(m_tick - (n - 1));
+        m_sumX[n] = m_sumX[n - 1] + xn;
+        m_sumXX[n] = m_sumXX[n - 1] + xn * xn;
+    }
+
+    for (const ProcessKey& key : snapshot.getRemovedProcesses()) {
+        auto it = m_slotByKey.find(key);
+        if (it != m_slotByKey.end()) {
+            release(it->second);
+        }
+    }
+
+    const auto& pids = snapshot.getPids();
+    const auto& startTimes = snapshot.getStartTimes();
+    const auto& residentSizes = snapshot.getResidentSizes();
+    size_t count = pids.size();
+    rates.resize(count);
+    growing.clear();
+    m_rowSlots.resize(count, kNoSlot);
+
+    const float alpha = 2.0f / (m_window + 1);
+    for (size_t i = 0; i < count; ++i) {
+        ProcessKey key{pids[i], startTimes[i]};
+
+        // Rows rarely move between samples, so the hash lookup is the
+        // exception
+        uint32_t slot = m_rowSlots[i];
+        if (slot == kNoSlot || slot >= m_states.size() || !m_states[slot].used || !(m_states[slot].key == key)) {
+            slot = slotFor(key);
+            m_rowSlots[i] = slot;
+        }
+        State& state = m_states[slot];
+        uint32_t *ring = &m_values[static_cast<size_t>(slot) * m_window];
+        uint32_t value = static_cast<uint32_t>(std::min<uint64_t>(residentSizes[i] >> 10, UINT32_MAX));
+
+        if (state.count > 0 && state.lastTick + 1 == m_tick && m_delta > 0.0) {
+            // Every x moves back by delta
+            state.sumXY -= m_delta * state.sumY;
+            float instant = static_cast<float>((static_cast<double>(value) - state.lastValue) / m_delta);
+            state.ewma += alpha * (instant - state.ewma);
+        } else {
+            state.count = 0;
+            state.head = 0;
+            state.sumY = 0.0;
+            state.sumXY = 0.0;
+            state.ewma = 0.0f;
+            state.flagged = false;
+        }
+
+        if (state.count == m_window) {
+            uint32_t oldest = ring[state.head];
+            state.sumY -= oldest;
+            state.sumXY -= x(m_tick - m_window) * oldest;
+        } else {
+            ++state.count;
+        }
+        ring[state.head] = value;
+        state.head = (state.head + 1) % m_window;
+        state.sumY += value;
+        state.lastValue = value;
+        state.lastTick = m_tick;
+        if (state.head == slot % m_window) {
+            // Once per window, staggered by slot so the O(window) passes
+            // don't all land on the same sample
+            recompute(state, ring);
+        }
+
+        double slope = 0.0;
+        uint32_t n = state.count;
+        if (n >= 2) {
+            double denominator = n * m_sumXX[n] - m_sumX[n] * m_sumX[n];
+            if (denominator > 0.0) {
+                slope = (n * state.sumXY - m_sumX[n] * state.sumY) / denominator * 1024.0;
+            }
+        }
+        rates[i] = static_cast<float>(slope);
+
+        if (!state.flagged) {
+            state.flagged = n == m_window && slope >= m_threshold && state.ewma > 0.0f;
+        } else if (slope < m_threshold / 2) {
+            state.flagged = false;
+        }
+        if (state.flagged) {
+            growing.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    std::sort(growing.begin(), growing.end(), [&rates](uint32_t a, uint32_t b) {
+        return rates[a] > rates[b];
+    });
+}
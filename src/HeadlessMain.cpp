@@ -0,0 +1,285 @@
+// Headless collector: samples with SystemMonitor on a timer and streams
+// every snapshot as NDJSON or CSV, without any widgets.
+//
+// Usage: MemoryMonitorHeadless [--interval ms] [--top N] [--format ndjson|csv]
+//                              [--output file] [--count samples]
+//                              [--buffer bytes] [--workers n] [--proc-root dir]
+//                              [--record file] [--rollups file]
+//                              [--alerts file] [--diagnostics samples]
+//                              [--metrics [host:]port] [--metrics-socket path]
+//                              [--metrics-top N] [--adaptive] [--cpu-budget percent]
+//                              [--no-process-events] [--io-uring]
+//                              [--pressure-stall ms] [--pressure-window ms]
+//                              [--pressure-cgroup dir]...
+//
+// Alert rules (see AlertEngine) are reported on stderr as they are raised
+// and cleared. --diagnostics prints the pipeline timing and counter table
+// (see Instrumentation) to stderr every N samples and on exit. --metrics and
+// --metrics-socket serve the latest sample to Prometheus (see MetricsServer);
+// a bare port binds 127.0.0.1 only. Samples come at the fixed interval
+// unless --adaptive lets RefreshScheduler vary it; --cpu-budget stretches
+// the interval whenever a cycle costs more than that share of one core.
+// --no-process-events lists every pid per sample instead of following
+// process starts and exits (see ProcessEventSource). --io-uring re-reads
+// known processes in batched io_uring submissions (see IoUringReader).
+// --pressure-stall registers Linux PSI triggers (see PressureMonitor): each
+// stall is reported on stderr at once and an extra sample is taken and
+// flushed, showing the processes that were large at that moment.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QDebug>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Instrumentation.h"
+#include "MetricsServer.h"
+#include "SampleWriter.h"
+#include "SystemMonitor.h"
+
+namespace {
+
+// Intervals below this would mostly measure the collector itself
+constexpr int kMinIntervalMs = 10;
+
+int signalPipe[2] = {-1, -1};
+
+void onTerminationSignal(int) {
+    char byte = 1;
+    ssize_t ignored = ::write(signalPipe[1], &byte, 1);
+    (void)ignored;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("MemoryMonitor");
+    QCoreApplication::setApplicationName("Memory Monitor Headless");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Streams memory samples as NDJSON or CSV.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption intervalOption({"i", "interval"}, "Sampling interval in milliseconds.", "ms", "1000");
+    QCommandLineOption topOption({"n", "top"}, "Only write the N largest processes (0 = all).", "N", "0");
+    QCommandLineOption formatOption({"f", "format"}, "Output format: ndjson or csv.", "format", "ndjson");
+    QCommandLineOption outputOption({"o", "output"}, "Append to file instead of stdout.", "file");
+    QCommandLineOption countOption({"c", "count"}, "Stop after this many samples (0 = run until signalled).", "samples", "0");
+    QCommandLineOption bufferOption("buffer", "Bytes to buffer before writing (0 = write every sample).", "bytes", "65536");
+    QCommandLineOption workersOption("workers", "Process scan threads (0 = one per core).", "n", "1");
+    QCommandLineOption procRootOption("proc-root", "Read processes from this procfs tree (Linux).", "dir");
+    QCommandLineOption recordOption("record", "Also write every sample to a binary recording.", "file");
+    QCommandLineOption rollupsOption("rollups", "Keep minute/hour rollups in this file across runs.", "file");
+    QCommandLineOption alertsOption("alerts", "Evaluate the alert rules in this file on every sample.", "file");
+    QCommandLineOption diagnosticsOption("diagnostics",
+        "Print pipeline timings to stderr every N samples and on exit (0 = on exit only).", "samples");
+    QCommandLineOption metricsOption("metrics", "Serve Prometheus metrics over HTTP on [host:]port.", "[host:]port");
+    QCommandLineOption metricsSocketOption("metrics-socket", "Serve Prometheus metrics on this Unix socket.", "path");
+    QCommandLineOption metricsTopOption("metrics-top", "Processes to export per scrape.", "N", "20");
+    QCommandLineOption adaptiveOption("adaptive", "Sample faster while memory changes quickly, slower when idle.");
+    QCommandLineOption cpuBudgetOption("cpu-budget", "Percent of one core the collector may use (0 = no limit).", "percent", "0");
+    QCommandLineOption noEventsOption("no-process-events", "List every pid per sample instead of following process events.");
+    QCommandLineOption ioUringOption("io-uring", "Read per-process files in batches through io_uring where available.");
+    QCommandLineOption pressureStallOption("pressure-stall",
+        "Sample at once when tasks stall on memory this long within a window (Linux PSI; 0 = off).", "ms", "0");
+    QCommandLineOption pressureWindowOption("pressure-window", "Window for --pressure-stall.", "ms", "2000");
+    QCommandLineOption pressureCgroupOption("pressure-cgroup",
+        "Also watch this cgroup v2 directory's memory.pressure (repeatable).", "dir");
+    parser.addOptions({intervalOption, topOption, formatOption, outputOption,
+                       countOption, bufferOption, workersOption, procRootOption, recordOption,
+                       rollupsOption, alertsOption, diagnosticsOption,
+                       metricsOption, metricsSocketOption, metricsTopOption,
+                       adaptiveOption, cpuBudgetOption, noEventsOption, ioUringOption,
+                       pressureStallOption, pressureWindowOption, pressureCgroupOption});
+    parser.process(app);
+
+    int intervalMs = parser.value(intervalOption).toInt();
+    if (intervalMs < kMinIntervalMs) {
+        qCritical() << "Interval must be at least" << kMinIntervalMs << "ms";
+        return 1;
+    }
+
+    SampleWriter::Format format;
+    QString formatName = parser.value(formatOption);
+    if (formatName == "ndjson") {
+        format = SampleWriter::Format::Ndjson;
+    } else if (formatName == "csv") {
+        format = SampleWriter::Format::Csv;
+    } else {
+        qCritical() << "Unknown format" << formatName;
+        return 1;
+    }
+
+    QString alertRules;
+    if (parser.isSet(alertsOption)) {
+        QFile rulesFile(parser.value(alertsOption));
+        if (!rulesFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qCritical() << "Cannot open" << parser.value(alertsOption);
+            return 1;
+        }
+        alertRules = QString::fromUtf8(rulesFile.readAll());
+    }
+
+    if (parser.isSet(procRootOption)) {
+        ProcessCollector::setProcRoot(parser.value(procRootOption).toStdString());
+    }
+
+    size_t topCount = parser.value(topOption).toULongLong();
+    uint64_t sampleLimit = parser.value(countOption).toULongLong();
+    size_t bufferSize = parser.value(bufferOption).toULongLong();
+    bool diagnostics = parser.isSet(diagnosticsOption);
+    uint64_t diagnosticsEvery = parser.value(diagnosticsOption).toULongLong();
+    if (diagnostics && !Instrumentation::enabled()) {
+        qWarning() << "Built without MEMORYMONITOR_INSTRUMENTATION; --diagnostics has nothing to show";
+    }
+
+    QString metricsHost = "127.0.0.1";
+    uint16_t metricsPort = 0;
+    if (parser.isSet(metricsOption)) {
+        QString address = parser.value(metricsOption);
+        int colon = address.lastIndexOf(':');
+        if (colon >= 0) {
+            metricsHost = address.left(colon);
+            address = address.mid(colon + 1);
+        }
+        bool ok = false;
+        metricsPort = address.toUShort(&ok);
+        if (!ok) {
+            qCritical() << "Invalid metrics port" << address;
+            return 1;
+        }
+    }
+
+    int fd = STDOUT_FILENO;
+    if (parser.isSet(outputOption)) {
+        QByteArray path = parser.value(outputOption).toLocal8Bit();
+        fd = ::open(path.constData(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            qCritical() << "Cannot open" << parser.value(outputOption);
+            return 1;
+        }
+    }
+
+    // Quit through the event loop on SIGINT / SIGTERM so the buffer is flushed
+    if (::pipe(signalPipe) != 0) {
+        qCritical() << "Cannot create signal pipe";
+        return 1;
+    }
+    std::signal(SIGINT, onTerminationSignal);
+    std::signal(SIGTERM, onTerminationSignal);
+    QSocketNotifier signalNotifier(signalPipe[0], QSocketNotifier::Read);
+    QObject::connect(&signalNotifier, &QSocketNotifier::activated, &app, &QCoreApplication::quit);
+
+    int exitCode = 0;
+    {
+        SampleWriter writer(fd, format, bufferSize);
+
+        // Collect on the main thread: there is no UI to keep responsive
+        SystemMonitor monitor;
+        monitor.setScanWorkerCount(parser.value(workersOption).toInt());
+
+        // Connected first: recording, rollup and rule setup report errors
+        // synchronously
+        QObject::connect(&monitor, &SystemMonitor::errorOccurred, [](const QString& error) {
+            qWarning() << error;
+        });
+        QObject::connect(&monitor, &SystemMonitor::alertChanged,
+                         [](const QString& rule, bool active, const QString& message) {
+            qWarning().noquote() << (active ? "ALERT" : "CLEARED") << rule + ":" << message;
+        });
+
+        if (parser.isSet(recordOption) && !monitor.startRecording(parser.value(recordOption))) {
+            return 1;  // asked for a recording; streaming without one would hide that
+        }
+        if (parser.isSet(rollupsOption)) {
+            monitor.setRollupPath(parser.value(rollupsOption));
+        }
+
+        uint64_t samples = 0;
+        QObject::connect(&monitor, &SystemMonitor::dataReady, [&]() {
+            SnapshotPtr snapshot = monitor.snapshot();
+            if (!writer.write(*snapshot, snapshot->getTimestampMs(), topCount)) {
+                qCritical() << "Write failed, stopping";
+                exitCode = 1;
+                app.quit();
+                return;
+            }
+            // Stall samples go out now rather than with the next buffer
+            if (snapshot->getPressureStallCount() > 0 && !writer.flush()) {
+                qCritical() << "Write failed, stopping";
+                exitCode = 1;
+                app.quit();
+                return;
+            }
+            ++samples;
+            if (diagnostics && diagnosticsEvery > 0 && samples % diagnosticsEvery == 0) {
+                std::fputs(Instrumentation::instance().report().c_str(), stderr);
+            }
+            if (sampleLimit > 0 && samples >= sampleLimit) {
+                app.quit();
+            }
+        });
+        if (parser.isSet(alertsOption)) {
+            monitor.setAlertRules(alertRules);
+        }
+        QObject::connect(&monitor, &SystemMonitor::pressureStall,
+                         [](const QString& source, const QString& message) {
+            qWarning().noquote() << "STALL" << source + ":" << message;
+        });
+        int pressureStallMs = parser.value(pressureStallOption).toInt();
+        if (pressureStallMs > 0) {
+            QString error;
+            if (!monitor.setPressureTrigger(pressureStallMs, parser.value(pressureWindowOption).toInt(),
+                                            parser.values(pressureCgroupOption), &error)) {
+                qCritical().noquote() << error;
+                return 1;
+            }
+        }
+
+        // Scrapes read the published snapshot from the server's own thread
+        MetricsServer metrics([&monitor]() { return monitor.snapshot(); },
+                              parser.value(metricsTopOption).toULongLong());
+        if (parser.isSet(metricsOption) || parser.isSet(metricsSocketOption)) {
+            std::string error;
+            bool listening = (!parser.isSet(metricsOption)
+                              || metrics.listenTcp(metricsHost.toStdString(), metricsPort, error))
+                && (!parser.isSet(metricsSocketOption)
+                    || metrics.listenUnix(parser.value(metricsSocketOption).toStdString(), error))
+                && metrics.start(error);
+            if (!listening) {
+                qCritical().noquote() << QString::fromStdString(error);
+                return 1;
+            }
+        }
+
+        if (parser.isSet(noEventsOption)) {
+            monitor.setProcessEvents(false);
+        }
+        monitor.setBatchedReads(parser.isSet(ioUringOption));
+        monitor.setAdaptiveRefresh(parser.isSet(adaptiveOption));
+        monitor.setCpuBudget(parser.value(cpuBudgetOption).toDouble());
+        monitor.setRefreshInterval(intervalMs);
+        monitor.requestCollect();
+
+        int result = app.exec();
+        if (exitCode == 0) {
+            exitCode = result;
+        }
+        if (!writer.flush()) {
+            exitCode = 1;
+        }
+        if (diagnostics) {
+            std::fputs(Instrumentation::instance().report().c_str(), stderr);
+        }
+    }
+
+    if (fd != STDOUT_FILENO) {
+        ::close(fd);
+    }
+    return exitCode;
+}
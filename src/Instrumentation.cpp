@@ -0,0 +1,155 @@
+#include "Instrumentation.h"
+#include <cstdio>
+#include <limits>
+
+thread_local uint64_t Instrumentation::t_allocations = 0;
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+size_t LatencyHistogram::bucketFor(uint64_t ns) {
+    if (ns < kSubBuckets) {
+        return static_cast<size_t>(ns);
+    }
+    int exponent = 63 - __builtin_clzll(ns);
+    int shift = exponent - kSubBucketBits;
+    uint64_t subBucket = (ns >> shift) & (kSubBuckets - 1);
+    return static_cast<size_t>((exponent - kSubBucketBits + 1) * kSubBuckets + subBucket);
+}
+
+uint64_t LatencyHistogram::lowestValue(size_t bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    int exponent = static_cast<int>(bucket / kSubBuckets) + kSubBucketBits - 1;
+    uint64_t subBucket = bucket % kSubBuckets;
+    return (kSubBuckets + subBucket) << (exponent - kSubBucketBits);
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    m_buckets[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t current = m_min.load(std::memory_order_relaxed);
+    while (ns < current && !m_min.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+    }
+    current = m_max.load(std::memory_order_relaxed);
+    while (ns > current && !m_max.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Summary LatencyHistogram::summarize() const {
+    Summary summary;
+    summary.count = m_count.load(std::memory_order_relaxed);
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.min = m_min.load(std::memory_order_relaxed);
+    summary.max = m_max.load(std::memory_order_relaxed);
+    summary.mean = m_sum.load(std::memory_order_relaxed) / summary.count;
+
+    // Bucket midpoints, clamped to the exact extremes
+    struct Target { double quantile; uint64_t *value; };
+    const Target targets[] = {
+        {0.50, &summary.p50},
+        {0.90, &summary.p90},
+        {0.99, &summary.p99},
+    };
+    uint64_t seen = 0;
+    size_t next = 0;
+    for (size_t bucket = 0; bucket < kBucketCount && next < 3; ++bucket) {
+        seen += m_buckets[bucket].load(std::memory_order_relaxed);
+        while (next < 3 && seen >= static_cast<uint64_t>(targets[next].quantile * summary.count + 0.5)
+               && seen > 0) {
+            uint64_t low = lowestValue(bucket);
+            uint64_t width = bucket + 1 < kBucketCount ? lowestValue(bucket + 1) - low : 1;
+            uint64_t value = low + width / 2;
+            *targets[next].value = value < summary.min ? summary.min
+                : value > summary.max ? summary.max : value;
+            ++next;
+        }
+    }
+    return summary;
+}
+
+Instrumentation::Instrumentation() {
+    for (auto& counter : m_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+Instrumentation& Instrumentation::instance() {
+    static Instrumentation instrumentation;
+    return instrumentation;
+}
+
+const char *Instrumentation::phaseName(Phase phase) {
+    static const char *const kNames[PhaseCount] = {
+        "collect", "system_memory", "enumerate", "read", "apply", "publish",
+        "growth", "accounting", "alerts", "history", "rollups", "sort", "table_update", "cumulative",
+    };
+    return phase < PhaseCount ? kNames[phase] : "";
+}
+
+const char *Instrumentation::counterName(Counter counter) {
+    static const char *const kNames[CounterCount] = {
+        "pids_scanned", "pids_vanished", "pids_failed", "bytes_read", "allocations", "rows_touched",
+        "full_scans", "proc_events", "short_lived", "syscalls", "strings_dropped",
+        "string_compactions",
+    };
+    return counter < CounterCount ? kNames[counter] : "";
+}
+
+void Instrumentation::reset() {
+    for (auto& histogram : m_phases) {
+        histogram.reset();
+    }
+    for (auto& counter : m_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::string Instrumentation::report() const {
+    std::string out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-14s %8s %10s %10s %10s %10s %10s\n",
+                  "phase (ms)", "count", "mean", "p50", "p90", "p99", "max");
+    out += line;
+    for (int phase = 0; phase < PhaseCount; ++phase) {
+        LatencyHistogram::Summary s = m_phases[phase].summarize();
+        if (s.count == 0) {
+            continue;
+        }
+        std::snprintf(line, sizeof(line), "%-14s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                      phaseName(static_cast<Phase>(phase)), static_cast<unsigned long long>(s.count),
+                      s.mean / 1e6, s.p50 / 1e6, s.p90 / 1e6, s.p99 / 1e6, s.max / 1e6);
+        out += line;
+    }
+
+    // Per collection, where there were any
+    uint64_t samples = m_phases[CollectPhase].summarize().count;
+    for (int counter = 0; counter < CounterCount; ++counter) {
+        uint64_t total = this->counter(static_cast<Counter>(counter));
+        std::snprintf(line, sizeof(line), "%-14s %14llu", counterName(static_cast<Counter>(counter)),
+                      static_cast<unsigned long long>(total));
+        out += line;
+        if (samples > 0) {
+            std::snprintf(line, sizeof(line), "  (%.1f per sample)", static_cast<double>(total) / samples);
+            out += line;
+        }
+        out += '\n';
+    }
+    return out;
+}
@@ -0,0 +1,477 @@
+#include "LinuxProcessCollector.h"
+#include "ProcessInfo.h"
+#include "Instrumentation.h"
+#include "IoUringReader.h"
+#include "PressureMonitor.h"
+#include "SmapsParser.h"
+#include <algorithm>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+
+constexpr size_t kMappingBufferSize = 256 * 1024;
+constexpr size_t kStatNameSize = 24;  // "<pid>/stat"
+
+// Kernel layout of the records returned by getdents64
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Parses a decimal at p, advancing p past it
+uint64_t parseDecimal(const char *&p, const char *end) {
+    uint64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+    }
+    return value;
+}
+
+// Returns the pid for a purely numeric /proc entry name, 0 otherwise
+pid_t parsePidName(const char *name) {
+    pid_t pid = 0;
+    for (const char *p = name; *p; ++p) {
+        if (*p < '0' || *p > '9') {
+            return 0;
+        }
+        pid = pid * 10 + (*p - '0');
+    }
+    return pid;
+}
+
+} // namespace
+
+LinuxProcessCollector::LinuxProcessCollector(const std::string& procRoot)
+    : m_procFd(open(procRoot.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+    , m_meminfoFd(m_procFd >= 0 ? openat(m_procFd, "meminfo", O_RDONLY | O_CLOEXEC) : -1)
+    , m_pressureFd(m_procFd >= 0 ? openat(m_procFd, "pressure/memory", O_RDONLY | O_CLOEXEC) : -1)
+    , m_pageSize(static_cast<uint64_t>(sysconf(_SC_PAGESIZE)))
+{
+}
+
+// Out of line so IoUringReader can stay an incomplete type in the header
+LinuxProcessCollector::~LinuxProcessCollector() {
+    if (m_procFd >= 0) {
+        close(m_procFd);
+    }
+    if (m_meminfoFd >= 0) {
+        close(m_meminfoFd);
+    }
+    if (m_pressureFd >= 0) {
+        close(m_pressureFd);
+    }
+}
+
+uint64_t LinuxProcessCollector::queryTotalPhysicalRAM() {
+    // MemTotal is the first line; reading it keeps fixture roots self-contained
+    if (m_meminfoFd >= 0) {
+        ssize_t length = pread(m_meminfoFd, m_readBuffer, sizeof(m_readBuffer) - 1, 0);
+        if (length > 9 && memcmp(m_readBuffer, "MemTotal:", 9) == 0) {
+            const char *p = m_readBuffer + 9;
+            const char *end = m_readBuffer + length;
+            while (p < end && *p == ' ') {
+                ++p;
+            }
+            return parseDecimal(p, end) * 1024;
+        }
+    }
+
+    long pages = sysconf(_SC_PHYS_PAGES);
+    return pages > 0 ? static_cast<uint64_t>(pages) * m_pageSize : 0;
+}
+
+std::string LinuxProcessCollector::queryBootId() {
+    // A random UUID per boot; start times are clock ticks since boot
+    ssize_t length = m_procFd >= 0 ? readFileAt(m_procFd, "sys/kernel/random/boot_id") : -1;
+    while (length > 0 && m_readBuffer[length - 1] == '\n') {
+        --length;
+    }
+    return length > 0 ? std::string(m_readBuffer, static_cast<size_t>(length)) : std::string();
+}
+
+bool LinuxProcessCollector::collectSystemMemoryInfo(SystemMemoryInfo& info) {
+    if (m_meminfoFd < 0) {
+        return false;
+    }
+
+    // procfs regenerates the file on every read from offset 0
+    ssize_t length = pread(m_meminfoFd, m_readBuffer, sizeof(m_readBuffer) - 1, 0);
+    if (length <= 0) {
+        return false;
+    }
+    MM_INSTRUMENT(m_readStats.bytesRead += static_cast<uint64_t>(length));
+
+    // Linux has no "wired" counter; the closest equivalent is memory the
+    // kernel can't reclaim: unevictable pages plus kernel-owned allocations
+    uint64_t memFree = 0, active = 0, inactive = 0;
+    uint64_t unevictable = 0, slabUnreclaimable = 0, kernelStack = 0, pageTables = 0;
+    struct Field { const char *key; size_t keyLength; uint64_t *value; };
+    const Field fields[] = {
+        {"MemFree", 7, &memFree},
+        {"Active", 6, &active},
+        {"Inactive", 8, &inactive},
+        {"Unevictable", 11, &unevictable},
+        {"SUnreclaim", 10, &slabUnreclaimable},
+        {"KernelStack", 11, &kernelStack},
+        {"PageTables", 10, &pageTables},
+    };
+
+    const char *p = m_readBuffer;
+    const char *end = m_readBuffer + length;
+    while (p < end) {
+        const char *colon = static_cast<const char *>(memchr(p, ':', end - p));
+        if (!colon) {
+            break;
+        }
+        size_t keyLength = colon - p;
+        for (const Field& field : fields) {
+            if (field.keyLength == keyLength && memcmp(p, field.key, keyLength) == 0) {
+                const char *q = colon + 1;
+                while (q < end && *q == ' ') {
+                    ++q;
+                }
+                *field.value = parseDecimal(q, end) * 1024;  // values are in kB
+                break;
+            }
+        }
+        const char *newline = static_cast<const char *>(memchr(colon, '\n', end - colon));
+        if (!newline) {
+            break;
+        }
+        p = newline + 1;
+    }
+
+    info.freeMemory = memFree;
+    info.activeMemory = active;
+    info.inactiveMemory = inactive;
+    info.wiredMemory = unevictable + slabUnreclaimable + kernelStack + pageTables;
+
+    return true;
+}
+
+bool LinuxProcessCollector::collectMemoryPressure(PressureStats& stats) {
+    if (m_pressureFd < 0) {
+        return false;
+    }
+    ssize_t length = pread(m_pressureFd, m_readBuffer, sizeof(m_readBuffer) - 1, 0);
+    if (length <= 0) {
+        return false;
+    }
+    MM_INSTRUMENT(m_readStats.bytesRead += static_cast<uint64_t>(length));
+    return PressureMonitor::parseStats(m_readBuffer, static_cast<size_t>(length), stats);
+}
+
+bool LinuxProcessCollector::listProcesses(std::vector<pid_t>& pids) {
+    if (m_procFd < 0) {
+        return false;
+    }
+
+    pids.clear();
+    lseek(m_procFd, 0, SEEK_SET);
+
+    for (;;) {
+        long bytes = syscall(SYS_getdents64, m_procFd, m_direntBuffer, sizeof(m_direntBuffer));
+        MM_INSTRUMENT(++m_readStats.syscalls);
+        if (bytes < 0) {
+            return false;
+        }
+        if (bytes == 0) {
+            break;
+        }
+        MM_INSTRUMENT(m_readStats.bytesRead += static_cast<uint64_t>(bytes));
+
+        for (long offset = 0; offset < bytes;) {
+            const auto *entry = reinterpret_cast<const LinuxDirent64 *>(m_direntBuffer + offset);
+            offset += entry->d_reclen;
+
+            if (entry->d_type != DT_DIR) {
+                continue;
+            }
+            pid_t pid = parsePidName(entry->d_name);
+            if (pid > 0) {
+                pids.push_back(pid);
+            }
+        }
+    }
+
+    return !pids.empty();
+}
+
+ssize_t LinuxProcessCollector::readFileAt(int dirFd, const char *name) {
+    int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        MM_INSTRUMENT(countFailure(errno));
+        MM_INSTRUMENT(++m_readStats.syscalls);
+        return -1;
+    }
+    ssize_t length = read(fd, m_readBuffer, sizeof(m_readBuffer) - 1);
+    MM_INSTRUMENT(int readError = errno);
+    close(fd);
+    MM_INSTRUMENT(m_readStats.syscalls += 3);
+    if (length >= 0) {
+        m_readBuffer[length] = '\0';
+        MM_INSTRUMENT(m_readStats.bytesRead += static_cast<uint64_t>(length));
+    } else {
+        MM_INSTRUMENT(countFailure(readError));
+    }
+    return length;
+}
+
+void LinuxProcessCollector::countFailure(int error) {
+    // A pid directory that disappeared reads as ENOENT (or ESRCH mid-read)
+    if (error == ENOENT || error == ESRCH) {
+        ++m_readStats.vanished;
+    } else {
+        ++m_readStats.failed;
+    }
+}
+
+bool LinuxProcessCollector::parseStat(const char *buffer, ssize_t length, ProcessCounters& counters,
+                                      const char *&comm, size_t& commLength) {
+    // "pid (comm) state ppid ..."; comm may itself contain parentheses so
+    // bracket it by the first '(' and last ')'
+    const char *end = buffer + length;
+    const char *openParen = static_cast<const char *>(memchr(buffer, '(', length));
+    const char *closeParen = static_cast<const char *>(memrchr(buffer, ')', length));
+    if (!openParen || !closeParen || closeParen < openParen) {
+        return false;
+    }
+    comm = openParen + 1;
+    commLength = closeParen - openParen - 1;
+
+    // Fields after comm start at field 3 (state); we want 22 starttime
+    // (ticks since boot), 23 vsize (bytes) and 24 rss (pages)
+    const char *p = closeParen + 1;
+    for (int field = 3; field < 22; ++field) {
+        p = static_cast<const char *>(memchr(p + 1, ' ', end - p - 1));
+        if (!p) {
+            return false;
+        }
+    }
+    ++p;
+    counters.startTime = parseDecimal(p, end);
+    ++p;
+    counters.virtualSize = parseDecimal(p, end);
+    ++p;
+    counters.residentSize = parseDecimal(p, end) * m_pageSize;
+    return p < end;
+}
+
+bool LinuxProcessCollector::collectCounters(pid_t pid, ProcessCounters& counters) {
+    // A single "<pid>/stat" read carries identity and both memory counters
+    char statPath[32];
+    snprintf(statPath, sizeof(statPath), "%d/stat", static_cast<int>(pid));
+    ssize_t length = readFileAt(m_procFd, statPath);
+    if (length <= 0) {
+        // Process terminated since it was listed
+        MM_INSTRUMENT(if (length == 0) ++m_readStats.vanished);
+        return false;
+    }
+
+    const char *comm;
+    size_t commLength;
+    if (!parseStat(m_readBuffer, length, counters, comm, commLength)) {
+        MM_INSTRUMENT(++m_readStats.failed);
+        return false;
+    }
+    return true;
+}
+
+void LinuxProcessCollector::collectCountersBatch(const pid_t *pids, size_t count,
+                                                 ProcessCounters *counters, bool *ok) {
+    if (!m_uringTried) {
+        m_uringTried = true;
+        m_uring = IoUringReader::create();
+        if (m_uring) {
+            m_statNames.resize(IoUringReader::kSlotCount * kStatNameSize);
+        }
+    }
+    if (!m_uring) {
+        ProcessCollector::collectCountersBatch(pids, count, counters, ok);
+        return;
+    }
+
+    const char *names[IoUringReader::kSlotCount];
+    ssize_t lengths[IoUringReader::kSlotCount];
+    for (size_t begin = 0; begin < count; begin += IoUringReader::kSlotCount) {
+        size_t batch = std::min(count - begin, IoUringReader::kSlotCount);
+        for (size_t slot = 0; slot < batch; ++slot) {
+            char *name = m_statNames.data() + slot * kStatNameSize;
+            snprintf(name, kStatNameSize, "%d/stat", static_cast<int>(pids[begin + slot]));
+            names[slot] = name;
+        }
+
+        uint64_t syscalls = 0;
+        bool submitted = m_uring->readFiles(m_procFd, names, batch, lengths, syscalls);
+        MM_INSTRUMENT(m_readStats.syscalls += syscalls);
+        if (!submitted) {
+            // The ring broke (e.g. a signal storm or ENOMEM); stay synchronous
+            m_uring.reset();
+            ProcessCollector::collectCountersBatch(pids + begin, count - begin,
+                                                   counters + begin, ok + begin);
+            return;
+        }
+
+        for (size_t slot = 0; slot < batch; ++slot) {
+            ssize_t length = lengths[slot];
+            const char *comm;
+            size_t commLength;
+            if (length <= 0) {
+                MM_INSTRUMENT(if (length == 0) ++m_readStats.vanished; else countFailure(static_cast<int>(-length)));
+                ok[begin + slot] = false;
+            } else if (!parseStat(m_uring->slot(slot), length, counters[begin + slot], comm, commLength)) {
+                MM_INSTRUMENT(++m_readStats.failed);
+                ok[begin + slot] = false;
+            } else {
+                MM_INSTRUMENT(m_readStats.bytesRead += static_cast<uint64_t>(length));
+                ok[begin + slot] = true;
+            }
+        }
+    }
+}
+
+bool LinuxProcessCollector::collectAccounting(pid_t pid, ProcessAccounting& accounting) {
+    // smaps_rollup (Linux 4.14+) sums every mapping into one ~1 KB block
+    char rollupPath[40];
+    snprintf(rollupPath, sizeof(rollupPath), "%d/smaps_rollup", static_cast<int>(pid));
+    ssize_t length = readFileAt(m_procFd, rollupPath);
+    if (length <= 0) {
+        return false;
+    }
+
+    uint64_t pss = 0, privateClean = 0, privateDirty = 0, swap = 0;
+    bool havePss = false;
+    struct Field { const char *key; size_t keyLength; uint64_t *value; };
+    const Field fields[] = {
+        {"Pss", 3, &pss},
+        {"Private_Clean", 13, &privateClean},
+        {"Private_Dirty", 13, &privateDirty},
+        {"Swap", 4, &swap},
+    };
+
+    // First line is the address range header; fields follow as "Key: n kB"
+    const char *p = static_cast<const char *>(memchr(m_readBuffer, '\n', length));
+    const char *end = m_readBuffer + length;
+    while (p && ++p < end) {
+        const char *colon = static_cast<const char *>(memchr(p, ':', end - p));
+        if (!colon) {
+            break;
+        }
+        size_t keyLength = colon - p;
+        for (const Field& field : fields) {
+            if (field.keyLength == keyLength && memcmp(p, field.key, keyLength) == 0) {
+                const char *q = colon + 1;
+                while (q < end && *q == ' ') {
+                    ++q;
+                }
+                *field.value = parseDecimal(q, end) * 1024;
+                havePss |= field.value == &pss;
+                break;
+            }
+        }
+        p = static_cast<const char *>(memchr(colon, '\n', end - colon));
+    }
+    if (!havePss) {
+        MM_INSTRUMENT(++m_readStats.failed);
+        return false;
+    }
+
+    accounting.proportionalSize = pss;
+    accounting.uniqueSize = privateClean + privateDirty;
+    accounting.swapSize = swap;
+    return true;
+}
+
+bool LinuxProcessCollector::collectMappings(pid_t pid, SmapsParser& parser) {
+    // seq_file fills as many whole mappings as fit per read(), so a large
+    // buffer keeps the syscall count down for processes with 100k mappings
+    if (m_mappingBuffer.empty()) {
+        m_mappingBuffer.resize(kMappingBufferSize);
+    }
+
+    char smapsPath[32];
+    snprintf(smapsPath, sizeof(smapsPath), "%d/smaps", static_cast<int>(pid));
+    int fd = openat(m_procFd, smapsPath, O_RDONLY | O_CLOEXEC);
+    MM_INSTRUMENT(++m_readStats.syscalls);
+    if (fd < 0) {
+        MM_INSTRUMENT(countFailure(errno));
+        return false;
+    }
+
+    ssize_t length;
+    bool readAny = false;
+    while ((length = read(fd, m_mappingBuffer.data(), m_mappingBuffer.size())) > 0) {
+        parser.feed(m_mappingBuffer.data(), static_cast<size_t>(length));
+        MM_INSTRUMENT(m_readStats.bytesRead += static_cast<uint64_t>(length));
+        MM_INSTRUMENT(++m_readStats.syscalls);
+        readAny = true;
+    }
+    MM_INSTRUMENT(int readError = errno);
+    close(fd);
+    MM_INSTRUMENT(m_readStats.syscalls += 2);  // the final read and close
+    if (length < 0) {
+        MM_INSTRUMENT(countFailure(readError));
+        return false;
+    }
+    // Kernel threads and zombies have an empty smaps
+    return readAny;
+}
+
+bool LinuxProcessCollector::collectProcess(pid_t pid, ProcessInfo& info) {
+    info.setPid(pid);
+    info.setValid(false);
+
+    char pidName[16];
+    snprintf(pidName, sizeof(pidName), "%d", static_cast<int>(pid));
+    int pidFd = openat(m_procFd, pidName, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    MM_INSTRUMENT(++m_readStats.syscalls);
+    if (pidFd < 0) {
+        // Process terminated since it was listed
+        MM_INSTRUMENT(countFailure(errno));
+        return false;
+    }
+
+    ProcessCounters counters;
+    const char *comm = nullptr;
+    size_t commLength = 0;
+    ssize_t length = readFileAt(pidFd, "stat");
+    if (length <= 0 || !parseStat(m_readBuffer, length, counters, comm, commLength)) {
+        MM_INSTRUMENT(if (length > 0) ++m_readStats.failed; else if (length == 0) ++m_readStats.vanished);
+        close(pidFd);
+        MM_INSTRUMENT(++m_readStats.syscalls);
+        return false;
+    }
+    info.setStartTime(counters.startTime);
+    info.setMemory(counters.residentSize, counters.virtualSize);
+
+    // Executable path needs ptrace access; kernel threads have none
+    ssize_t pathLength = readlinkat(pidFd, "exe", m_pathBuffer, sizeof(m_pathBuffer) - 1);
+    close(pidFd);
+    MM_INSTRUMENT(m_readStats.syscalls += 2);
+    if (pathLength > 0) {
+        m_pathBuffer[pathLength] = '\0';
+        info.setPath(m_pathBuffer, pathLength);
+
+        // Extract process name from path
+        const char *lastSlash = strrchr(m_pathBuffer, '/');
+        const char *name = lastSlash ? lastSlash + 1 : m_pathBuffer;
+        info.setName(name, (m_pathBuffer + pathLength) - name);
+    } else {
+        // Fallback: comm from stat
+        info.setName(comm, commLength);
+        info.setPath("", 0);
+    }
+
+    info.setValid(true);
+    return true;
+}
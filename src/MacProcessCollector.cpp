@@ -0,0 +1,130 @@
+#include "MacProcessCollector.h"
+#include "ProcessInfo.h"
+#include "Instrumentation.h"
+#include <cerrno>
+#include <sys/sysctl.h>
+#include <mach/mach.h>
+#include <libproc.h>
+#include <cstring>
+
+uint64_t MacProcessCollector::queryTotalPhysicalRAM() {
+    // Get total physical RAM (this doesn't change)
+    uint64_t totalPhysicalRAM = 0;
+    int mib[2] = {CTL_HW, HW_MEMSIZE};
+    size_t length = sizeof(totalPhysicalRAM);
+    sysctl(mib, 2, &totalPhysicalRAM, &length, nullptr, 0);
+    return totalPhysicalRAM;
+}
+
+bool MacProcessCollector::collectSystemMemoryInfo(SystemMemoryInfo& info) {
+    vm_size_t page_size;
+    host_page_size(mach_host_self(), &page_size);
+
+    vm_statistics64_data_t vm_stats;
+    mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+
+    kern_return_t result = host_statistics64(
+        mach_host_self(),
+        HOST_VM_INFO64,
+        (host_info64_t)&vm_stats,
+        &count
+    );
+
+    if (result != KERN_SUCCESS) {
+        return false;
+    }
+
+    info.freeMemory = vm_stats.free_count * page_size;
+    info.activeMemory = vm_stats.active_count * page_size;
+    info.inactiveMemory = vm_stats.inactive_count * page_size;
+    info.wiredMemory = vm_stats.wire_count * page_size;
+
+    return true;
+}
+
+bool MacProcessCollector::listProcesses(std::vector<pid_t>& pids) {
+    // Get number of processes
+    int numProcs = proc_listallpids(nullptr, 0);
+    if (numProcs <= 0) {
+        return false;
+    }
+
+    // Get all process IDs
+    pids.resize(numProcs);
+    numProcs = proc_listallpids(pids.data(), static_cast<int>(pids.size() * sizeof(pid_t)));
+
+    if (numProcs <= 0) {
+        return false;
+    }
+
+    // Resize to actual number of processes
+    pids.resize(numProcs);
+    return true;
+}
+
+bool MacProcessCollector::collectProcess(pid_t pid, ProcessInfo& info) {
+    info.setPid(pid);
+
+    // Get process BSD and task info (start time, memory statistics)
+    struct proc_taskallinfo tai;
+    int result = proc_pidinfo(pid, PROC_PIDTASKALLINFO, 0, &tai, sizeof(tai));
+
+    if (result != sizeof(tai)) {
+        // Process might have terminated or we don't have permission
+        MM_INSTRUMENT(countFailure());
+        info.setValid(false);
+        return false;
+    }
+    MM_INSTRUMENT(m_readStats.bytesRead += sizeof(tai));
+
+    info.setStartTime(tai.pbsd.pbi_start_tvsec * 1000000ULL + tai.pbsd.pbi_start_tvusec);
+    info.setMemory(tai.ptinfo.pti_resident_size, tai.ptinfo.pti_virtual_size);
+
+    // Get process path
+    char pathBuffer[PROC_PIDPATHINFO_MAXSIZE];
+    int pathLength = proc_pidpath(pid, pathBuffer, sizeof(pathBuffer));
+    if (pathLength > 0) {
+        info.setPath(pathBuffer, pathLength);
+
+        // Extract process name from path
+        const char *lastSlash = strrchr(pathBuffer, '/');
+        const char *name = lastSlash ? lastSlash + 1 : pathBuffer;
+        info.setName(name, strlen(name));
+    } else {
+        // Fallback: pbi_name/pbi_comm from the BSD info we already have
+        if (tai.pbsd.pbi_name[0]) {
+            info.setName(tai.pbsd.pbi_name, strnlen(tai.pbsd.pbi_name, sizeof(tai.pbsd.pbi_name)));
+        } else if (tai.pbsd.pbi_comm[0]) {
+            info.setName(tai.pbsd.pbi_comm, strnlen(tai.pbsd.pbi_comm, sizeof(tai.pbsd.pbi_comm)));
+        } else {
+            info.setName("Unknown", 7);
+        }
+        info.setPath("", 0);
+    }
+
+    info.setValid(true);
+    return true;
+}
+
+bool MacProcessCollector::collectCounters(pid_t pid, ProcessCounters& counters) {
+    struct proc_taskallinfo tai;
+    int result = proc_pidinfo(pid, PROC_PIDTASKALLINFO, 0, &tai, sizeof(tai));
+    if (result != sizeof(tai)) {
+        MM_INSTRUMENT(countFailure());
+        return false;
+    }
+    MM_INSTRUMENT(m_readStats.bytesRead += sizeof(tai));
+
+    counters.startTime = tai.pbsd.pbi_start_tvsec * 1000000ULL + tai.pbsd.pbi_start_tvusec;
+    counters.residentSize = tai.ptinfo.pti_resident_size;
+    counters.virtualSize = tai.ptinfo.pti_virtual_size;
+    return true;
+}
+
+void MacProcessCollector::countFailure() {
+    if (errno == ESRCH) {
+        ++m_readStats.vanished;
+    } else {
+        ++m_readStats.failed;
+    }
+}
@@ -9,8 +9,15 @@
 #include <QMenu>
 #include <QAction>
 #include <QHeaderView>
+#include <QTableWidget>
 #include <QTableWidgetItem>
+#include <QApplication>
+#include <QFontDatabase>
+#include <QPlainTextEdit>
 #include <QtCharts/QChart>
+#include <QtCharts/QDateTimeAxis>
+#include <QtCharts/QLineSeries>
+#include <QtCharts/QValueAxis>
 #include <QtCharts/QPieSlice>
 #include <QMessageBox>
 #include <QDialog>
@@ -19,24 +26,84 @@
 #include <QProcess>
 #include <QTimer>
 #include <QCheckBox>
+#include <QComboBox>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QSignalBlocker>
+#include <QSlider>
+#include <QStandardPaths>
+#include "CumulativePercentDelegate.h"
+#include "Instrumentation.h"
+
+namespace {
+
+// PSI trigger: tasks stalled on memory this long within the window. The
+// 2 s window is the shortest unprivileged triggers accept.
+constexpr int kPressureStallMs = 150;
+constexpr int kPressureWindowMs = 2000;
+
+// How long a memory stall stays listed with the alerts
+constexpr int kStallDisplayMs = 10000;
+
+const char kStallPrefix[] = "Memory stall";
+
+// Mapping breakdown columns
+enum MappingColumn {
+    RegionColumn = 0,
+    KindColumn,
+    MappingCountColumn,
+    SizeColumn,
+    ResidentColumn,
+    ProportionalColumn,
+    UniqueColumn,
+    SwapColumn,
+    MappingColumnCount
+};
 
-// Custom QTableWidgetItem that sorts numerically using UserRole data
-class NumericTableWidgetItem : public QTableWidgetItem {
+// Sorts by the raw number in Qt::UserRole rather than the formatted text
+class NumericItem : public QTableWidgetItem {
 public:
-    bool operator<(const QTableWidgetItem &other) const override {
-        return data(Qt::UserRole).toDouble() < other.data(Qt::UserRole).toDouble();
+    bool operator<(const QTableWidgetItem& other) const override {
+        return data(Qt::UserRole).toULongLong() < other.data(Qt::UserRole).toULongLong();
     }
 };
 
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_processTable(nullptr)
+    , m_processModel(nullptr)
+    , m_sortModel(nullptr)
     , m_chartView(nullptr)
     , m_pieSeries(nullptr)
-    , m_refreshTimer(nullptr)
     , m_monitor(nullptr)
     , m_workerThread(nullptr)
+    , m_replay(nullptr)
+    , m_replayControls(nullptr)
+    , m_replaySlider(nullptr)
+    , m_replayLabel(nullptr)
+    , m_replayPlayButton(nullptr)
+    , m_recordAction(nullptr)
+    , m_alertLabel(nullptr)
+    , m_stallTimer(nullptr)
+    , m_diagnosticsDialog(nullptr)
+    , m_phaseTable(nullptr)
+    , m_counterTable(nullptr)
+    , m_mappingDialog(nullptr)
+    , m_mappingSummary(nullptr)
+    , m_mappingTable(nullptr)
+    , m_mappingMonitor(nullptr)
+    , m_mappingThread(nullptr)
+    , m_mappingPid(0)
     , m_refreshInterval(5)
+    , m_effectiveIntervalMs(0)
+    , m_cpuBudget(2.0)
+    , m_accountingBudgetMs(5)
     , m_chartProcessCount(25)
     , m_isPaused(false)
 {
@@ -45,31 +112,63 @@ MainWindow::MainWindow(QWidget *parent)
     // Create worker thread and monitor
     m_workerThread = new QThread(this);
     m_monitor = new SystemMonitor();
-    m_monitor->moveToThread(m_workerThread);
 
-    // Connect signals
-    connect(m_workerThread, &QThread::started, m_monitor, &SystemMonitor::collectData);
+    // Connect signals first: the setup below reports errors synchronously
     connect(m_monitor, &SystemMonitor::dataReady, this, &MainWindow::updateUI);
+    connect(m_monitor, &SystemMonitor::refreshIntervalChanged, this, &MainWindow::onRefreshIntervalAdjusted);
     connect(m_monitor, &SystemMonitor::errorOccurred, this, &MainWindow::handleError);
+    connect(m_monitor, &SystemMonitor::alertChanged, this, &MainWindow::onAlertChanged);
+    connect(m_monitor, &SystemMonitor::pressureStall, this, &MainWindow::onPressureStall);
+
+    // Loaded here, before the worker runs its first collection
+    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!dataDir.isEmpty() && QDir().mkpath(dataDir)) {
+        m_monitor->setRollupPath(dataDir + "/rollups.mmru");
+        m_alertRulesPath = dataDir + "/alerts.rules";
+    }
+    m_monitor->setProgressiveScan(true);
+    m_monitor->setAdaptiveRefresh(true);
+    m_monitor->setCpuBudget(m_cpuBudget);
+    m_monitor->setRefreshInterval(m_refreshInterval * 1000);
 
-    // Start the worker thread
-    m_workerThread->start();
+    // Optional: macOS and kernels without PSI just don't report stalls
+    m_monitor->setPressureTrigger(kPressureStallMs, kPressureWindowMs);
+    m_monitor->moveToThread(m_workerThread);
 
-    // Setup auto-refresh timer
-    m_refreshTimer = new QTimer(this);
-    connect(m_refreshTimer, &QTimer::timeout, m_monitor, &SystemMonitor::collectData);
-    m_refreshTimer->start(m_refreshInterval * 1000);
+    // Destroyed on its own thread, so its refresh timer is stopped there
+    connect(m_workerThread, &QThread::finished, m_monitor, &QObject::deleteLater);
 
-    // Initial data collection
-    QMetaObject::invokeMethod(m_monitor, &SystemMonitor::collectData, Qt::QueuedConnection);
+    QFile rulesFile(m_alertRulesPath);
+    if (!m_alertRulesPath.isEmpty() && rulesFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        SystemMonitor *monitor = m_monitor;
+        QString rules = QString::fromUtf8(rulesFile.readAll());
+        QMetaObject::invokeMethod(monitor, [monitor, rules]() { monitor->setAlertRules(rules); },
+                                  Qt::QueuedConnection);
+    }
+
+    // Start the worker thread; the first collection arms the monitor's
+    // refresh timer
+    m_workerThread->start();
+    m_monitor->requestCollect();
 }
 
 MainWindow::~MainWindow() {
+    if (m_monitor) {
+        // Don't wait for a long first scan to finish
+        m_monitor->cancel();
+    }
     if (m_workerThread) {
+        // The monitor is deleted (deleteLater on finished) before wait() returns
         m_workerThread->quit();
         m_workerThread->wait();
+        m_monitor = nullptr;
+    }
+    if (m_mappingThread) {
+        // Likewise for the mapping monitor and its re-arming timer
+        m_mappingThread->quit();
+        m_mappingThread->wait();
+        m_mappingMonitor = nullptr;
     }
-    delete m_monitor;
 }
 
 void MainWindow::setupUI() {
@@ -94,6 +193,25 @@ void MainWindow::setupUI() {
     connect(intervalSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
             this, &MainWindow::onRefreshIntervalChanged);
 
+    // Share of one core the monitor may spend; sampling slows down to stay
+    // within it
+    QLabel *budgetLabel = new QLabel("CPU Budget (%):", this);
+    QDoubleSpinBox *budgetSpinBox = new QDoubleSpinBox(this);
+    budgetSpinBox->setRange(0.5, 50.0);
+    budgetSpinBox->setSingleStep(0.5);
+    budgetSpinBox->setDecimals(1);
+    budgetSpinBox->setValue(m_cpuBudget);
+    connect(budgetSpinBox, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::onCpuBudgetChanged);
+
+    // Sustained growth above this is flagged in the Growth column
+    QLabel *growthLabel = new QLabel("Growth Alert (MB/h):", this);
+    QSpinBox *growthSpinBox = new QSpinBox(this);
+    growthSpinBox->setRange(1, 100000);
+    growthSpinBox->setValue(static_cast<int>(GrowthAnalyzer::kDefaultThreshold * 3600 / (1024 * 1024)));
+    connect(growthSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &MainWindow::onGrowthThresholdChanged);
+
     // Manual refresh button
     QPushButton *refreshButton = new QPushButton("Refresh Now", this);
     connect(refreshButton, &QPushButton::clicked, this, &MainWindow::onManualRefresh);
@@ -118,6 +236,10 @@ void MainWindow::setupUI() {
 
     controlsLayout->addWidget(intervalLabel);
     controlsLayout->addWidget(intervalSpinBox);
+    controlsLayout->addWidget(budgetLabel);
+    controlsLayout->addWidget(budgetSpinBox);
+    controlsLayout->addWidget(growthLabel);
+    controlsLayout->addWidget(growthSpinBox);
     controlsLayout->addWidget(refreshButton);
     controlsLayout->addWidget(pauseButton);
     controlsLayout->addWidget(purgeButton);
@@ -127,6 +249,9 @@ void MainWindow::setupUI() {
 
     mainLayout->addWidget(controlsWidget);
 
+    setupReplayControls();
+    mainLayout->addWidget(m_replayControls);
+
     setupTable();
 
     // Table takes full width now (no pie chart)
@@ -138,12 +263,19 @@ void MainWindow::setupUI() {
 }
 
 void MainWindow::setupTable() {
-    m_processTable = new QTableWidget(this);
-    m_processTable->setColumnCount(5);
-    m_processTable->setHorizontalHeaderLabels(
-        {"Process Name", "Path", "RAM Usage", "% of Total", "Cumulative %"});
+    m_processModel = new ProcessTableModel(this);
+
+    // Sorting happens in the proxy so the model can keep a stable row order;
+    // the proxy also derives Cumulative % from the sorted order
+    m_sortModel = new ProcessSortModel(this);
+    m_sortModel->setSourceModel(m_processModel);
 
+    m_processTable = new QTableView(this);
+    m_processTable->setModel(m_sortModel);
     m_processTable->setSortingEnabled(true);
+    m_processTable->sortByColumn(ProcessTableModel::MemoryColumn, Qt::DescendingOrder);
+    m_processTable->setItemDelegateForColumn(ProcessTableModel::CumulativeColumn,
+                                             new CumulativePercentDelegate(this));
     m_processTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_processTable->setSelectionMode(QAbstractItemView::SingleSelection);
     m_processTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -155,17 +287,77 @@ void MainWindow::setupTable() {
     m_processTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
     m_processTable->horizontalHeader()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
     m_processTable->horizontalHeader()->setSectionResizeMode(4, QHeaderView::ResizeToContents);
+    m_processTable->horizontalHeader()->setSectionResizeMode(5, QHeaderView::ResizeToContents);
+    for (int column = ProcessTableModel::ProportionalColumn; column < ProcessTableModel::ColumnCount; ++column) {
+        m_processTable->horizontalHeader()->setSectionResizeMode(column, QHeaderView::ResizeToContents);
+        m_processTable->setColumnHidden(column, true);  // View > Show PSS / USS / Swap
+    }
+
+    // Plain clicks only select; double-click opens the history, the
+    // context menu both views
+    m_processTable->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(m_processTable, &QWidget::customContextMenuRequested,
+            this, &MainWindow::onTableContextMenu);
+    connect(m_processTable, &QTableView::doubleClicked,
+            this, &MainWindow::onTableRowDoubleClicked);
+}
+
+void MainWindow::setupReplayControls() {
+    // Shown only while a recording is open
+    m_replayControls = new QWidget(this);
+    QHBoxLayout *replayLayout = new QHBoxLayout(m_replayControls);
+
+    m_replayPlayButton = new QPushButton("Play", this);
+    connect(m_replayPlayButton, &QPushButton::clicked, this, [this]() {
+        if (!m_replay) return;
+        if (m_replay->isPlaying()) {
+            m_replay->pause();
+        } else {
+            m_replay->play();
+        }
+        m_replayPlayButton->setText(m_replay->isPlaying() ? "Pause" : "Play");
+    });
+
+    QPushButton *stepButton = new QPushButton("Step", this);
+    connect(stepButton, &QPushButton::clicked, this, [this]() {
+        if (m_replay) {
+            m_replay->step();
+            m_replayPlayButton->setText("Play");
+        }
+    });
+
+    QComboBox *speedCombo = new QComboBox(this);
+    for (double speed : {0.25, 1.0, 4.0, 16.0, 60.0, 600.0, 3600.0}) {
+        speedCombo->addItem(QString("%1x").arg(speed), speed);
+    }
+    speedCombo->setCurrentIndex(1);
+    connect(speedCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+            [this, speedCombo](int index) {
+        if (m_replay) {
+            m_replay->setSpeed(speedCombo->itemData(index).toDouble());
+        }
+    });
+
+    m_replaySlider = new QSlider(Qt::Horizontal, this);
+    connect(m_replaySlider, &QSlider::valueChanged, this, [this](int value) {
+        if (m_replay) {
+            m_replay->seek(value);
+        }
+    });
+
+    m_replayLabel = new QLabel(this);
+
+    QPushButton *liveButton = new QPushButton("Back to Live", this);
+    connect(liveButton, &QPushButton::clicked, this, &MainWindow::onReturnToLive);
 
-    // Connect table click signal
-    connect(m_processTable, &QTableWidget::cellClicked,
-            this, &MainWindow::onTableRowClicked);
+    replayLayout->addWidget(m_replayPlayButton);
+    replayLayout->addWidget(stepButton);
+    replayLayout->addWidget(speedCombo);
+    replayLayout->addWidget(m_replaySlider, 1);
+    replayLayout->addWidget(m_replayLabel);
+    replayLayout->addWidget(liveButton);
 
-    // Connect to sort indicator change to recalculate cumulative percentage AFTER sort
-    connect(m_processTable->horizontalHeader(), &QHeaderView::sortIndicatorChanged,
-            this, [this](int, Qt::SortOrder) {
-                // Use QTimer to defer recalculation until after sort completes
-                QTimer::singleShot(0, this, &MainWindow::recalculateCumulativePercentage);
-            });
+    m_replayControls->hide();
 }
 
 void MainWindow::setupChart() {
@@ -180,6 +372,15 @@ void MainWindow::setupMenuBar() {
     QMenuBar *menuBar = new QMenuBar(this);
 
     QMenu *fileMenu = menuBar->addMenu("&File");
+    m_recordAction = fileMenu->addAction("&Record Samples...");
+    m_recordAction->setCheckable(true);
+    connect(m_recordAction, &QAction::toggled, this, &MainWindow::onRecordingToggled);
+
+    QAction *openRecordingAction = fileMenu->addAction("&Open Recording...");
+    openRecordingAction->setShortcut(QKeySequence::Open);
+    connect(openRecordingAction, &QAction::triggered, this, &MainWindow::onOpenRecording);
+
+    fileMenu->addSeparator();
     QAction *quitAction = fileMenu->addAction("&Quit");
     quitAction->setShortcut(QKeySequence::Quit);
     connect(quitAction, &QAction::triggered, this, &MainWindow::close);
@@ -193,128 +394,101 @@ void MainWindow::setupMenuBar() {
     pauseAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_P));
     connect(pauseAction, &QAction::triggered, this, &MainWindow::onPauseResume);
 
+    QAction *adaptiveAction = viewMenu->addAction("&Adaptive Refresh");
+    adaptiveAction->setCheckable(true);
+    adaptiveAction->setChecked(true);
+    connect(adaptiveAction, &QAction::toggled, this, &MainWindow::onAdaptiveRefreshToggled);
+
+    viewMenu->addSeparator();
+    QAction *accountingAction = viewMenu->addAction("Show PSS / USS / &Swap");
+    accountingAction->setCheckable(true);
+    accountingAction->setToolTip("Proportional, private and swapped memory from smaps_rollup (Linux)");
+    connect(accountingAction, &QAction::toggled, this, &MainWindow::onAccountingToggled);
+
+    QAction *accountingBudgetAction = viewMenu->addAction("PSS Sampling &Budget...");
+    connect(accountingBudgetAction, &QAction::triggered, this, &MainWindow::onAccountingBudget);
+
+    viewMenu->addSeparator();
+    QAction *diagnosticsAction = viewMenu->addAction("&Diagnostics...");
+    connect(diagnosticsAction, &QAction::triggered, this, &MainWindow::onShowDiagnostics);
+
+    QMenu *alertsMenu = menuBar->addMenu("&Alerts");
+    QAction *editRulesAction = alertsMenu->addAction("&Edit Rules...");
+    connect(editRulesAction, &QAction::triggered, this, &MainWindow::onEditAlertRules);
+
     setMenuBar(menuBar);
 }
 
 void MainWindow::setupStatusBar() {
     QStatusBar *status = new QStatusBar(this);
     setStatusBar(status);
+
+    // Raised alerts stay visible while showMessage() rewrites the rest
+    m_alertLabel = new QLabel(this);
+    m_alertLabel->setStyleSheet("QLabel { color: red; font-weight: bold; }");
+    m_alertLabel->hide();
+    status->addPermanentWidget(m_alertLabel);
+
+    m_stallTimer = new QTimer(this);
+    m_stallTimer->setSingleShot(true);
+    connect(m_stallTimer, &QTimer::timeout, this, [this]() {
+        for (auto it = m_activeAlerts.begin(); it != m_activeAlerts.end();) {
+            it = it.key().startsWith(kStallPrefix) ? m_activeAlerts.erase(it) : std::next(it);
+        }
+        updateAlertLabel();
+    });
 }
 
 void MainWindow::updateUI() {
-    updateTable();
-    updateStatusBar();
+    // Live samples keep being collected but aren't shown during a replay
+    if (m_replay) return;
+    showSnapshot(m_monitor->snapshot());
 }
 
-void MainWindow::updateTable() {
-    if (!m_monitor) return;
-
-    const auto& processes = m_monitor->getProcesses();
-    uint64_t totalRAM = m_monitor->getTotalPhysicalRAM();
-
-    m_processTable->setSortingEnabled(false);
-    m_processTable->setRowCount(0);
-
-    // Show ALL processes (not just top 100)
-    size_t numToShow = processes.size();
-    m_processTable->setRowCount(numToShow);
+void MainWindow::showSnapshot(SnapshotPtr snapshot) {
+    // Take one consistent sample for everything drawn in this update
+    if (!snapshot) return;
+    m_snapshot = std::move(snapshot);
 
-    for (size_t i = 0; i < numToShow; ++i) {
-        const ProcessInfo& proc = processes[i];
-        double percentage = proc.getMemoryPercentage(totalRAM);
-
-        QTableWidgetItem *nameItem = new QTableWidgetItem(QString::fromStdString(proc.getName()));
-        QTableWidgetItem *pathItem = new QTableWidgetItem(QString::fromStdString(proc.getPath()));
-        NumericTableWidgetItem *sizeItem = new NumericTableWidgetItem();
-        sizeItem->setText(formatMemorySize(proc.getResidentSize()));
-        sizeItem->setData(Qt::UserRole, QVariant::fromValue(proc.getResidentSize()));
-
-        NumericTableWidgetItem *percentItem = new NumericTableWidgetItem();
-        percentItem->setText(formatPercentage(percentage));
-        percentItem->setData(Qt::UserRole, QVariant::fromValue(percentage));
-
-        QTableWidgetItem *cumulativeItem = new QTableWidgetItem("");  // Will be calculated after sort
+    MM_INSTRUMENT(uint64_t allocationsBefore = Instrumentation::threadAllocations());
+    updateTable();
+    updateStatusBar();
+    MM_COUNT(Allocations, Instrumentation::threadAllocations() - allocationsBefore);
 
-        m_processTable->setItem(i, 0, nameItem);
-        m_processTable->setItem(i, 1, pathItem);
-        m_processTable->setItem(i, 2, sizeItem);
-        m_processTable->setItem(i, 3, percentItem);
-        m_processTable->setItem(i, 4, cumulativeItem);
+    if (m_diagnosticsDialog && m_diagnosticsDialog->isVisible()) {
+        updateDiagnostics();
     }
-
-    m_processTable->setSortingEnabled(true);
-
-    // Force sort using column 2 (RAM Usage) in descending order
-    m_processTable->horizontalHeader()->setSortIndicator(2, Qt::DescendingOrder);
-
-    // Calculate cumulative percentage after initial sort
-    recalculateCumulativePercentage();
 }
 
-void MainWindow::recalculateCumulativePercentage() {
-    if (!m_processTable) return;
-
-    // Block signals to prevent recursive calls
-    m_processTable->blockSignals(true);
-
-    double cumulativePercent = 0.0;
-    int rowCount = m_processTable->rowCount();
-
-    for (int visualRow = 0; visualRow < rowCount; ++visualRow) {
-        // Get the % of Total value from column 3
-        QTableWidgetItem *percentItem = m_processTable->item(visualRow, 3);
-        if (!percentItem) continue;
-
-        // Extract percentage value (stored in UserRole)
-        double percentage = percentItem->data(Qt::UserRole).toDouble();
-        cumulativePercent += percentage;
-
-        // Update cumulative column
-        QTableWidgetItem *cumulativeItem = m_processTable->item(visualRow, 4);
-        if (cumulativeItem) {
-            cumulativeItem->setText(formatPercentage(cumulativePercent));
-            cumulativeItem->setData(Qt::UserRole, QVariant::fromValue(cumulativePercent));
-
-            // Color code cumulative percentage with better contrast
-            if (cumulativePercent > 75.0) {
-                cumulativeItem->setBackground(QColor(255, 180, 180));  // Light red
-                cumulativeItem->setForeground(QColor(0, 0, 0));  // Black text
-            } else if (cumulativePercent > 50.0) {
-                cumulativeItem->setBackground(QColor(255, 255, 180));  // Light yellow
-                cumulativeItem->setForeground(QColor(0, 0, 0));  // Black text
-            } else if (cumulativePercent > 25.0) {
-                cumulativeItem->setBackground(QColor(180, 255, 180));  // Light green
-                cumulativeItem->setForeground(QColor(0, 0, 0));  // Black text
-            } else {
-                cumulativeItem->setBackground(QColor(240, 240, 240));  // Light gray
-                cumulativeItem->setForeground(QColor(0, 0, 0));  // Black text
-            }
-        }
-    }
+void MainWindow::updateTable() {
+    if (!m_snapshot) return;
 
-    // Unblock signals
-    m_processTable->blockSignals(false);
+    // The model diffs against what's on screen; the proxy re-sorts only
+    // the rows that changed
+    m_processModel->setSnapshot(m_snapshot);
 }
 
 void MainWindow::updateChart() {
-    if (!m_monitor) return;
+    if (!m_snapshot) return;
 
     // Clear existing slices
     m_pieSeries->clear();
 
-    // Get top N processes based on user setting
-    auto topProcesses = m_monitor->getTopProcessesByMemory(m_chartProcessCount);
-    uint64_t totalRAM = m_monitor->getTotalPhysicalRAM();
-    const auto& allProcesses = m_monitor->getProcesses();
+    // Get top N processes based on user setting, plus the next 10 for the
+    // "Others" tooltip, in one selection
+    auto rankedProcesses = m_snapshot->getTopProcessesByMemory(m_chartProcessCount + 10);
+    size_t topCount = std::min(rankedProcesses.size(), static_cast<size_t>(m_chartProcessCount));
+    uint64_t totalRAM = m_snapshot->getTotalPhysicalRAM();
 
     // Calculate "others" percentage
     double topPercentageSum = 0.0;
-    for (const auto& proc : topProcesses) {
-        topPercentageSum += proc.getMemoryPercentage(totalRAM);
+    for (size_t i = 0; i < topCount; ++i) {
+        topPercentageSum += rankedProcesses[i].getMemoryPercentage(totalRAM);
     }
 
     // Add slices for top processes
-    for (const auto& proc : topProcesses) {
+    for (size_t i = 0; i < topCount; ++i) {
+        const ProcessRef proc = rankedProcesses[i];
         double percentage = proc.getMemoryPercentage(totalRAM);
         QPieSlice *slice = m_pieSeries->append(
             QString::fromStdString(proc.getName()),
@@ -328,7 +502,7 @@ void MainWindow::updateChart() {
     // Add "Others" slice if there's remaining memory
     double othersPercentage = 100.0 - topPercentageSum;
     if (othersPercentage > 0.1) {
-        int othersCount = allProcesses.size() - topProcesses.size();
+        int othersCount = m_snapshot->getProcessCount() - topCount;
         QPieSlice *othersSlice = m_pieSeries->append("Others", othersPercentage);
         othersSlice->setLabelVisible(true);
 
@@ -338,11 +512,10 @@ void MainWindow::updateChart() {
             .arg(othersCount);
 
         // Add next 10 processes to tooltip
-        size_t tooltipCount = std::min(size_t(10), allProcesses.size() - topProcesses.size());
-        for (size_t i = topProcesses.size(); i < topProcesses.size() + tooltipCount; ++i) {
+        for (size_t i = topCount; i < rankedProcesses.size(); ++i) {
             othersTooltip += QString("\n- %1: %2")
-                .arg(QString::fromStdString(allProcesses[i].getName()))
-                .arg(formatMemorySize(allProcesses[i].getResidentSize()));
+                .arg(QString::fromStdString(rankedProcesses[i].getName()))
+                .arg(formatMemorySize(rankedProcesses[i].getResidentSize()));
         }
 
         if (othersCount > 10) {
@@ -356,26 +529,23 @@ void MainWindow::updateChart() {
 }
 
 void MainWindow::updateStatusBar() {
-    if (!m_monitor) return;
+    if (!m_snapshot) return;
 
-    uint64_t totalRAM = m_monitor->getTotalPhysicalRAM();
-    uint64_t activeRAM = m_monitor->getActiveMemory();
-    uint64_t wiredRAM = m_monitor->getWiredMemory();
-    uint64_t inactiveRAM = m_monitor->getInactiveMemory();
-    uint64_t freeRAM = m_monitor->getFreeMemory();
+    uint64_t totalRAM = m_snapshot->getTotalPhysicalRAM();
+    uint64_t activeRAM = m_snapshot->getActiveMemory();
+    uint64_t wiredRAM = m_snapshot->getWiredMemory();
+    uint64_t inactiveRAM = m_snapshot->getInactiveMemory();
+    uint64_t freeRAM = m_snapshot->getFreeMemory();
     uint64_t usedRAM = activeRAM + wiredRAM + inactiveRAM;
 
     // Calculate actual process memory sum from all processes
-    uint64_t processMemSum = 0;
-    for (const auto& proc : m_monitor->getProcesses()) {
-        processMemSum += proc.getResidentSize();
-    }
+    uint64_t processMemSum = m_snapshot->getTotalResidentSize();
 
     QString statusText = QString("Total: %1 | Used: %2 | Free: %3 | Processes: %4")
         .arg(formatMemorySize(totalRAM))
         .arg(formatMemorySize(usedRAM))
         .arg(formatMemorySize(freeRAM))
-        .arg(m_monitor->getProcesses().size());
+        .arg(m_snapshot->getProcessCount());
 
     // Add detailed breakdown in second line
     QString detailText = QString("Active: %1 | Wired: %2 | Inactive: %3 | Process RAM Sum: %4")
@@ -384,13 +554,77 @@ void MainWindow::updateStatusBar() {
         .arg(formatMemorySize(inactiveRAM))
         .arg(formatMemorySize(processMemSum));
 
+    // Leak alert: the fastest sustained grower
+    const auto& growing = m_snapshot->getGrowingProcesses();
+    if (!growing.empty()) {
+        const ProcessRef top = m_snapshot->process(growing.front());
+        detailText += QString(" | Growing: %1 %2")
+            .arg(QString::fromStdString(top.getName()))
+            .arg(ProcessTableModel::formatGrowthRate(top.getGrowthRate()));
+        if (growing.size() > 1) {
+            detailText += QString(" (+%1 more)").arg(growing.size() - 1);
+        }
+    }
+
+    // PSS splits shared pages between their users, so unlike the RSS sum
+    // it adds up to no more than used memory
+    if (m_snapshot->hasAccounting()) {
+        const auto& proportional = m_snapshot->getProportionalSizes();
+        const auto& readAt = m_snapshot->getAccountedTimes();
+        uint64_t proportionalSum = 0;
+        size_t read = 0;
+        for (size_t i = 0; i < proportional.size(); ++i) {
+            proportionalSum += proportional[i];
+            read += readAt[i] != 0 ? 1 : 0;
+        }
+        detailText += QString(" | PSS Sum: %1").arg(formatMemorySize(proportionalSum));
+        if (read < proportional.size()) {
+            detailText += QString(" (%1 of %2 read)").arg(read).arg(proportional.size());
+        }
+    }
+
+    if (m_snapshot->hasMemoryPressure()) {
+        const PressureStats& pressure = m_snapshot->getMemoryPressure();
+        detailText += QString(" | Memory Pressure: %1% some, %2% full")
+            .arg(pressure.someAvg10, 0, 'f', 1)
+            .arg(pressure.fullAvg10, 0, 'f', 1);
+    }
+
+    if (m_snapshot->isPartial()) {
+        size_t read = m_snapshot->getProcessCount();
+        statusText += QString(" | Scanning: %1 of ~%2 read")
+            .arg(read)
+            .arg(read + m_snapshot->getPendingProcessCount());
+    } else if (m_effectiveIntervalMs > 0 && !m_replay) {
+        statusText += QString(" | Refresh: %1 s").arg(m_effectiveIntervalMs / 1000.0, 0, 'f', 1);
+    }
+
     statusBar()->showMessage(statusText + " | " + detailText);
 }
 
-void MainWindow::onTableRowClicked(int row, int column) {
-    Q_UNUSED(row);
-    Q_UNUSED(column);
-    // No action needed - chart removed
+void MainWindow::onTableContextMenu(const QPoint& position) {
+    // Persistent: refreshes keep running while the menu is open and may
+    // move or remove the row (a ProcessRef would dangle across exec)
+    QPersistentModelIndex index = m_processTable->indexAt(position);
+    if (!index.isValid()) return;
+
+    QMenu menu(this);
+    QAction *mappingsAction = menu.addAction("Memory Mappings...");
+    QAction *historyAction = menu.addAction("Memory History...");
+    QAction *chosen = menu.exec(m_processTable->viewport()->mapToGlobal(position));
+    if (!chosen || !index.isValid()) return;
+
+    ProcessRef process = m_processModel->processAt(m_sortModel->mapToSource(index).row());
+    if (chosen == mappingsAction) {
+        showMappingBreakdown(process);
+    } else if (chosen == historyAction) {
+        showProcessHistory(process);
+    }
+}
+
+void MainWindow::onTableRowDoubleClicked(const QModelIndex& index) {
+    if (!index.isValid()) return;
+    showProcessHistory(m_processModel->processAt(m_sortModel->mapToSource(index).row()));
 }
 
 void MainWindow::onPieSliceClicked(QPieSlice *slice) {
@@ -411,11 +645,11 @@ void MainWindow::highlightTableRow(int row) {
 }
 
 void MainWindow::highlightTableRow(const QString& processName) {
-    for (int i = 0; i < m_processTable->rowCount(); ++i) {
-        QTableWidgetItem *item = m_processTable->item(i, 0);
-        if (item && item->text() == processName) {
+    for (int i = 0; i < m_sortModel->rowCount(); ++i) {
+        QModelIndex index = m_sortModel->index(i, ProcessTableModel::NameColumn);
+        if (index.data().toString() == processName) {
             m_processTable->selectRow(i);
-            m_processTable->scrollToItem(item);
+            m_processTable->scrollTo(index);
             break;
         }
     }
@@ -428,9 +662,56 @@ void MainWindow::highlightChartSlice(const QString& processName) {
 
 void MainWindow::onRefreshIntervalChanged(int seconds) {
     m_refreshInterval = seconds;
-    if (!m_isPaused && m_refreshTimer) {
-        m_refreshTimer->setInterval(m_refreshInterval * 1000);
+    applyRefreshSchedule();
+}
+
+void MainWindow::onRefreshIntervalAdjusted(int ms) {
+    m_effectiveIntervalMs = ms;
+}
+
+void MainWindow::onCpuBudgetChanged(double percent) {
+    m_cpuBudget = percent;
+    QMetaObject::invokeMethod(m_monitor, [monitor = m_monitor, percent]() {
+        monitor->setCpuBudget(percent);
+    }, Qt::QueuedConnection);
+}
+
+void MainWindow::onAdaptiveRefreshToggled(bool checked) {
+    QMetaObject::invokeMethod(m_monitor, [monitor = m_monitor, checked]() {
+        monitor->setAdaptiveRefresh(checked);
+    }, Qt::QueuedConnection);
+}
+
+void MainWindow::onAccountingToggled(bool checked) {
+    for (int column = ProcessTableModel::ProportionalColumn; column < ProcessTableModel::ColumnCount; ++column) {
+        m_processTable->setColumnHidden(column, !checked);
+    }
+    QMetaObject::invokeMethod(m_monitor, [monitor = m_monitor, checked]() {
+        monitor->setAccountingEnabled(checked);
+    }, Qt::QueuedConnection);
+}
+
+void MainWindow::onAccountingBudget() {
+    bool ok = false;
+    int milliseconds = QInputDialog::getInt(this, "PSS Sampling Budget",
+        "Time per sample for reading PSS (ms).\nThe 20 largest processes are always read:",
+        m_accountingBudgetMs, 0, 1000, 1, &ok);
+    if (!ok) {
+        return;
     }
+    m_accountingBudgetMs = milliseconds;
+    QMetaObject::invokeMethod(m_monitor, [monitor = m_monitor, milliseconds]() {
+        monitor->setAccountingBudget(milliseconds * 1000);
+    }, Qt::QueuedConnection);
+}
+
+void MainWindow::applyRefreshSchedule() {
+    // Paused and replaying both stop the monitor's timer; manual refreshes
+    // still go through
+    int ms = (m_isPaused || m_replay) ? 0 : m_refreshInterval * 1000;
+    QMetaObject::invokeMethod(m_monitor, [monitor = m_monitor, ms]() {
+        monitor->setRefreshInterval(ms);
+    }, Qt::QueuedConnection);
 }
 
 void MainWindow::onChartProcessCountChanged(int count) {
@@ -438,20 +719,26 @@ void MainWindow::onChartProcessCountChanged(int count) {
     updateChart();  // Immediately update chart with new count
 }
 
+void MainWindow::onGrowthThresholdChanged(int megabytesPerHour) {
+    double bytesPerSecond = megabytesPerHour * 1024.0 * 1024.0 / 3600.0;
+    QMetaObject::invokeMethod(m_monitor, [monitor = m_monitor, bytesPerSecond]() {
+        monitor->setGrowthThreshold(bytesPerSecond);
+    }, Qt::QueuedConnection);
+}
+
 void MainWindow::onManualRefresh() {
     if (m_monitor) {
-        QMetaObject::invokeMethod(m_monitor, &SystemMonitor::collectData, Qt::QueuedConnection);
+        m_monitor->requestCollect();
     }
 }
 
 void MainWindow::onPauseResume() {
     m_isPaused = !m_isPaused;
 
+    applyRefreshSchedule();
     if (m_isPaused) {
-        m_refreshTimer->stop();
         statusBar()->showMessage("Auto-refresh paused", 3000);
     } else {
-        m_refreshTimer->start(m_refreshInterval * 1000);
         statusBar()->showMessage("Auto-refresh resumed", 3000);
     }
 }
@@ -461,26 +748,187 @@ void MainWindow::handleError(const QString& error) {
     QMessageBox::warning(this, "Error", error);
 }
 
-QString MainWindow::formatMemorySize(uint64_t bytes) const {
-    const double GB = 1024.0 * 1024.0 * 1024.0;
-    const double MB = 1024.0 * 1024.0;
+void MainWindow::onAlertChanged(const QString& rule, bool active, const QString& message) {
+    qWarning() << (active ? "Alert raised:" : "Alert cleared:") << rule << "-" << message;
+    if (active) {
+        m_activeAlerts.insert(rule, message);
+        QApplication::alert(this);
+    } else {
+        m_activeAlerts.remove(rule);
+    }
+    updateAlertLabel();
+}
+
+void MainWindow::onPressureStall(const QString& source, const QString& message) {
+    // The monitor is already collecting the sample that shows the culprits
+    qWarning() << "Memory stall:" << source << "-" << message;
+    m_activeAlerts.insert(QString("%1 (%2)").arg(kStallPrefix, source), message);
+    m_stallTimer->start(kStallDisplayMs);
+    updateAlertLabel();
+}
+
+void MainWindow::updateAlertLabel() {
+    if (m_activeAlerts.isEmpty()) {
+        m_alertLabel->hide();
+        return;
+    }
 
-    if (bytes >= GB) {
-        return QString("%1 GB").arg(bytes / GB, 0, 'f', 2);
+    QStringList details;
+    for (auto it = m_activeAlerts.constBegin(); it != m_activeAlerts.constEnd(); ++it) {
+        details << QString("%1: %2").arg(it.key(), it.value());
+    }
+    m_alertLabel->setText(m_activeAlerts.size() == 1
+        ? QString("Alert: %1").arg(m_activeAlerts.firstKey())
+        : QString("%1 alerts").arg(m_activeAlerts.size()));
+    m_alertLabel->setToolTip(details.join("\n"));
+    m_alertLabel->show();
+}
+
+void MainWindow::onEditAlertRules() {
+    QString rules;
+    QFile file(m_alertRulesPath);
+    if (!m_alertRulesPath.isEmpty() && file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        rules = QString::fromUtf8(file.readAll());
+        file.close();
     } else {
-        return QString("%1 MB").arg(bytes / MB, 0, 'f', 1);
+        rules = "# One rule per line, e.g.\n"
+                "# java-big: process name \"java\" rss > 8GB\n"
+                "# low-free: system free < 5% for 30s\n"
+                "# chrome: sum rss name \"chrome*\" > 40%\n"
+                "# leak: process growth > 200MB/h for 10m\n";
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Alert Rules");
+    dialog.resize(640, 400);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    QLabel *help = new QLabel(
+        "[name:] process|sum|count|system ... <op> <value> [for <duration>]\n"
+        "Filters: name \"glob\", path \"glob\". Metrics: rss, vsz, growth; "
+        "system: free, used, active, inactive, wired.", &dialog);
+    QPlainTextEdit *editor = new QPlainTextEdit(rules, &dialog);
+    editor->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    layout->addWidget(help);
+    layout->addWidget(editor);
+    layout->addWidget(buttons);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    rules = editor->toPlainText();
+    if (!m_alertRulesPath.isEmpty()) {
+        file.setFileName(m_alertRulesPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)
+            || file.write(rules.toUtf8()) < 0) {
+            handleError(QString("Cannot save alert rules to %1").arg(m_alertRulesPath));
+        }
     }
+
+    // Errors come back through errorOccurred
+    SystemMonitor *monitor = m_monitor;
+    QMetaObject::invokeMethod(monitor, [monitor, rules]() { monitor->setAlertRules(rules); },
+                              Qt::QueuedConnection);
+}
+
+void MainWindow::onShowDiagnostics() {
+    if (!m_diagnosticsDialog) {
+        m_diagnosticsDialog = new QDialog(this);
+        m_diagnosticsDialog->setWindowTitle("Diagnostics");
+        m_diagnosticsDialog->resize(640, 560);
+        QVBoxLayout *layout = new QVBoxLayout(m_diagnosticsDialog);
+
+        if (!Instrumentation::enabled()) {
+            layout->addWidget(new QLabel(
+                "Instrumentation was compiled out (MEMORYMONITOR_INSTRUMENTATION=OFF).",
+                m_diagnosticsDialog));
+        }
+
+        m_phaseTable = new QTableWidget(Instrumentation::PhaseCount, 6, m_diagnosticsDialog);
+        m_phaseTable->setHorizontalHeaderLabels({"Count", "Mean (ms)", "p50", "p90", "p99", "Max"});
+        m_phaseTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        m_phaseTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        for (int phase = 0; phase < Instrumentation::PhaseCount; ++phase) {
+            m_phaseTable->setVerticalHeaderItem(phase, new QTableWidgetItem(
+                Instrumentation::phaseName(static_cast<Instrumentation::Phase>(phase))));
+        }
+
+        m_counterTable = new QTableWidget(Instrumentation::CounterCount, 2, m_diagnosticsDialog);
+        m_counterTable->setHorizontalHeaderLabels({"Total", "Per Sample"});
+        m_counterTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        m_counterTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+        for (int counter = 0; counter < Instrumentation::CounterCount; ++counter) {
+            m_counterTable->setVerticalHeaderItem(counter, new QTableWidgetItem(
+                Instrumentation::counterName(static_cast<Instrumentation::Counter>(counter))));
+        }
+
+        QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, m_diagnosticsDialog);
+        QPushButton *resetButton = buttons->addButton("Reset", QDialogButtonBox::ResetRole);
+        connect(resetButton, &QPushButton::clicked, this, [this]() {
+            Instrumentation::instance().reset();
+            updateDiagnostics();
+        });
+        connect(buttons, &QDialogButtonBox::rejected, m_diagnosticsDialog, &QDialog::hide);
+
+        layout->addWidget(m_phaseTable, 3);
+        layout->addWidget(m_counterTable, 2);
+        layout->addWidget(buttons);
+    }
+
+    updateDiagnostics();
+    m_diagnosticsDialog->show();
+    m_diagnosticsDialog->raise();
+}
+
+void MainWindow::updateDiagnostics() {
+    const Instrumentation& instrumentation = Instrumentation::instance();
+    auto setCell = [](QTableWidget *table, int row, int column, const QString& text) {
+        QTableWidgetItem *item = table->item(row, column);
+        if (!item) {
+            item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            table->setItem(row, column, item);
+        }
+        item->setText(text);
+    };
+    auto milliseconds = [](uint64_t ns) { return QString::number(ns / 1e6, 'f', 3); };
+
+    for (int phase = 0; phase < Instrumentation::PhaseCount; ++phase) {
+        LatencyHistogram::Summary summary =
+            instrumentation.histogram(static_cast<Instrumentation::Phase>(phase)).summarize();
+        setCell(m_phaseTable, phase, 0, QString::number(summary.count));
+        setCell(m_phaseTable, phase, 1, milliseconds(summary.mean));
+        setCell(m_phaseTable, phase, 2, milliseconds(summary.p50));
+        setCell(m_phaseTable, phase, 3, milliseconds(summary.p90));
+        setCell(m_phaseTable, phase, 4, milliseconds(summary.p99));
+        setCell(m_phaseTable, phase, 5, milliseconds(summary.max));
+    }
+
+    uint64_t samples = instrumentation.histogram(Instrumentation::CollectPhase).summarize().count;
+    for (int counter = 0; counter < Instrumentation::CounterCount; ++counter) {
+        uint64_t total = instrumentation.counter(static_cast<Instrumentation::Counter>(counter));
+        setCell(m_counterTable, counter, 0, QString::number(total));
+        setCell(m_counterTable, counter, 1,
+                samples > 0 ? QString::number(static_cast<double>(total) / samples, 'f', 1) : QString());
+    }
+}
+
+QString MainWindow::formatMemorySize(uint64_t bytes) const {
+    return ProcessTableModel::formatMemorySize(bytes);
 }
 
 QString MainWindow::formatPercentage(double percentage) const {
-    return QString("%1%").arg(percentage, 0, 'f', 2);
+    return ProcessTableModel::formatPercentage(percentage);
 }
 
 void MainWindow::showOthersBreakdown() {
-    if (!m_monitor) return;
+    if (!m_snapshot) return;
 
-    const auto& allProcesses = m_monitor->getProcesses();
-    uint64_t totalRAM = m_monitor->getTotalPhysicalRAM();
+    // Hold on to the sample so the dialog stays consistent across refreshes
+    SnapshotPtr snapshot = m_snapshot;
+    auto allProcesses = snapshot->getProcessesByMemory();
+    uint64_t totalRAM = snapshot->getTotalPhysicalRAM();
 
     // Create dialog
     QDialog *dialog = new QDialog(this);
@@ -524,7 +972,7 @@ void MainWindow::showOthersBreakdown() {
     othersTable->setRowCount(othersCount);
 
     for (int i = 0; i < othersCount; ++i) {
-        const ProcessInfo& proc = allProcesses[m_chartProcessCount + i];
+        const ProcessRef proc = allProcesses[m_chartProcessCount + i];
 
         QTableWidgetItem *nameItem = new QTableWidgetItem(QString::fromStdString(proc.getName()));
         QTableWidgetItem *pathItem = new QTableWidgetItem(QString::fromStdString(proc.getPath()));
@@ -556,9 +1004,204 @@ void MainWindow::showOthersBreakdown() {
     delete dialog;
 }
 
+void MainWindow::showProcessHistory(const ProcessRef& process) {
+    // Keyed by identity: a process from a replayed recording only has
+    // history if the live monitor saw it too
+    std::vector<ProcessHistory::Point> points;
+    ProcessKey key{process.getPid(), process.getStartTime()};
+    if (!m_monitor->history().query(key, 0, points)) {
+        statusBar()->showMessage(
+            QString("No history for %1 (%2)").arg(QString::fromStdString(process.getName())).arg(key.pid), 3000);
+        return;
+    }
+
+    QLineSeries *series = new QLineSeries();
+    uint64_t peak = 0;
+    for (const auto& point : points) {
+        series->append(static_cast<qreal>(point.timestampMs), point.residentSize / (1024.0 * 1024.0));
+        peak = std::max(peak, point.residentSize);
+    }
+
+    // Longer view of every process with this name, from the hourly rollups
+    uint64_t now = QDateTime::currentMSecsSinceEpoch();
+    RollupStore::Stats week = m_monitor->rollups().nameStats(process.getName(), now - 7 * 24 * RollupStore::kHourMs, now);
+
+    QChart *chart = new QChart();
+    chart->addSeries(series);
+    chart->legend()->hide();
+    QString title = QString("%1 (%2): %3 samples, peak %4")
+        .arg(QString::fromStdString(process.getName()))
+        .arg(key.pid)
+        .arg(points.size())
+        .arg(formatMemorySize(peak));
+    if (week.buckets > 0) {
+        title += QString(" | all %1 processes, last 7 days: peak %2, average %3")
+            .arg(QString::fromStdString(process.getName()))
+            .arg(formatMemorySize(week.max))
+            .arg(formatMemorySize(week.average));
+    }
+    chart->setTitle(title);
+
+    QDateTimeAxis *timeAxis = new QDateTimeAxis();
+    timeAxis->setFormat("hh:mm:ss");
+    timeAxis->setRange(QDateTime::fromMSecsSinceEpoch(points.front().timestampMs),
+                       QDateTime::fromMSecsSinceEpoch(points.back().timestampMs));
+    chart->addAxis(timeAxis, Qt::AlignBottom);
+    series->attachAxis(timeAxis);
+
+    QValueAxis *memoryAxis = new QValueAxis();
+    memoryAxis->setTitleText("RSS (MB)");
+    memoryAxis->setRange(0, peak / (1024.0 * 1024.0) * 1.1 + 1.0);
+    chart->addAxis(memoryAxis, Qt::AlignLeft);
+    series->attachAxis(memoryAxis);
+
+    QDialog *dialog = new QDialog(this);
+    dialog->setWindowTitle("Memory History");
+    dialog->setMinimumSize(800, 400);
+
+    QVBoxLayout *layout = new QVBoxLayout(dialog);
+    QChartView *chartView = new QChartView(chart, dialog);
+    chartView->setRenderHint(QPainter::Antialiasing);
+    layout->addWidget(chartView);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, dialog);
+    connect(buttonBox, &QDialogButtonBox::rejected, dialog, &QDialog::accept);
+    layout->addWidget(buttonBox);
+
+    dialog->exec();
+    delete dialog;
+}
+
+void MainWindow::showMappingBreakdown(const ProcessRef& process) {
+    if (!m_mappingDialog) {
+        m_mappingDialog = new QDialog(this);
+        m_mappingDialog->setWindowTitle("Memory by Mapping");
+        m_mappingDialog->resize(900, 560);
+        QVBoxLayout *layout = new QVBoxLayout(m_mappingDialog);
+
+        m_mappingSummary = new QLabel(m_mappingDialog);
+        m_mappingSummary->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+        m_mappingTable = new QTableWidget(0, MappingColumnCount, m_mappingDialog);
+        m_mappingTable->setHorizontalHeaderLabels(
+            {"Region", "Kind", "Mappings", "Size", "RSS", "PSS", "USS", "Swap"});
+        m_mappingTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        m_mappingTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+        m_mappingTable->verticalHeader()->hide();
+        m_mappingTable->horizontalHeader()->setSectionResizeMode(RegionColumn, QHeaderView::Stretch);
+        m_mappingTable->setSortingEnabled(true);
+        m_mappingTable->sortByColumn(ProportionalColumn, Qt::DescendingOrder);
+
+        QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, m_mappingDialog);
+        connect(buttons, &QDialogButtonBox::rejected, m_mappingDialog, &QDialog::reject);
+
+        layout->addWidget(m_mappingSummary);
+        layout->addWidget(m_mappingTable);
+        layout->addWidget(buttons);
+
+        m_mappingThread = new QThread(this);
+        m_mappingMonitor = new MappingMonitor();
+        m_mappingMonitor->moveToThread(m_mappingThread);
+        connect(m_mappingThread, &QThread::finished, m_mappingMonitor, &QObject::deleteLater);
+        connect(m_mappingMonitor, &MappingMonitor::sampleReady, this, &MainWindow::onMappingSampleReady);
+        connect(m_mappingMonitor, &MappingMonitor::unavailable, this, &MainWindow::onMappingUnavailable);
+        connect(m_mappingDialog, &QDialog::finished, this, [monitor = m_mappingMonitor]() {
+            QMetaObject::invokeMethod(monitor, &MappingMonitor::stop, Qt::QueuedConnection);
+        });
+        m_mappingThread->start();
+    }
+
+    pid_t pid = process.getPid();
+    uint64_t startTime = process.getStartTime();
+    m_mappingPid = pid;
+    m_mappingProcessName = QString::fromStdString(process.getName());
+    m_mappingTable->setRowCount(0);
+    m_mappingSummary->setText(QString("%1 (%2): reading smaps...").arg(m_mappingProcessName).arg(pid));
+    QMetaObject::invokeMethod(m_mappingMonitor, [monitor = m_mappingMonitor, pid, startTime]() {
+        monitor->watch(pid, startTime);
+    }, Qt::QueuedConnection);
+
+    m_mappingDialog->show();
+}
+
+void MainWindow::onMappingSampleReady() {
+    MappingSamplePtr sample = m_mappingMonitor->sample();
+    // Results for the previously clicked process may still be in flight
+    if (!sample || sample->pid != m_mappingPid || !m_mappingDialog->isVisible()) {
+        return;
+    }
+
+    const MappingBreakdown& breakdown = sample->breakdown;
+    auto kindSize = [&](MappingKind kind) {
+        return formatMemorySize(breakdown.kinds[static_cast<size_t>(kind)].proportional);
+    };
+    m_mappingSummary->setText(
+        QString("%1 (%2): %3 mappings | RSS %4, PSS %5, USS %6, Swap %7\n"
+                "PSS by kind: heap %8, stack %9, anonymous %10, libraries %11, files %12, shared memory %13\n"
+                "Read %14 MB of smaps in %15 ms at %16")
+            .arg(m_mappingProcessName)
+            .arg(sample->pid)
+            .arg(breakdown.total.mappings)
+            .arg(formatMemorySize(breakdown.total.resident))
+            .arg(formatMemorySize(breakdown.total.proportional))
+            .arg(formatMemorySize(breakdown.total.unique))
+            .arg(formatMemorySize(breakdown.total.swap))
+            .arg(kindSize(MappingKind::Heap))
+            .arg(kindSize(MappingKind::Stack))
+            .arg(kindSize(MappingKind::Anonymous))
+            .arg(kindSize(MappingKind::Library))
+            .arg(kindSize(MappingKind::File))
+            .arg(kindSize(MappingKind::SharedMemory))
+            .arg(sample->bytesRead / (1024.0 * 1024.0), 0, 'f', 1)
+            .arg(sample->readUs / 1000.0, 0, 'f', 1)
+            .arg(QDateTime::fromMSecsSinceEpoch(sample->timestampMs).toString("hh:mm:ss")));
+
+    // Items are refilled in place; sorting is suspended so rows don't move
+    // while they are being written
+    m_mappingTable->setSortingEnabled(false);
+    m_mappingTable->setRowCount(static_cast<int>(breakdown.regions.size()));
+    auto setText = [this](int row, int column, const QString& text) {
+        QTableWidgetItem *item = m_mappingTable->item(row, column);
+        if (!item) {
+            item = new QTableWidgetItem();
+            m_mappingTable->setItem(row, column, item);
+        }
+        item->setText(text);
+    };
+    auto setSize = [this](int row, int column, uint64_t value, bool isSize) {
+        QTableWidgetItem *item = m_mappingTable->item(row, column);
+        if (!item) {
+            item = new NumericItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            m_mappingTable->setItem(row, column, item);
+        }
+        item->setData(Qt::UserRole, static_cast<qulonglong>(value));
+        item->setText(isSize ? formatMemorySize(value) : QString::number(value));
+    };
+    for (int row = 0; row < static_cast<int>(breakdown.regions.size()); ++row) {
+        const MappingBreakdown::Region& region = breakdown.regions[row];
+        setText(row, RegionColumn, region.name.empty()
+            ? QString("[anonymous]") : QString::fromStdString(region.name));
+        setText(row, KindColumn, mappingKindName(region.kind));
+        setSize(row, MappingCountColumn, region.totals.mappings, false);
+        setSize(row, SizeColumn, region.totals.size, true);
+        setSize(row, ResidentColumn, region.totals.resident, true);
+        setSize(row, ProportionalColumn, region.totals.proportional, true);
+        setSize(row, UniqueColumn, region.totals.unique, true);
+        setSize(row, SwapColumn, region.totals.swap, true);
+    }
+    m_mappingTable->setSortingEnabled(true);
+}
+
+void MainWindow::onMappingUnavailable(pid_t pid, const QString& reason) {
+    if (pid == m_mappingPid && m_mappingDialog->isVisible()) {
+        m_mappingSummary->setText(QString("%1 (%2): %3").arg(m_mappingProcessName).arg(pid).arg(reason));
+    }
+}
+
 void MainWindow::onPurgeMemory() {
     // Get inactive memory before purge
-    uint64_t inactiveBefore = m_monitor->getInactiveMemory();
+    uint64_t inactiveBefore = m_snapshot ? m_snapshot->getInactiveMemory() : 0;
 
     // Show confirmation dialog with warning
     QMessageBox msgBox(this);
@@ -613,16 +1256,95 @@ void MainWindow::onAlwaysOnTopChanged(bool checked) {
     show();
 }
 
+void MainWindow::onRecordingToggled(bool checked) {
+    SystemMonitor *monitor = m_monitor;
+    if (!checked) {
+        QMetaObject::invokeMethod(monitor, [monitor]() { monitor->stopRecording(); },
+                                  Qt::QueuedConnection);
+        statusBar()->showMessage("Recording stopped", 3000);
+        return;
+    }
+
+    QString path = QFileDialog::getSaveFileName(this, "Record Samples", "memory.mmrec",
+                                                "Memory recordings (*.mmrec)");
+    if (path.isEmpty()) {
+        QSignalBlocker blocker(m_recordAction);
+        m_recordAction->setChecked(false);
+        return;
+    }
+    QMetaObject::invokeMethod(monitor, [monitor, path]() { monitor->startRecording(path); },
+                              Qt::QueuedConnection);
+    statusBar()->showMessage(QString("Recording to %1").arg(path), 3000);
+}
+
+void MainWindow::onOpenRecording() {
+    QString path = QFileDialog::getOpenFileName(this, "Open Recording", QString(),
+                                                "Memory recordings (*.mmrec)");
+    if (path.isEmpty()) return;
+
+    if (!m_replay) {
+        m_replay = new ReplaySource(this);
+        connect(m_replay, &ReplaySource::dataReady, this, &MainWindow::onReplayData);
+        connect(m_replay, &ReplaySource::positionChanged, this, &MainWindow::onReplayPositionChanged);
+        connect(m_replay, &ReplaySource::errorOccurred, this, &MainWindow::handleError);
+        connect(m_replay, &ReplaySource::finished, this, [this]() {
+            m_replayPlayButton->setText("Play");
+        });
+    }
+    if (!m_replay->open(path)) {
+        onReturnToLive();
+        return;
+    }
+
+    applyRefreshSchedule();
+    m_replayPlayButton->setText("Play");
+    m_replayControls->show();
+    setWindowTitle(QString("Memory Monitor - %1").arg(QFileInfo(path).fileName()));
+}
+
+void MainWindow::onReturnToLive() {
+    if (m_replay) {
+        m_replay->deleteLater();
+        m_replay = nullptr;
+    }
+    m_replayControls->hide();
+    setWindowTitle("Memory Monitor");
+
+    applyRefreshSchedule();
+    showSnapshot(m_monitor->snapshot());
+    onManualRefresh();
+}
+
+void MainWindow::onReplayData() {
+    if (m_replay) {
+        showSnapshot(m_replay->snapshot());
+    }
+}
+
+void MainWindow::onReplayPositionChanged(int index, int count) {
+    {
+        QSignalBlocker blocker(m_replaySlider);
+        m_replaySlider->setRange(0, std::max(0, count - 1));
+        m_replaySlider->setValue(index);
+    }
+
+    QDateTime time = QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(m_replay->snapshot()->getTimestampMs()));
+    m_replayLabel->setText(QString("%1  (%2 / %3)")
+        .arg(time.toString("yyyy-MM-dd hh:mm:ss.zzz"))
+        .arg(index + 1)
+        .arg(count));
+}
+
 void MainWindow::onAutoRefreshToggled(bool checked) {
     if (checked) {
         // Enable auto-refresh
         m_isPaused = false;
-        m_refreshTimer->start(m_refreshInterval * 1000);
+        applyRefreshSchedule();
         statusBar()->showMessage("Auto-refresh enabled", 2000);
     } else {
         // Disable auto-refresh
         m_isPaused = true;
-        m_refreshTimer->stop();
+        applyRefreshSchedule();
         statusBar()->showMessage("Auto-refresh disabled", 2000);
     }
 }
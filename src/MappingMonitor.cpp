@@ -0,0 +1,96 @@
+#include "MappingMonitor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace {
+
+// Samples being filled, published and still held by the GUI
+constexpr size_t kSamplePoolSize = 3;
+
+uint64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+MappingMonitor::MappingMonitor(QObject *parent)
+    : QObject(parent)
+    , m_collector(ProcessCollector::create())
+    , m_timer(new QTimer(this))
+    , m_pid(0)
+    , m_startTime(0)
+{
+    // A child, so it moves to the worker thread along with the monitor
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &MappingMonitor::readMappings);
+}
+
+MappingMonitor::~MappingMonitor() = default;
+
+void MappingMonitor::watch(pid_t pid, uint64_t startTime) {
+    m_pid = pid;
+    m_startTime = startTime;
+    readMappings();
+}
+
+void MappingMonitor::stop() {
+    m_timer->stop();
+    m_pid = 0;
+}
+
+void MappingMonitor::readMappings() {
+    if (m_pid == 0) {
+        return;
+    }
+
+    ProcessCounters counters;
+    if (!m_collector->collectCounters(m_pid, counters) || counters.startTime != m_startTime) {
+        pid_t pid = m_pid;
+        stop();
+        emit unavailable(pid, "process exited");
+        return;
+    }
+
+    // Same reuse rule as SystemMonitor's snapshots: only a sample nobody
+    // else references can be refilled
+    std::shared_ptr<MappingSample> sample;
+    for (auto& pooled : m_samplePool) {
+        if (pooled.use_count() == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            sample = pooled;
+            break;
+        }
+    }
+    if (!sample) {
+        sample = std::make_shared<MappingSample>();
+        if (m_samplePool.size() < kSamplePoolSize) {
+            m_samplePool.push_back(sample);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    m_parser.begin(sample->breakdown);
+    bool success = m_collector->collectMappings(m_pid, m_parser);
+    m_parser.finish();
+    uint64_t elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    if (!success) {
+        pid_t pid = m_pid;
+        stop();
+        emit unavailable(pid, "smaps not readable");
+        return;
+    }
+
+    sample->pid = m_pid;
+    sample->startTime = m_startTime;
+    sample->timestampMs = wallClockMs();
+    sample->readUs = elapsedUs;
+    sample->bytesRead = m_parser.bytesParsed();
+    std::atomic_store(&m_published, MappingSamplePtr(std::move(sample)));
+    emit sampleReady();
+
+    m_timer->start(static_cast<int>(std::max(kMinIntervalMs, elapsedUs * 10 / 1000)));
+}
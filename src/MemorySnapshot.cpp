@@ -0,0 +1,120 @@
+#include "MemorySnapshot.h"
+#include "Instrumentation.h"
+#include <algorithm>
+
+uint64_t MemorySnapshot::getUsedMemory() const {
+    // Used memory = Active + Wired + Inactive
+    // (Inactive is cached but still occupies RAM)
+    return m_memory.activeMemory + m_memory.wiredMemory + m_memory.inactiveMemory;
+}
+
+uint64_t MemorySnapshot::getTotalResidentSize() const {
+    uint64_t total = 0;
+    for (uint64_t residentSize : m_residentSizes) {
+        total += residentSize;
+    }
+    return total;
+}
+
+void MemorySnapshot::assignSystemMemory(uint64_t sequence, uint64_t timestampMs,
+                                        uint64_t totalPhysicalRAM, const SystemMemoryInfo& memory) {
+    m_sequence = sequence;
+    m_timestampMs = timestampMs;
+    m_totalPhysicalRAM = totalPhysicalRAM;
+    m_memory = memory;
+}
+
+void MemorySnapshot::assignProcesses(const std::vector<ProcessRecord>& records,
+                                     std::shared_ptr<const StringPool> strings) {
+    size_t count = records.size();
+    m_pids.resize(count);
+    m_startTimes.resize(count);
+    m_residentSizes.resize(count);
+    m_virtualSizes.resize(count);
+    m_nameIds.resize(count);
+    m_pathIds.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const ProcessRecord& record = records[i];
+        m_pids[i] = record.pid;
+        m_startTimes[i] = record.startTime;
+        m_residentSizes[i] = record.residentSize;
+        m_virtualSizes[i] = record.virtualSize;
+        m_nameIds[i] = record.nameId;
+        m_pathIds[i] = record.pathId;
+    }
+
+    m_strings = std::move(strings);
+    m_growthRates.clear();
+    m_growing.clear();
+    m_proportionalSizes.clear();
+    m_uniqueSizes.clear();
+    m_swapSizes.clear();
+    m_accountedAtMs.clear();
+    m_orderValid = false;
+}
+
+namespace {
+
+// Compact sort key, so sorting moves 16 bytes per process
+struct MemoryKey {
+    uint64_t residentSize;
+    uint32_t index;
+};
+
+// Descending by size; ties by position so the order is deterministic
+bool largerFirst(const MemoryKey& a, const MemoryKey& b) {
+    if (a.residentSize != b.residentSize) {
+        return a.residentSize > b.residentSize;
+    }
+    return a.index < b.index;
+}
+
+std::vector<MemoryKey> memoryKeys(const std::vector<uint64_t>& residentSizes) {
+    std::vector<MemoryKey> keys(residentSizes.size());
+    for (uint32_t i = 0; i < keys.size(); ++i) {
+        keys[i] = {residentSizes[i], i};
+    }
+    return keys;
+}
+
+} // namespace
+
+ProcessView MemorySnapshot::getTopProcessesByMemory(size_t count) const {
+    count = std::min(count, m_residentSizes.size());
+    {
+        std::lock_guard<std::mutex> lock(m_orderMutex);
+        if (m_orderValid) {
+            return ProcessView(this, m_order.data(), count);
+        }
+    }
+
+    MM_TIME_SCOPE(SortPhase);
+    std::vector<MemoryKey> keys = memoryKeys(m_residentSizes);
+    if (count < keys.size()) {
+        std::nth_element(keys.begin(), keys.begin() + count, keys.end(), largerFirst);
+    }
+    std::sort(keys.begin(), keys.begin() + count, largerFirst);
+
+    std::vector<uint32_t> indices(count);
+    for (size_t i = 0; i < count; ++i) {
+        indices[i] = keys[i].index;
+    }
+    return ProcessView(this, std::move(indices));
+}
+
+ProcessView MemorySnapshot::getProcessesByMemory() const {
+    std::lock_guard<std::mutex> lock(m_orderMutex);
+    if (!m_orderValid) {
+        MM_TIME_SCOPE(SortPhase);
+        std::vector<MemoryKey> keys = memoryKeys(m_residentSizes);
+        std::sort(keys.begin(), keys.end(), largerFirst);
+
+        m_order.resize(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            m_order[i] = keys[i].index;
+        }
+        m_orderValid = true;
+    }
+    return ProcessView(this, m_order.data(), m_order.size());
+}
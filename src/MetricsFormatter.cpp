@@ -0,0 +1,123 @@
+#include "MetricsFormatter.h"
+#include <algorithm>
+#include <charconv>
+
+MetricsFormatter::MetricsFormatter(size_t topCount)
+    : m_topCount(topCount)
+{
+}
+
+void MetricsFormatter::render(const MemorySnapshot& snapshot, std::string& out) {
+    out.clear();
+    appendGauge(out, "memorymonitor_memory_total_bytes", "Physical memory.",
+                snapshot.getTotalPhysicalRAM());
+    appendGauge(out, "memorymonitor_memory_used_bytes", "Active + inactive + wired memory.",
+                snapshot.getUsedMemory());
+    appendGauge(out, "memorymonitor_memory_free_bytes", "Free memory.",
+                snapshot.getFreeMemory());
+    appendGauge(out, "memorymonitor_memory_active_bytes", "Active memory.",
+                snapshot.getActiveMemory());
+    appendGauge(out, "memorymonitor_memory_inactive_bytes", "Inactive memory.",
+                snapshot.getInactiveMemory());
+    appendGauge(out, "memorymonitor_memory_wired_bytes", "Wired (unreclaimable) memory.",
+                snapshot.getWiredMemory());
+    appendGauge(out, "memorymonitor_processes", "Processes in the sample.",
+                snapshot.getProcessCount());
+    appendGauge(out, "memorymonitor_short_lived_processes",
+                "Processes that started and exited since the previous sample (netlink events only).",
+                snapshot.getShortLivedProcessCount());
+    if (snapshot.hasMemoryPressure()) {
+        const PressureStats& pressure = snapshot.getMemoryPressure();
+        appendGauge(out, "memorymonitor_memory_stall_some_microseconds",
+                    "Cumulative time some tasks were stalled on memory (PSI).",
+                    pressure.someTotalUs);
+        appendGauge(out, "memorymonitor_memory_stall_full_microseconds",
+                    "Cumulative time all non-idle tasks were stalled on memory (PSI).",
+                    pressure.fullTotalUs);
+    }
+    appendGauge(out, "memorymonitor_pressure_stalls",
+                "Pressure triggers that fired just before the sample served.",
+                snapshot.getPressureStallCount());
+    appendGauge(out, "memorymonitor_sample_sequence", "Sequence number of the sample served.",
+                snapshot.getSequence());
+    appendGauge(out, "memorymonitor_sample_timestamp_ms", "Wall-clock time the sample was taken.",
+                snapshot.getTimestampMs());
+
+    // Top N by resident size, largest first; ties by row like
+    // MemorySnapshot::getTopProcessesByMemory
+    const auto& residentSizes = snapshot.getResidentSizes();
+    size_t count = std::min(m_topCount, residentSizes.size());
+    m_top.resize(residentSizes.size());
+    for (uint32_t i = 0; i < m_top.size(); ++i) {
+        m_top[i] = {residentSizes[i], i};
+    }
+    auto largerFirst = [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    };
+    if (count < m_top.size()) {
+        std::nth_element(m_top.begin(), m_top.begin() + count, m_top.end(), largerFirst);
+    }
+    std::sort(m_top.begin(), m_top.begin() + count, largerFirst);
+
+    struct Series { const char *name; const char *help; bool resident; };
+    const Series series[] = {
+        {"memorymonitor_process_resident_bytes", "Resident set size of the largest processes.", true},
+        {"memorymonitor_process_virtual_bytes", "Virtual size of the largest processes (by RSS).", false},
+    };
+    for (const Series& s : series) {
+        out += "# HELP ";
+        out += s.name;
+        out += ' ';
+        out += s.help;
+        out += "\n# TYPE ";
+        out += s.name;
+        out += " gauge\n";
+        for (size_t i = 0; i < count; ++i) {
+            ProcessRef process = snapshot.process(m_top[i].second);
+            out += s.name;
+            out += "{pid=\"";
+            appendNumber(out, static_cast<uint64_t>(process.getPid()));
+            out += "\",name=";
+            appendLabelValue(out, process.getName());
+            out += "} ";
+            appendNumber(out, s.resident ? process.getResidentSize() : process.getVirtualSize());
+            out += '\n';
+        }
+    }
+}
+
+void MetricsFormatter::appendGauge(std::string& out, const char *name, const char *help, uint64_t value) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += " gauge\n";
+    out += name;
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+
+void MetricsFormatter::appendNumber(std::string& out, uint64_t value) {
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void MetricsFormatter::appendLabelValue(std::string& out, const std::string& value) {
+    // The exposition format escapes only backslash, quote and newline
+    out += '"';
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
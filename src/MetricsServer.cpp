@@ -0,0 +1,495 @@
+#include "MetricsServer.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // macOS: SO_NOSIGPIPE is set on each socket instead
+#endif
+
+namespace {
+
+constexpr int kPollIntervalMs = 1000;  // idle connection sweep
+
+const char kNotFound[] = "Not found. Metrics are at /metrics.\n";
+const char kNotAllowed[] = "Only GET is supported.\n";
+const char kTooLarge[] = "Request header too large.\n";
+const char kNoSample[] = "No sample collected yet.\n";
+
+uint64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0
+        && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+void suppressSigpipe(int fd) {
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)fd;
+#endif
+}
+
+// Case-insensitive search for a header line value, e.g. "connection: close"
+bool containsIgnoringCase(const char *data, size_t length, const char *needle) {
+    size_t needleLength = std::strlen(needle);
+    for (size_t i = 0; i + needleLength <= length; ++i) {
+        if (strncasecmp(data + i, needle, needleLength) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string errnoText(const char *what) {
+    return std::string(what) + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(SnapshotSource source, size_t topCount)
+    : m_source(std::move(source))
+    , m_formatter(topCount)
+    , m_tcpFd(-1)
+    , m_unixFd(-1)
+    , m_tcpPort(0)
+    , m_wakePipe{-1, -1}
+    , m_connections(kMaxConnections)
+    , m_currentBody(0)
+    , m_stopping(false)
+    , m_scrapes(0)
+{
+    m_pollFds.reserve(kMaxConnections + 3);
+    m_pollSlots.reserve(kMaxConnections + 3);
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::listenTcp(const std::string& host, uint16_t port, std::string& error) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    addrinfo *addresses = nullptr;
+    std::string service = std::to_string(port);
+    int result = getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &addresses);
+    if (result != 0) {
+        error = "Cannot resolve " + host + ": " + gai_strerror(result);
+        return false;
+    }
+
+    int fd = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+    int on = 1;
+    if (fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0
+        || bind(fd, addresses->ai_addr, addresses->ai_addrlen) != 0
+        || listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd)) {
+        error = errnoText(("Cannot listen on " + host + ":" + service).c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        freeaddrinfo(addresses);
+        return false;
+    }
+    freeaddrinfo(addresses);
+
+    sockaddr_storage bound = {};
+    socklen_t boundLength = sizeof(bound);
+    if (getsockname(fd, reinterpret_cast<sockaddr *>(&bound), &boundLength) == 0) {
+        m_tcpPort = ntohs(bound.ss_family == AF_INET6
+            ? reinterpret_cast<sockaddr_in6 *>(&bound)->sin6_port
+            : reinterpret_cast<sockaddr_in *>(&bound)->sin_port);
+    }
+    m_tcpFd = fd;
+    return true;
+}
+
+bool MetricsServer::listenUnix(const std::string& path, std::string& error) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "Unix socket path is empty or too long: " + path;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // A socket left behind by a previous run; never remove anything else
+    struct stat status;
+    if (lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+        unlink(path.c_str());
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+        || listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd)) {
+        error = errnoText(("Cannot listen on " + path).c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    m_unixFd = fd;
+    m_unixPath = path;
+    return true;
+}
+
+bool MetricsServer::start(std::string& error) {
+    if (m_thread.joinable()) {
+        return true;
+    }
+    if (m_tcpFd < 0 && m_unixFd < 0) {
+        error = "Metrics server has nothing to listen on";
+        return false;
+    }
+    if (pipe(m_wakePipe) != 0 || !setNonBlocking(m_wakePipe[0]) || !setNonBlocking(m_wakePipe[1])) {
+        error = errnoText("Cannot create wake pipe");
+        return false;
+    }
+    m_stopping.store(false);
+    m_thread = std::thread(&MetricsServer::run, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (m_thread.joinable()) {
+        m_stopping.store(true);
+        char byte = 1;
+        ssize_t ignored = write(m_wakePipe[1], &byte, 1);
+        (void)ignored;
+        m_thread.join();
+    }
+    for (Connection& connection : m_connections) {
+        closeConnection(connection);
+    }
+    closeListeners();
+    for (int& fd : m_wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void MetricsServer::closeListeners() {
+    if (m_tcpFd >= 0) {
+        close(m_tcpFd);
+        m_tcpFd = -1;
+    }
+    if (m_unixFd >= 0) {
+        close(m_unixFd);
+        m_unixFd = -1;
+        unlink(m_unixPath.c_str());
+    }
+}
+
+void MetricsServer::run() {
+    while (!m_stopping.load()) {
+        m_pollFds.clear();
+        m_pollSlots.clear();
+        m_pollFds.push_back({m_wakePipe[0], POLLIN, 0});
+        m_pollSlots.push_back(-1);
+        for (int listenFd : {m_tcpFd, m_unixFd}) {
+            if (listenFd >= 0) {
+                m_pollFds.push_back({listenFd, POLLIN, 0});
+                m_pollSlots.push_back(-1);
+            }
+        }
+        for (size_t slot = 0; slot < m_connections.size(); ++slot) {
+            const Connection& connection = m_connections[slot];
+            if (connection.fd >= 0) {
+                m_pollFds.push_back({connection.fd, static_cast<short>(connection.writing ? POLLOUT : POLLIN), 0});
+                m_pollSlots.push_back(static_cast<int>(slot));
+            }
+        }
+
+        int ready = poll(m_pollFds.data(), m_pollFds.size(), kPollIntervalMs);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+
+        uint64_t nowMs = steadyMs();
+        for (size_t i = 0; i < m_pollFds.size() && ready > 0; ++i) {
+            const pollfd& entry = m_pollFds[i];
+            if (entry.revents == 0) {
+                continue;
+            }
+            if (m_pollSlots[i] < 0) {
+                if (entry.fd == m_wakePipe[0]) {
+                    char drain[16];
+                    while (read(m_wakePipe[0], drain, sizeof(drain)) > 0) {
+                    }
+                } else {
+                    acceptAll(entry.fd);
+                }
+                continue;
+            }
+
+            Connection& connection = m_connections[m_pollSlots[i]];
+            if (connection.fd < 0) {
+                continue;
+            }
+            if (entry.revents & (POLLERR | POLLNVAL)) {
+                closeConnection(connection);
+            } else if (connection.writing) {
+                connection.lastActivityMs = nowMs;
+                if (sendPending(connection)) {
+                    finishResponse(connection);
+                    respond(connection);  // anything pipelined meanwhile
+                }
+            } else {
+                readRequest(connection, nowMs);
+            }
+        }
+
+        // Drop clients that went quiet, including ones that stopped reading
+        for (Connection& connection : m_connections) {
+            if (connection.fd >= 0 && connection.lastActivityMs + kIdleTimeoutMs < nowMs) {
+                closeConnection(connection);
+            }
+        }
+    }
+}
+
+void MetricsServer::acceptAll(int listenFd) {
+    for (;;) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            return;  // EAGAIN: backlog drained
+        }
+        auto free = std::find_if(m_connections.begin(), m_connections.end(),
+                                 [](const Connection& connection) { return connection.fd < 0; });
+        if (free == m_connections.end() || !setNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+        suppressSigpipe(fd);
+        free->fd = fd;
+        free->lastActivityMs = steadyMs();
+        free->requestLength = 0;
+        free->writing = false;
+        free->closeAfter = false;
+        free->body = -1;
+    }
+}
+
+void MetricsServer::readRequest(Connection& connection, uint64_t nowMs) {
+    connection.lastActivityMs = nowMs;
+    for (;;) {
+        size_t space = kRequestBufferSize - connection.requestLength;
+        if (space == 0) {
+            break;
+        }
+        ssize_t length = read(connection.fd, connection.request + connection.requestLength, space);
+        if (length > 0) {
+            connection.requestLength += static_cast<size_t>(length);
+            continue;
+        }
+        if (length == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            closeConnection(connection);
+            return;
+        }
+        if (errno != EINTR) {
+            break;
+        }
+    }
+    respond(connection);
+}
+
+void MetricsServer::respond(Connection& connection) {
+    // Answers every complete request in the buffer, in order, as long as
+    // each response goes out without blocking
+    while (connection.fd >= 0 && !connection.writing) {
+        const char *data = connection.request;
+        size_t length = connection.requestLength;
+        const char *end = nullptr;
+        for (size_t i = 0; i + 3 < length; ++i) {
+            if (std::memcmp(data + i, "\r\n\r\n", 4) == 0) {
+                end = data + i + 4;
+                break;
+            }
+        }
+        if (!end) {
+            if (length == kRequestBufferSize) {
+                connection.requestEnd = length;
+                connection.closeAfter = true;  // before setError, which writes the Connection header
+                setError(connection, 431, "Request Header Fields Too Large", kTooLarge);
+            } else {
+                return;  // wait for the rest of the headers
+            }
+        } else {
+            connection.requestEnd = static_cast<size_t>(end - data);
+            const char *lineEnd = static_cast<const char *>(std::memchr(data, '\r', length));
+            size_t lineLength = static_cast<size_t>(lineEnd - data);
+            connection.closeAfter = containsIgnoringCase(data, connection.requestEnd, "\r\nconnection: close")
+                || (lineLength >= 8 && std::memcmp(lineEnd - 8, "HTTP/1.0", 8) == 0
+                    && !containsIgnoringCase(data, connection.requestEnd, "\r\nconnection: keep-alive"));
+
+            const char *target = static_cast<const char *>(std::memchr(data, ' ', lineLength));
+            size_t targetLength = 0;
+            if (target) {
+                ++target;
+                const char *targetEnd = static_cast<const char *>(
+                    std::memchr(target, ' ', static_cast<size_t>(lineEnd - target)));
+                targetLength = static_cast<size_t>((targetEnd ? targetEnd : lineEnd) - target);
+                const char *query = static_cast<const char *>(std::memchr(target, '?', targetLength));
+                if (query) {
+                    targetLength = static_cast<size_t>(query - target);
+                }
+            }
+
+            bool isGet = lineLength > 4 && std::memcmp(data, "GET ", 4) == 0;
+            bool isMetrics = target && ((targetLength == 8 && std::memcmp(target, "/metrics", 8) == 0)
+                                        || (targetLength == 1 && target[0] == '/'));
+            if (!isGet) {
+                setError(connection, 405, "Method Not Allowed", kNotAllowed);
+            } else if (!isMetrics) {
+                setError(connection, 404, "Not Found", kNotFound);
+            } else {
+                int body = acquireBody();
+                if (body < 0) {
+                    setError(connection, 503, "Service Unavailable", kNoSample);
+                } else {
+                    ++m_bodies[body].users;
+                    connection.body = body;
+                    connection.errorBody = nullptr;
+                    connection.bodyLength = m_bodies[body].text.size();
+                    connection.headerLength = static_cast<size_t>(std::snprintf(
+                        connection.header, sizeof(connection.header),
+                        "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n",
+                        MetricsFormatter::kContentType, connection.bodyLength,
+                        connection.closeAfter ? "Connection: close\r\n" : ""));
+                    m_scrapes.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        connection.sent = 0;
+        connection.writing = true;
+        if (!sendPending(connection) || connection.fd < 0) {
+            return;  // rest goes out on POLLOUT
+        }
+        finishResponse(connection);
+    }
+}
+
+void MetricsServer::setError(Connection& connection, int status, const char *reason, const char *text) {
+    connection.body = -1;
+    connection.errorBody = text;
+    connection.bodyLength = std::strlen(text);
+    connection.headerLength = static_cast<size_t>(std::snprintf(
+        connection.header, sizeof(connection.header),
+        "HTTP/1.1 %d %s\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Length: %zu\r\n%s\r\n",
+        status, reason, connection.bodyLength, connection.closeAfter ? "Connection: close\r\n" : ""));
+}
+
+bool MetricsServer::sendPending(Connection& connection) {
+    const char *body = connection.body >= 0 ? m_bodies[connection.body].text.data() : connection.errorBody;
+    size_t total = connection.headerLength + connection.bodyLength;
+    while (connection.sent < total) {
+        iovec parts[2];
+        int count = 0;
+        if (connection.sent < connection.headerLength) {
+            parts[count].iov_base = connection.header + connection.sent;
+            parts[count].iov_len = connection.headerLength - connection.sent;
+            ++count;
+        }
+        size_t bodySent = connection.sent > connection.headerLength ? connection.sent - connection.headerLength : 0;
+        if (bodySent < connection.bodyLength) {
+            parts[count].iov_base = const_cast<char *>(body + bodySent);
+            parts[count].iov_len = connection.bodyLength - bodySent;
+            ++count;
+        }
+
+        msghdr message = {};
+        message.msg_iov = parts;
+        message.msg_iovlen = count;
+        ssize_t written = sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                closeConnection(connection);
+            }
+            return false;
+        }
+        connection.sent += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void MetricsServer::finishResponse(Connection& connection) {
+    if (connection.body >= 0) {
+        --m_bodies[connection.body].users;
+        connection.body = -1;
+    }
+    connection.writing = false;
+    if (connection.closeAfter) {
+        closeConnection(connection);
+        return;
+    }
+
+    // Keep whatever the client pipelined after this request
+    size_t remaining = connection.requestLength - connection.requestEnd;
+    std::memmove(connection.request, connection.request + connection.requestEnd, remaining);
+    connection.requestLength = remaining;
+    connection.requestEnd = 0;
+}
+
+void MetricsServer::closeConnection(Connection& connection) {
+    if (connection.fd < 0) {
+        return;
+    }
+    close(connection.fd);
+    connection.fd = -1;
+    if (connection.body >= 0) {
+        --m_bodies[connection.body].users;
+        connection.body = -1;
+    }
+    connection.writing = false;
+    connection.requestLength = 0;
+}
+
+int MetricsServer::acquireBody() {
+    SnapshotPtr snapshot = m_source();
+    if (!snapshot) {
+        return -1;
+    }
+
+    Body& current = m_bodies[m_currentBody];
+    if (current.valid && current.sequence == snapshot->getSequence()) {
+        return m_currentBody;
+    }
+
+    // Render into a buffer nobody is sending; if every one is busy, the
+    // previous sample is served once more
+    for (size_t i = 0; i < kBodyCount; ++i) {
+        Body& body = m_bodies[i];
+        if (body.users == 0) {
+            m_formatter.render(*snapshot, body.text);
+            body.sequence = snapshot->getSequence();
+            body.valid = true;
+            m_currentBody = static_cast<int>(i);
+            return m_currentBody;
+        }
+    }
+    return current.valid ? m_currentBody : -1;
+}
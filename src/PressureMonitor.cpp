@@ -0,0 +1,192 @@
+#include "PressureMonitor.h"
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+// Unprivileged triggers must use a window that is a multiple of this
+constexpr uint64_t kUnprivilegedWindowUs = 2 * 1000 * 1000;
+
+uint64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string errnoText(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0
+        && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+bool writeTrigger(int fd, uint64_t stallUs, uint64_t windowUs) {
+    // The kernel wants the terminating NUL too
+    char trigger[64];
+    int length = std::snprintf(trigger, sizeof(trigger), "some %llu %llu",
+                               static_cast<unsigned long long>(stallUs),
+                               static_cast<unsigned long long>(windowUs));
+    return write(fd, trigger, static_cast<size_t>(length) + 1) == length + 1;
+}
+
+// Value of "key=" in [p, end), or 0
+const char *findField(const char *p, const char *end, const char *key, size_t keyLength) {
+    for (; p + keyLength <= end; ++p) {
+        if (memcmp(p, key, keyLength) == 0) {
+            return p + keyLength;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+PressureMonitor::PressureMonitor(Handler handler)
+    : m_handler(std::move(handler))
+    , m_windowUs(0)
+    , m_wakePipe{-1, -1}
+    , m_stopping(false)
+    , m_events(0)
+{
+}
+
+PressureMonitor::~PressureMonitor() {
+    stop();
+    for (Watch& watch : m_watches) {
+        close(watch.fd);
+    }
+}
+
+bool PressureMonitor::parseStats(const char *text, size_t length, PressureStats& stats) {
+    stats = PressureStats();
+    bool haveSome = false;
+    const char *end = text + length;
+    for (const char *line = text; line < end;) {
+        const char *lineEnd = static_cast<const char *>(memchr(line, '\n', end - line));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        bool some = lineEnd - line > 5 && memcmp(line, "some ", 5) == 0;
+        bool full = lineEnd - line > 5 && memcmp(line, "full ", 5) == 0;
+        if (some || full) {
+            const char *avg10 = findField(line, lineEnd, "avg10=", 6);
+            const char *avg60 = findField(line, lineEnd, "avg60=", 6);
+            const char *total = findField(line, lineEnd, "total=", 6);
+            if (!avg10 || !avg60 || !total) {
+                return false;
+            }
+            (some ? stats.someAvg10 : stats.fullAvg10) = std::strtod(avg10, nullptr);
+            (some ? stats.someAvg60 : stats.fullAvg60) = std::strtod(avg60, nullptr);
+            (some ? stats.someTotalUs : stats.fullTotalUs) = std::strtoull(total, nullptr, 10);
+            haveSome |= some;
+        }
+        line = lineEnd + 1;
+    }
+    // "full" is missing for the CPU file and on some older kernels
+    return haveSome;
+}
+
+bool PressureMonitor::watch(const std::string& source, const std::string& path,
+                            uint64_t stallUs, uint64_t windowUs, std::string& error) {
+    if (m_thread.joinable()) {
+        error = "Pressure triggers must be added before start()";
+        return false;
+    }
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        error = errnoText("Cannot open " + path);
+        return false;
+    }
+    if (!writeTrigger(fd, stallUs, windowUs)) {
+        uint64_t rounded = (windowUs + kUnprivilegedWindowUs - 1) / kUnprivilegedWindowUs * kUnprivilegedWindowUs;
+        if (errno != EINVAL || rounded == windowUs || !writeTrigger(fd, stallUs, rounded)) {
+            error = errnoText("Cannot set a memory pressure trigger on " + path);
+            close(fd);
+            return false;
+        }
+        windowUs = rounded;
+    }
+    m_windowUs = windowUs;
+    m_watches.push_back({source, fd});
+    return true;
+}
+
+bool PressureMonitor::start(std::string& error) {
+    if (m_thread.joinable()) {
+        return true;
+    }
+    if (m_watches.empty()) {
+        error = "No memory pressure triggers to wait on";
+        return false;
+    }
+    if (pipe(m_wakePipe) != 0 || !setNonBlocking(m_wakePipe[0]) || !setNonBlocking(m_wakePipe[1])) {
+        error = errnoText("Cannot create wake pipe");
+        return false;
+    }
+    m_stopping.store(false);
+    m_thread = std::thread(&PressureMonitor::run, this);
+    return true;
+}
+
+void PressureMonitor::stop() {
+    if (m_thread.joinable()) {
+        m_stopping.store(true);
+        char byte = 1;
+        ssize_t ignored = write(m_wakePipe[1], &byte, 1);
+        (void)ignored;
+        m_thread.join();
+    }
+    for (int& fd : m_wakePipe) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void PressureMonitor::run() {
+    // Last entry is the wake pipe
+    std::vector<pollfd> pollFds;
+    for (const Watch& watch : m_watches) {
+        pollFds.push_back({watch.fd, POLLPRI, 0});
+    }
+    pollFds.push_back({m_wakePipe[0], POLLIN, 0});
+
+    char buffer[256];
+    PressureStats stats;
+    while (!m_stopping.load()) {
+        int ready = poll(pollFds.data(), pollFds.size(), -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        for (size_t i = 0; i < m_watches.size(); ++i) {
+            pollfd& entry = pollFds[i];
+            if (entry.revents & POLLERR) {
+                // The cgroup was removed; a negative fd is skipped by poll
+                entry.fd = -1;
+                continue;
+            }
+            if (!(entry.revents & POLLPRI)) {
+                continue;
+            }
+            m_events.fetch_add(1, std::memory_order_relaxed);
+            ssize_t length = pread(m_watches[i].fd, buffer, sizeof(buffer) - 1, 0);
+            if (length <= 0 || !parseStats(buffer, static_cast<size_t>(length), stats)) {
+                stats = PressureStats();
+            }
+            m_handler({m_watches[i].source, stats, wallClockMs()});
+        }
+    }
+}
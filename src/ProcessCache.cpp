@@ -0,0 +1,310 @@
+#include "ProcessCache.h"
+#include "ProcessCollector.h"
+#include "ProcessScanPool.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Progressive refresh: a first batch small enough to show within
+// milliseconds, then doubling so the batches add little overhead
+constexpr size_t kFirstBatchSize = 256;
+constexpr size_t kMaxBatchSize = 4096;
+
+uint64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+ProcessCache::ProcessCache()
+    : m_strings(std::make_shared<StringPool>())
+{
+}
+
+ProcessCache::~ProcessCache() = default;
+
+void ProcessCache::setEventSource(std::unique_ptr<ProcessEventSource> events) {
+    m_events = std::move(events);
+    m_needsList = true;
+    if (m_events) {
+        for (const ProcessRecord& record : m_processes) {
+            m_events->track(record.pid);
+        }
+    }
+}
+
+bool ProcessCache::listPids(ProcessCollector& collector) {
+    MM_TIME_SCOPE(EnumeratePhase);
+    m_shortLived = 0;
+    if (m_events) {
+        // Drained even when listing, so the next poll only covers the
+        // time since this refresh
+        m_events->poll(m_pendingEvents);
+        m_shortLived = m_pendingEvents.shortLived;
+        MM_COUNT(LifecycleEvents, m_pendingEvents.eventCount);
+        MM_COUNT(ShortLivedProcesses, m_pendingEvents.shortLived);
+
+        uint64_t nowMs = steadyMs();
+        if (m_pendingEvents.complete && !m_needsList && nowMs < m_lastListMs + kReconcileMs) {
+            // Cached pids minus exits, then starts not already cached
+            m_exited.assign(m_processes.size(), 0);
+            for (pid_t pid : m_pendingEvents.exited) {
+                auto it = m_indexByPid.find(pid);
+                if (it != m_indexByPid.end()) {
+                    m_exited[it->second] = 1;
+                }
+            }
+            m_pids.clear();
+            for (size_t index = 0; index < m_processes.size(); ++index) {
+                if (!m_exited[index]) {
+                    m_pids.push_back(m_processes[index].pid);
+                }
+            }
+            for (pid_t pid : m_pendingEvents.started) {
+                auto it = m_indexByPid.find(pid);
+                if (it == m_indexByPid.end() || m_exited[it->second]) {
+                    m_pids.push_back(pid);
+                }
+            }
+            return true;
+        }
+        m_lastListMs = nowMs;
+    }
+
+    MM_COUNT(FullScans, 1);
+    m_needsList = false;
+    return collector.listProcesses(m_pids);
+}
+
+bool ProcessCache::refresh(ProcessScanPool& pool, const BatchCallback& onBatch) {
+    if (!listPids(pool.collector())) {
+        m_needsList = true;
+        return false;
+    }
+    MM_COUNT(PidsScanned, m_pids.size());
+
+    ++m_generation;
+    m_added.clear();
+    m_removed.clear();
+    m_residentChange = 0;
+
+    // Read phase: the index is not modified until every worker of a batch
+    // is done; then the batch is applied in pid order
+    m_scan.resize(m_pids.size());
+    if (m_newInfo.size() < m_pids.size()) {
+        m_newInfo.resize(m_pids.size());
+    }
+    size_t batchSize = onBatch ? kFirstBatchSize : m_pids.size();
+    for (size_t begin = 0; begin < m_pids.size();) {
+        size_t end = std::min(m_pids.size(), begin + batchSize);
+        {
+            MM_TIME_SCOPE(ReadPhase);
+            if (m_batchedReads) {
+                size_t batches = (end - begin + kBatchedReadSize - 1) / kBatchedReadSize;
+                pool.run(batches, [this, begin, end](ProcessCollector& collector, size_t batch) {
+                    size_t first = begin + batch * kBatchedReadSize;
+                    scanBatch(collector, first, std::min(end, first + kBatchedReadSize));
+                }, kBatchedReadSize);
+            } else {
+                pool.run(end - begin, [this, begin](ProcessCollector& collector, size_t item) {
+                    scanProcess(collector, begin + item);
+                });
+            }
+        }
+        applyRange(begin, end);
+        begin = end;
+        batchSize = std::min(batchSize * 2, kMaxBatchSize);
+        if (onBatch && end < m_pids.size() && !onBatch(end, m_pids.size())) {
+            // Unread processes keep their previous generation and are
+            // neither updated nor swept until the next refresh, which
+            // lists again so unread new pids are not lost
+            m_needsList = true;
+            return false;
+        }
+    }
+#if MEMORYMONITOR_INSTRUMENTATION
+    CollectorReadStats readStats = pool.takeReadStats();
+    MM_COUNT(BytesRead, readStats.bytesRead);
+    MM_COUNT(PidsVanished, readStats.vanished);
+    MM_COUNT(PidsFailed, readStats.failed);
+    MM_COUNT(Syscalls, readStats.syscalls);
+#endif
+
+    // Sweep processes that were not seen in this generation
+    for (size_t index = m_processes.size(); index-- > 0;) {
+        if (m_lastSeen[index] != m_generation) {
+            removeAt(index);
+        }
+    }
+
+    compactStrings();
+    return true;
+}
+
+void ProcessCache::applyRange(size_t begin, size_t end) {
+    MM_TIME_SCOPE(ApplyPhase);
+    for (size_t item = begin; item < end; ++item) {
+        const ScanResult& result = m_scan[item];
+        if (result.state == ScanState::Vanished) {
+            // Exited between listing and reading; the sweep drops it
+            continue;
+        }
+
+        pid_t pid = m_pids[item];
+        auto it = m_indexByPid.find(pid);
+        if (result.state == ScanState::New) {
+            if (it != m_indexByPid.end()) {
+                // Same pid, different process
+                removeAt(it->second);
+            }
+            addProcess(m_newInfo[item]);
+            continue;
+        }
+
+        size_t index = it->second;
+        uint64_t previous = m_processes[index].residentSize;
+        m_residentChange += result.residentSize > previous
+            ? result.residentSize - previous : previous - result.residentSize;
+        m_processes[index].residentSize = result.residentSize;
+        m_processes[index].virtualSize = result.virtualSize;
+        m_lastSeen[index] = m_generation;
+    }
+}
+
+void ProcessCache::scanProcess(ProcessCollector& collector, size_t item) {
+    pid_t pid = m_pids[item];
+    ScanResult& result = m_scan[item];
+
+    auto it = m_indexByPid.find(pid);
+    if (it != m_indexByPid.end()) {
+        ProcessCounters counters;
+        if (!collector.collectCounters(pid, counters)) {
+            result.state = ScanState::Vanished;
+            return;
+        }
+        if (counters.startTime == m_processes[it->second].startTime) {
+            result.state = ScanState::Updated;
+            result.residentSize = counters.residentSize;
+            result.virtualSize = counters.virtualSize;
+            return;
+        }
+        // Start time changed: the pid was reused, read it as a new process
+    }
+
+    result.state = collector.collectProcess(pid, m_newInfo[item])
+        ? ScanState::New : ScanState::Vanished;
+}
+
+void ProcessCache::scanBatch(ProcessCollector& collector, size_t begin, size_t end) {
+    // Known processes are re-read together; new pids (and reused ones,
+    // below) still take the full collectProcess path one by one
+    pid_t pids[kBatchedReadSize];
+    size_t items[kBatchedReadSize];
+    ProcessCounters counters[kBatchedReadSize];
+    bool ok[kBatchedReadSize];
+    size_t count = 0;
+    for (size_t item = begin; item < end; ++item) {
+        if (m_indexByPid.count(m_pids[item])) {
+            pids[count] = m_pids[item];
+            items[count] = item;
+            ++count;
+        } else {
+            scanProcess(collector, item);
+        }
+    }
+    collector.collectCountersBatch(pids, count, counters, ok);
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t item = items[i];
+        ScanResult& result = m_scan[item];
+        if (!ok[i]) {
+            result.state = ScanState::Vanished;
+        } else if (counters[i].startTime == m_processes[m_indexByPid.find(pids[i])->second].startTime) {
+            result.state = ScanState::Updated;
+            result.residentSize = counters[i].residentSize;
+            result.virtualSize = counters[i].virtualSize;
+        } else {
+            result.state = collector.collectProcess(pids[i], m_newInfo[item])
+                ? ScanState::New : ScanState::Vanished;
+        }
+    }
+}
+
+void ProcessCache::addProcess(const ProcessInfo& info) {
+    m_added.push_back({info.getPid(), info.getStartTime()});
+    m_residentChange += info.getResidentSize();
+    m_indexByPid[info.getPid()] = m_processes.size();
+    m_processes.push_back({
+        info.getPid(),
+        intern(info.getName()),
+        intern(info.getPath()),
+        info.getStartTime(),
+        info.getResidentSize(),
+        info.getVirtualSize(),
+    });
+    m_lastSeen.push_back(m_generation);
+    if (m_events) {
+        m_events->track(info.getPid());
+    }
+}
+
+uint32_t ProcessCache::intern(const std::string& value) {
+    uint32_t id = m_strings->intern(value);
+    if (id == 0 && !value.empty()) {
+        ++m_droppedStrings;
+        MM_COUNT(StringsDropped, 1);
+    }
+    return id;
+}
+
+void ProcessCache::compactStrings() {
+    size_t total = m_strings->size();
+    if (total < kCompactMinStrings || total < m_processes.size() * 4) {
+        return;  // at most two ids per process, so half are dead at best
+    }
+
+    m_liveStrings.assign(total, 0);
+    size_t live = 1;  // ""
+    m_liveStrings[0] = 1;
+    for (const ProcessRecord& record : m_processes) {
+        for (uint32_t id : {record.nameId, record.pathId}) {
+            live += m_liveStrings[id] ? 0 : 1;
+            m_liveStrings[id] = 1;
+        }
+    }
+    if (live > total / 2) {
+        return;
+    }
+
+    auto strings = std::make_shared<StringPool>();
+    for (ProcessRecord& record : m_processes) {
+        record.nameId = strings->intern(m_strings->str(record.nameId));
+        record.pathId = strings->intern(m_strings->str(record.pathId));
+    }
+    m_strings = std::move(strings);
+    ++m_stringCompactions;
+    MM_COUNT(StringCompactions, 1);
+}
+
+void ProcessCache::removeAt(size_t index) {
+    const ProcessRecord& record = m_processes[index];
+    m_removed.push_back({record.pid, record.startTime});
+    m_residentChange += record.residentSize;
+    m_indexByPid.erase(record.pid);
+    if (m_events) {
+        m_events->untrack(record.pid);
+    }
+
+    // Swap-remove; the sweep walks backwards so the moved entry was already checked
+    size_t last = m_processes.size() - 1;
+    if (index != last) {
+        m_processes[index] = m_processes[last];
+        m_lastSeen[index] = m_lastSeen[last];
+        m_indexByPid[m_processes[index].pid] = index;
+    }
+    m_processes.pop_back();
+    m_lastSeen.pop_back();
+}
@@ -0,0 +1,38 @@
+#include "ProcessCollector.h"
+#include <cstdlib>
+
+#if defined(__APPLE__)
+#include "MacProcessCollector.h"
+#elif defined(__linux__)
+#include "LinuxProcessCollector.h"
+#else
+#error "No ProcessCollector backend for this platform"
+#endif
+
+namespace {
+
+std::string& procRootStorage() {
+    static std::string root = [] {
+        const char *environment = std::getenv("MEMORYMONITOR_PROC_ROOT");
+        return std::string(environment && *environment ? environment : "/proc");
+    }();
+    return root;
+}
+
+} // namespace
+
+void ProcessCollector::setProcRoot(const std::string& root) {
+    procRootStorage() = root;
+}
+
+const std::string& ProcessCollector::procRoot() {
+    return procRootStorage();
+}
+
+std::unique_ptr<ProcessCollector> ProcessCollector::create() {
+#if defined(__APPLE__)
+    return std::make_unique<MacProcessCollector>();
+#else
+    return std::make_unique<LinuxProcessCollector>(procRoot());
+#endif
+}
@@ -0,0 +1,377 @@
+#include "ProcessEventSource.h"
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+namespace {
+
+constexpr size_t kNetlinkBufferSize = 64 * 1024;
+constexpr int kNetlinkReceiveBuffer = 4 * 1024 * 1024;
+constexpr int kEpollBatch = 256;
+
+// Pids the pidfd backend probes per poll at least; beyond this and the
+// tracked process count, listing /proc is cheaper (~0.2 us per probe,
+// ~0.4 us per listed process)
+constexpr size_t kMinProbedPids = 4096;
+
+// Small decimal file under /proc/sys, or -1
+long readNumber(int fd) {
+    char buffer[32];
+    ssize_t length = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (length <= 0) {
+        return -1;
+    }
+    buffer[length] = '\0';
+    return strtol(buffer, nullptr, 10);
+}
+
+// The proc connector names pids of the initial namespace; ours must be the same
+bool inInitialPidNamespace() {
+    int fd = open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char buffer[4096];
+    ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (length <= 0) {
+        return false;
+    }
+    buffer[length] = '\0';
+
+    // "NSpid:\t<pid>" lists one pid per nested namespace
+    const char *line = strstr(buffer, "\nNSpid:");
+    if (!line) {
+        return true;  // kernel older than 4.1, no namespaces to speak of
+    }
+    const char *end = strchr(line + 1, '\n');
+    const char *p = line + 7;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    const char *separator = static_cast<const char *>(memchr(p, '\t', end - p));
+    return separator == nullptr;
+}
+
+bool sendMulticastOp(int socketFd, proc_cn_mcast_op op) {
+    alignas(nlmsghdr) char message[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))];
+    memset(message, 0, sizeof(message));
+    nlmsghdr *header = reinterpret_cast<nlmsghdr *>(message);
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+    cn_msg *body = static_cast<cn_msg *>(NLMSG_DATA(header));
+    body->id.idx = CN_IDX_PROC;
+    body->id.val = CN_VAL_PROC;
+    body->len = sizeof(proc_cn_mcast_op);
+    memcpy(body->data, &op, sizeof(op));
+    return send(socketFd, message, header->nlmsg_len, 0) == static_cast<ssize_t>(header->nlmsg_len);
+}
+
+// Proc connector: one multicast message per fork / exec / exit / ...
+class NetlinkEventSource : public ProcessEventSource {
+public:
+    static std::unique_ptr<ProcessEventSource> open() {
+        int socketFd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+        if (socketFd < 0) {
+            return nullptr;
+        }
+
+        // Bursts of forks must not overflow between two refreshes; the
+        // forced size needs CAP_NET_ADMIN, which we have if bind succeeds
+        int size = kNetlinkReceiveBuffer;
+        if (setsockopt(socketFd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0) {
+            setsockopt(socketFd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        }
+
+        sockaddr_nl address;
+        memset(&address, 0, sizeof(address));
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = CN_IDX_PROC;
+        if (bind(socketFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+                || !sendMulticastOp(socketFd, PROC_CN_MCAST_LISTEN)) {
+            close(socketFd);
+            return nullptr;
+        }
+        return std::unique_ptr<ProcessEventSource>(new NetlinkEventSource(socketFd));
+    }
+
+    ~NetlinkEventSource() override {
+        sendMulticastOp(m_socket, PROC_CN_MCAST_IGNORE);
+        close(m_socket);
+    }
+
+    const char *name() const override { return "netlink"; }
+
+    void poll(ProcessEvents& events) override {
+        events.clear();
+        if (!m_primed) {
+            // Processes that started before we subscribed are unknown
+            events.complete = false;
+            m_primed = true;
+        }
+
+        m_window.clear();
+        for (;;) {
+            ssize_t length = recv(m_socket, m_buffer.data(), m_buffer.size(), MSG_DONTWAIT);
+            if (length < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == ENOBUFS) {
+                    // The kernel dropped events; the next listing catches up
+                    events.complete = false;
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    events.complete = false;
+                }
+                break;
+            }
+            if (length == 0) {
+                break;
+            }
+            parse(static_cast<size_t>(length), events);
+        }
+
+        // Keep processes still alive, once each, in the order they started
+        events.started.erase(std::remove_if(events.started.begin(), events.started.end(),
+            [this](pid_t pid) { return m_window.erase(pid) == 0; }), events.started.end());
+    }
+
+private:
+    int m_socket;
+    bool m_primed = false;
+    std::vector<char> m_buffer;
+    std::unordered_set<pid_t> m_window;  // started in this poll and not exited since
+
+    explicit NetlinkEventSource(int socketFd)
+        : m_socket(socketFd)
+        , m_buffer(kNetlinkBufferSize)
+    {
+    }
+
+    void parse(size_t length, ProcessEvents& events) {
+        unsigned int remaining = static_cast<unsigned int>(length);
+        for (const nlmsghdr *header = reinterpret_cast<const nlmsghdr *>(m_buffer.data());
+             NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) {
+                continue;
+            }
+            const cn_msg *message = static_cast<const cn_msg *>(NLMSG_DATA(header));
+            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) {
+                continue;
+            }
+            const proc_event *event = reinterpret_cast<const proc_event *>(message->data);
+            ++events.eventCount;
+
+            // Threads fork and exit too; only thread group leaders are processes
+            if (event->what == proc_event::PROC_EVENT_FORK
+                    && event->event_data.fork.child_pid == event->event_data.fork.child_tgid) {
+                pid_t pid = event->event_data.fork.child_tgid;
+                m_window.insert(pid);
+                events.started.push_back(pid);
+            } else if (event->what == proc_event::PROC_EVENT_EXIT
+                    && event->event_data.exit.process_pid == event->event_data.exit.process_tgid) {
+                pid_t pid = event->event_data.exit.process_tgid;
+                if (m_window.erase(pid)) {
+                    ++events.shortLived;
+                } else {
+                    events.exited.push_back(pid);
+                }
+            }
+        }
+    }
+};
+
+// pidfd per tracked process; readable once the process has exited
+class PidfdEventSource : public ProcessEventSource {
+public:
+    static std::unique_ptr<ProcessEventSource> open(const std::string& procRoot) {
+        int probe = static_cast<int>(syscall(SYS_pidfd_open, getpid(), 0));
+        if (probe < 0) {
+            return nullptr;  // kernel older than 5.3
+        }
+        close(probe);
+
+        int lastPidFd = ::open((procRoot + "/sys/kernel/ns_last_pid").c_str(), O_RDONLY | O_CLOEXEC);
+        if (lastPidFd < 0) {
+            return nullptr;
+        }
+        int pidMaxFd = ::open((procRoot + "/sys/kernel/pid_max").c_str(), O_RDONLY | O_CLOEXEC);
+        long pidMax = pidMaxFd >= 0 ? readNumber(pidMaxFd) : -1;
+        if (pidMaxFd >= 0) {
+            close(pidMaxFd);
+        }
+        int epollFd = pidMax > 0 ? epoll_create1(EPOLL_CLOEXEC) : -1;
+        if (epollFd < 0) {
+            close(lastPidFd);
+            return nullptr;
+        }
+
+        // Leave the other half of the descriptor limit to everything else.
+        // Exits of processes beyond it are not reported, but ProcessCache
+        // re-reads every cached pid each refresh and drops the ones whose
+        // read fails, so they still leave within one refresh.
+        rlimit limit;
+        size_t maxTracked = 512;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+            maxTracked = static_cast<size_t>(limit.rlim_cur / 2);
+        }
+        return std::unique_ptr<ProcessEventSource>(
+            new PidfdEventSource(epollFd, lastPidFd, pidMax, maxTracked));
+    }
+
+    ~PidfdEventSource() override {
+        for (const auto& entry : m_pidfds) {
+            close(entry.second);
+        }
+        close(m_epoll);
+        close(m_lastPidFd);
+    }
+
+    const char *name() const override { return "pidfd"; }
+
+    void poll(ProcessEvents& events) override {
+        events.clear();
+
+        int count;
+        do {
+            count = epoll_wait(m_epoll, m_ready, kEpollBatch, 0);
+            for (int i = 0; i < count; ++i) {
+                pid_t pid = static_cast<pid_t>(m_ready[i].data.u64);
+                events.exited.push_back(pid);
+                untrack(pid);
+            }
+            events.eventCount += count > 0 ? static_cast<uint64_t>(count) : 0;
+        } while (count == kEpollBatch);
+
+        // Pids allocated since the last poll are probed; threads and pids
+        // already gone fail pidfd_open, so what is left are new processes
+        long lastPid = readNumber(m_lastPidFd);
+        if (!m_primed || m_lastPid < 0 || lastPid < 0 || !probeSince(m_lastPid, lastPid, events)) {
+            events.complete = false;
+        }
+        m_lastPid = lastPid;
+        m_primed = true;
+    }
+
+    void track(pid_t pid) override {
+        if (m_pidfds.size() >= m_maxTracked || m_pidfds.count(pid)) {
+            return;
+        }
+        int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+        if (fd < 0) {
+            return;  // already gone
+        }
+        if (!watch(pid, fd)) {
+            close(fd);
+        }
+    }
+
+    void untrack(pid_t pid) override {
+        auto it = m_pidfds.find(pid);
+        if (it != m_pidfds.end()) {
+            close(it->second);  // also leaves the epoll set
+            m_pidfds.erase(it);
+        }
+    }
+
+private:
+    int m_epoll;
+    int m_lastPidFd;
+    long m_pidMax;
+    size_t m_maxTracked;
+    long m_lastPid = -1;
+    bool m_primed = false;
+    std::unordered_map<pid_t, int> m_pidfds;
+    epoll_event m_ready[kEpollBatch];
+
+    PidfdEventSource(int epollFd, int lastPidFd, long pidMax, size_t maxTracked)
+        : m_epoll(epollFd)
+        , m_lastPidFd(lastPidFd)
+        , m_pidMax(pidMax)
+        , m_maxTracked(maxTracked)
+    {
+    }
+
+    // Adds pid's pidfd to the epoll set; false leaves fd to the caller
+    bool watch(pid_t pid, int fd) {
+        if (m_pidfds.size() >= m_maxTracked || m_pidfds.count(pid)) {
+            return false;
+        }
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u64 = static_cast<uint64_t>(pid);
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            return false;
+        }
+        m_pidfds.emplace(pid, fd);
+        return true;
+    }
+
+    // Reports the processes among the pids allocated after from up to and
+    // including to, which the kernel hands out cyclically below pid_max.
+    // False when that range is too long to be worth probing.
+    bool probeSince(long from, long to, ProcessEvents& events) {
+        if (to == from) {
+            return true;
+        }
+        size_t count = static_cast<size_t>(to > from ? to - from : m_pidMax - 1 - from + to);
+        if (count > std::max(kMinProbedPids, m_pidfds.size())) {
+            return false;
+        }
+        for (long pid = from + 1; count-- > 0; ++pid) {
+            if (pid >= m_pidMax) {
+                pid = 1;
+            }
+            int fd = static_cast<int>(syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+            if (fd < 0) {
+                continue;  // a thread, or exited already
+            }
+            events.started.push_back(static_cast<pid_t>(pid));
+            if (!watch(static_cast<pid_t>(pid), fd)) {
+                close(fd);
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<ProcessEventSource> ProcessEventSource::create(const std::string& procRoot) {
+    // Events describe the running system, not a fixture tree
+    if (procRoot != "/proc") {
+        return nullptr;
+    }
+    if (inInitialPidNamespace()) {
+        if (auto source = NetlinkEventSource::open()) {
+            return source;
+        }
+    }
+    return PidfdEventSource::open(procRoot);
+}
+
+#else
+
+std::unique_ptr<ProcessEventSource> ProcessEventSource::create(const std::string& procRoot) {
+    (void)procRoot;
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,318 @@
+#include "ProcessHistory.h"
+#include <algorithm>
+#include "VarInt.h"
+
+namespace {
+
+// RSS is a whole number of pages, so KiB loses nothing and keeps deltas small
+constexpr unsigned kValueShift = 10;
+
+} // namespace
+
+ProcessHistory::ProcessHistory(size_t memoryBudget, uint64_t retentionMs)
+    : m_memoryBudget(memoryBudget)
+    , m_retentionMs(retentionMs)
+    , m_maxBlocks(0)
+    , m_blockCount(0)
+    , m_firstSample(0)
+    , m_nextSample(0)
+{
+    reset();
+}
+
+ProcessHistory::~ProcessHistory() = default;
+
+void ProcessHistory::setLimits(size_t memoryBudget, uint64_t retentionMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_memoryBudget = memoryBudget;
+    m_retentionMs = retentionMs;
+    reset();
+}
+
+void ProcessHistory::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    reset();
+}
+
+void ProcessHistory::reset() {
+    // Whole chunks only, and at least one
+    size_t chunks = std::max<size_t>(m_memoryBudget / (kBlockSize * kBlocksPerChunk), 1);
+    m_maxBlocks = static_cast<uint32_t>(std::min<size_t>(chunks * kBlocksPerChunk, kNoBlock - 1));
+
+    m_chunks.clear();
+    m_blockCount = 0;
+    m_freeBlocks.clear();
+    m_order.clear();
+    m_series.clear();
+    m_freeSeries.clear();
+    m_seriesByKey.clear();
+    m_timestamps.clear();
+    m_firstSample = m_nextSample;
+}
+
+void ProcessHistory::append(const MemorySnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint64_t sample = m_nextSample++;
+    uint64_t now = snapshot.getTimestampMs();
+    m_timestamps.push_back(now);
+    while (m_timestamps.size() > 1 && m_timestamps.front() + m_retentionMs < now) {
+        m_timestamps.pop_front();
+        ++m_firstSample;
+    }
+
+    const auto& pids = snapshot.getPids();
+    const auto& startTimes = snapshot.getStartTimes();
+    const auto& residentSizes = snapshot.getResidentSizes();
+    for (size_t i = 0; i < pids.size(); ++i) {
+        auto inserted = m_seriesByKey.try_emplace(ProcessKey{pids[i], startTimes[i]}, 0);
+        if (inserted.second) {
+            uint32_t seriesId;
+            if (!m_freeSeries.empty()) {
+                seriesId = m_freeSeries.back();
+                m_freeSeries.pop_back();
+            } else {
+                seriesId = static_cast<uint32_t>(m_series.size());
+                m_series.emplace_back();
+            }
+            m_series[seriesId] = Series{inserted.first->first, kNoBlock, kNoBlock, 0, 0, 0};
+            inserted.first->second = seriesId;
+        }
+        uint32_t seriesId = inserted.first->second;
+        record(m_series[seriesId], seriesId, sample, residentSizes[i] >> kValueShift);
+    }
+
+    // Exited processes keep their history; drop the ones that have none left
+    for (const ProcessKey& key : snapshot.getRemovedProcesses()) {
+        auto it = m_seriesByKey.find(key);
+        if (it != m_seriesByKey.end() && m_series[it->second].firstBlock == kNoBlock) {
+            releaseSeries(it->second);
+        }
+    }
+
+    expire();
+}
+
+void ProcessHistory::record(Series& series, uint32_t seriesId, uint64_t sample, uint64_t value) {
+    if (series.lastBlock != kNoBlock && series.lastSample + 1 == sample) {
+        Block& last = block(series.lastBlock);
+        if (value == series.lastValue) {
+            // Implied by sampleCount until the next change
+            ++last.sampleCount;
+            ++series.gap;
+            series.lastSample = sample;
+            return;
+        }
+
+        uint64_t delta = zigzagEncode(static_cast<int64_t>(value - series.lastValue));
+        uint64_t gapToken = (static_cast<uint64_t>(series.gap) << 1) | 1;
+        size_t size = series.gap ? varintSize(gapToken) + varintSize(delta) : varintSize(delta << 1);
+        if (last.used + size <= sizeof(last.data) && last.sampleCount < UINT32_MAX) {
+            uint8_t *p = last.data + last.used;
+            if (series.gap) {
+                writeVarint(p, gapToken);
+                writeVarint(p, delta);
+            } else {
+                writeVarint(p, delta << 1);
+            }
+            last.used = static_cast<uint16_t>(p - last.data);
+            ++last.sampleCount;
+            series.gap = 0;
+            series.lastSample = sample;
+            series.lastValue = value;
+            return;
+        }
+    }
+    startBlock(series, seriesId, sample, value);
+}
+
+void ProcessHistory::startBlock(Series& series, uint32_t seriesId, uint64_t sample, uint64_t value) {
+    // Set first: allocating may evict, and eviction releases series not seen
+    // in the current sample
+    series.lastSample = sample;
+    series.lastValue = value;
+    series.gap = 0;
+
+    uint32_t index = allocateBlock();
+    Block& started = block(index);
+    started.firstSample = sample;
+    started.firstValue = value;
+    started.series = seriesId;
+    started.next = kNoBlock;
+    started.sampleCount = 1;
+    started.used = 0;
+    started.reserved = 0;
+    m_order.push_back(index);
+
+    if (series.lastBlock == kNoBlock) {
+        series.firstBlock = index;
+    } else {
+        block(series.lastBlock).next = index;
+    }
+    series.lastBlock = index;
+}
+
+uint32_t ProcessHistory::allocateBlock() {
+    if (m_freeBlocks.empty()) {
+        if (m_blockCount < m_maxBlocks) {
+            if (m_blockCount % kBlocksPerChunk == 0) {
+                // Not value-initialized: pages are only touched once used
+                m_chunks.emplace_back(new Block[kBlocksPerChunk]);
+            }
+            return m_blockCount++;
+        }
+        evictOldestBlock();
+    }
+    uint32_t index = m_freeBlocks.back();
+    m_freeBlocks.pop_back();
+    return index;
+}
+
+void ProcessHistory::evictOldestBlock() {
+    uint32_t index = m_order.front();
+    m_order.pop_front();
+
+    // Blocks are allocated in time order, so this is the first of its chain
+    const Block& evicted = block(index);
+    uint32_t seriesId = evicted.series;
+    Series& series = m_series[seriesId];
+    series.firstBlock = evicted.next;
+    if (series.lastBlock == index) {
+        series.lastBlock = kNoBlock;
+    }
+    m_freeBlocks.push_back(index);
+
+    if (series.firstBlock == kNoBlock && series.lastSample + 1 < m_nextSample) {
+        releaseSeries(seriesId);
+    }
+}
+
+void ProcessHistory::rebaseOldestBlock() {
+    uint32_t index = m_order.front();
+    m_order.pop_front();
+
+    // The series' only block (it is both oldest and still open); keep the
+    // retained samples and write them to a new block
+    const Block& oldest = block(index);
+    uint32_t seriesId = oldest.series;
+    Series& series = m_series[seriesId];
+    m_scratch.clear();
+    decode(oldest, [this](uint64_t sample, uint64_t value) {
+        if (sample >= m_firstSample) {
+            m_scratch.emplace_back(sample, value);
+        }
+    });
+    series.firstBlock = kNoBlock;
+    series.lastBlock = kNoBlock;
+    m_freeBlocks.push_back(index);
+
+    for (const auto& point : m_scratch) {
+        record(series, seriesId, point.first, point.second);
+    }
+}
+
+void ProcessHistory::expire() {
+    while (!m_order.empty()) {
+        uint32_t index = m_order.front();
+        const Block& oldest = block(index);
+        if (oldest.firstSample + oldest.sampleCount <= m_firstSample) {
+            evictOldestBlock();
+        } else if (oldest.firstSample < m_firstSample && m_series[oldest.series].lastBlock == index) {
+            // Still growing (typically an idle process), so it would pin
+            // every newer block behind it
+            rebaseOldestBlock();
+        } else {
+            break;
+        }
+    }
+}
+
+void ProcessHistory::releaseSeries(uint32_t seriesId) {
+    m_seriesByKey.erase(m_series[seriesId].key);
+    m_freeSeries.push_back(seriesId);
+}
+
+template <typename Visit>
+void ProcessHistory::decode(const Block& block, Visit&& visit) {
+    uint64_t sample = block.firstSample;
+    uint64_t value = block.firstValue;
+    uint32_t remaining = block.sampleCount - 1;
+    visit(sample, value);
+
+    const uint8_t *p = block.data;
+    const uint8_t *end = block.data + block.used;
+    uint64_t token;
+    while (remaining > 0 && p < end && readVarint(p, end, token)) {
+        uint64_t delta = token >> 1;
+        if (token & 1) {
+            for (uint64_t gap = token >> 1; gap > 0 && remaining > 0; --gap, --remaining) {
+                visit(++sample, value);
+            }
+            if (remaining == 0 || !readVarint(p, end, delta)) {
+                break;
+            }
+        }
+        value += static_cast<uint64_t>(zigzagDecode(delta));
+        visit(++sample, value);
+        --remaining;
+    }
+    for (; remaining > 0; --remaining) {
+        visit(++sample, value);
+    }
+}
+
+bool ProcessHistory::query(const ProcessKey& key, uint64_t sinceMs, std::vector<Point>& points) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_seriesByKey.find(key);
+    if (it == m_seriesByKey.end()) {
+        return false;
+    }
+
+    // First retained sample at or after sinceMs; earlier blocks are skipped
+    // without decoding
+    uint64_t sinceSample = m_firstSample
+        + (std::lower_bound(m_timestamps.begin(), m_timestamps.end(), sinceMs) - m_timestamps.begin());
+
+    size_t before = points.size();
+    for (uint32_t index = m_series[it->second].firstBlock; index != kNoBlock; index = block(index).next) {
+        const Block& current = block(index);
+        if (current.firstSample + current.sampleCount <= sinceSample) {
+            continue;
+        }
+        decode(current, [&](uint64_t sample, uint64_t value) {
+            if (sample >= sinceSample) {
+                points.push_back(Point{m_timestamps[sample - m_firstSample], value << kValueShift});
+            }
+        });
+    }
+    return points.size() > before;
+}
+
+size_t ProcessHistory::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Hash nodes are estimated: key + id + next pointer + cached hash
+    return m_chunks.size() * kBlocksPerChunk * kBlockSize
+        + m_order.size() * sizeof(uint32_t)
+        + m_freeBlocks.capacity() * sizeof(uint32_t)
+        + m_series.capacity() * sizeof(Series)
+        + m_freeSeries.capacity() * sizeof(uint32_t)
+        + m_seriesByKey.size() * (sizeof(ProcessKey) + sizeof(uint32_t) + 2 * sizeof(void *))
+        + m_seriesByKey.bucket_count() * sizeof(void *)
+        + m_timestamps.size() * sizeof(uint64_t);
+}
+
+size_t ProcessHistory::seriesCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_seriesByKey.size();
+}
+
+size_t ProcessHistory::sampleCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timestamps.size();
+}
+
+uint64_t ProcessHistory::oldestTimestampMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timestamps.empty() ? 0 : m_timestamps.front();
+}
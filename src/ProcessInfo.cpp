@@ -1,7 +1,6 @@
 #include "ProcessInfo.h"
-#include <libproc.h>
-#include <sys/sysctl.h>
-#include <cstring>
+#include "ProcessCollector.h"
+#include <memory>
 
 ProcessInfo::ProcessInfo()
     : m_pid(0)
@@ -9,6 +8,7 @@ ProcessInfo::ProcessInfo()
     , m_path("")
     , m_residentSize(0)
     , m_virtualSize(0)
+    , m_startTime(0)
     , m_valid(false)
 {
 }
@@ -19,6 +19,7 @@ ProcessInfo::ProcessInfo(pid_t pid)
     , m_path("")
     , m_residentSize(0)
     , m_virtualSize(0)
+    , m_startTime(0)
     , m_valid(false)
 {
     update();
@@ -34,44 +35,9 @@ bool ProcessInfo::update() {
 }
 
 bool ProcessInfo::collectProcessInfo() {
-    // Get process task info (memory statistics)
-    struct proc_taskinfo ti;
-    int result = proc_pidinfo(m_pid, PROC_PIDTASKINFO, 0, &ti, sizeof(ti));
-
-    if (result != sizeof(ti)) {
-        // Process might have terminated or we don't have permission
-        m_valid = false;
-        return false;
-    }
-
-    m_residentSize = ti.pti_resident_size;
-    m_virtualSize = ti.pti_virtual_size;
-
-    // Get process path
-    char pathBuffer[PROC_PIDPATHINFO_MAXSIZE];
-    if (proc_pidpath(m_pid, pathBuffer, sizeof(pathBuffer)) > 0) {
-        m_path = pathBuffer;
-
-        // Extract process name from path
-        const char *lastSlash = strrchr(pathBuffer, '/');
-        if (lastSlash) {
-            m_name = lastSlash + 1;
-        } else {
-            m_name = pathBuffer;
-        }
-    } else {
-        // Fallback: try proc_name
-        char nameBuffer[256];
-        if (proc_name(m_pid, nameBuffer, sizeof(nameBuffer)) > 0) {
-            m_name = nameBuffer;
-        } else {
-            m_name = "Unknown";
-        }
-        m_path = "";
-    }
-
-    m_valid = true;
-    return true;
+    // One backend per thread: collectors own their read buffers
+    thread_local std::unique_ptr<ProcessCollector> collector = ProcessCollector::create();
+    return collector->collectProcess(m_pid, *this);
 }
 
 double ProcessInfo::getMemoryUsageGB() const {
@@ -0,0 +1,188 @@
+#include "ProcessScanPool.h"
+#include <algorithm>
+
+namespace {
+
+// Items a worker claims from its own shard at a time
+constexpr size_t kChunkSize = 8;
+
+// Below this many items per worker, threads cost more than they save
+constexpr size_t kMinItemsPerWorker = 64;
+
+uint64_t packRange(uint64_t begin, uint64_t end) {
+    return (begin << 32) | end;
+}
+
+size_t rangeBegin(uint64_t range) {
+    return static_cast<size_t>(range >> 32);
+}
+
+size_t rangeEnd(uint64_t range) {
+    return static_cast<size_t>(range & 0xffffffffu);
+}
+
+} // namespace
+
+ProcessScanPool::ProcessScanPool(size_t workerCount) {
+    setWorkerCount(workerCount);
+}
+
+ProcessScanPool::~ProcessScanPool() {
+    stopWorkers();
+}
+
+void ProcessScanPool::setWorkerCount(size_t workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (workerCount == m_collectors.size()) {
+        return;
+    }
+
+    stopWorkers();
+    m_collectors.resize(workerCount);
+    for (auto& collector : m_collectors) {
+        if (!collector) {
+            collector = ProcessCollector::create();
+        }
+    }
+    m_shards.reset(new Shard[workerCount]);
+    startWorkers(workerCount);
+}
+
+CollectorReadStats ProcessScanPool::takeReadStats() {
+    CollectorReadStats total;
+    for (auto& collector : m_collectors) {
+        CollectorReadStats stats = collector->takeReadStats();
+        total.bytesRead += stats.bytesRead;
+        total.vanished += stats.vanished;
+        total.failed += stats.failed;
+        total.syscalls += stats.syscalls;
+    }
+    return total;
+}
+
+void ProcessScanPool::startWorkers(size_t workerCount) {
+    m_stopping = false;
+    for (size_t worker = 1; worker < workerCount; ++worker) {
+        m_threads.emplace_back(&ProcessScanPool::workerLoop, this, worker, m_runId);
+    }
+}
+
+void ProcessScanPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+void ProcessScanPool::run(size_t count, const Task& task, size_t itemWeight) {
+    size_t workerCount = m_collectors.size();
+    if (workerCount == 1 || count * itemWeight < kMinItemsPerWorker * 2) {
+        for (size_t item = 0; item < count; ++item) {
+            task(*m_collectors[0], item);
+        }
+        return;
+    }
+
+    // Contiguous shard per worker; stealing rebalances from there
+    for (size_t worker = 0; worker < workerCount; ++worker) {
+        size_t begin = count * worker / workerCount;
+        size_t end = count * (worker + 1) / workerCount;
+        m_shards[worker].range.store(packRange(begin, end), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_chunkSize = std::max<size_t>(1, kChunkSize / itemWeight);
+        m_pendingWorkers = workerCount - 1;
+        ++m_runId;
+    }
+    m_wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pendingWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ProcessScanPool::workerLoop(size_t worker, uint64_t lastRunId) {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_runId != lastRunId; });
+            if (m_stopping) {
+                return;
+            }
+            lastRunId = m_runId;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pendingWorkers == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+void ProcessScanPool::drain(size_t worker) {
+    ProcessCollector& collector = *m_collectors[worker];
+    do {
+        size_t begin, end;
+        while (takeChunk(worker, begin, end)) {
+            for (size_t item = begin; item < end; ++item) {
+                (*m_task)(collector, item);
+            }
+        }
+    } while (steal(worker));
+}
+
+bool ProcessScanPool::takeChunk(size_t worker, size_t& begin, size_t& end) {
+    std::atomic<uint64_t>& range = m_shards[worker].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    for (;;) {
+        size_t first = rangeBegin(current);
+        size_t last = rangeEnd(current);
+        if (first >= last) {
+            return false;
+        }
+        size_t take = std::min(m_chunkSize, last - first);
+        if (range.compare_exchange_weak(current, packRange(first + take, last),
+                                        std::memory_order_acq_rel)) {
+            begin = first;
+            end = first + take;
+            return true;
+        }
+    }
+}
+
+bool ProcessScanPool::steal(size_t thief) {
+    size_t workerCount = m_collectors.size();
+    for (size_t offset = 1; offset < workerCount; ++offset) {
+        std::atomic<uint64_t>& victim = m_shards[(thief + offset) % workerCount].range;
+        uint64_t current = victim.load(std::memory_order_acquire);
+        for (;;) {
+            size_t first = rangeBegin(current);
+            size_t last = rangeEnd(current);
+            if (first >= last) {
+                break;
+            }
+            // Take the back half, or the last item
+            size_t middle = first + (last - first) / 2;
+            if (victim.compare_exchange_weak(current, packRange(first, middle),
+                                             std::memory_order_acq_rel)) {
+                m_shards[thief].range.store(packRange(middle, last), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
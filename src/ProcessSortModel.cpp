@@ -0,0 +1,79 @@
+#include "ProcessSortModel.h"
+#include "ProcessTableModel.h"
+#include "Instrumentation.h"
+
+ProcessSortModel::ProcessSortModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+    , m_processModel(nullptr)
+{
+    setSortRole(ProcessTableModel::SortRole);
+
+    // Any change of order or row set shifts every cumulative value below
+    // it. Views repaint on these signals by themselves, so the prefix is
+    // only dropped here; the column is announced once per snapshot below.
+    connect(this, &QAbstractItemModel::layoutChanged, this, &ProcessSortModel::invalidatePrefix);
+    connect(this, &QAbstractItemModel::rowsInserted, this, &ProcessSortModel::invalidatePrefix);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, &ProcessSortModel::invalidatePrefix);
+    connect(this, &QAbstractItemModel::modelReset, this, &ProcessSortModel::invalidatePrefix);
+}
+
+void ProcessSortModel::setSourceModel(QAbstractItemModel *sourceModel) {
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+    m_processModel = qobject_cast<ProcessTableModel *>(sourceModel);
+
+    // Fires after the base class has re-sorted for the whole update
+    if (m_processModel) {
+        connect(m_processModel, &ProcessTableModel::snapshotApplied,
+                this, &ProcessSortModel::onSnapshotApplied);
+    }
+}
+
+QVariant ProcessSortModel::data(const QModelIndex& index, int role) const {
+    if (index.isValid() && index.column() == ProcessTableModel::CumulativeColumn && m_processModel) {
+        if (role == Qt::DisplayRole) {
+            return ProcessTableModel::formatPercentage(cumulativeAt(index.row()));
+        }
+        if (role == ProcessTableModel::SortRole) {
+            return cumulativeAt(index.row());
+        }
+    }
+    return QSortFilterProxyModel::data(index, role);
+}
+
+bool ProcessSortModel::lessThan(const QModelIndex& left, const QModelIndex& right) const {
+    // Cumulative % grows down the table, so ascending cumulative order is
+    // descending % of Total
+    if (left.column() == ProcessTableModel::CumulativeColumn && m_processModel) {
+        return m_processModel->percentageAt(left.row()) > m_processModel->percentageAt(right.row());
+    }
+    return QSortFilterProxyModel::lessThan(left, right);
+}
+
+double ProcessSortModel::cumulativeAt(int row) const {
+    if (row >= static_cast<int>(m_prefix.size())) {
+        MM_TIME_SCOPE(CumulativePhase);
+        double cumulativePercent = m_prefix.empty() ? 0.0 : m_prefix.back();
+        m_prefix.reserve(rowCount());
+        for (int visualRow = static_cast<int>(m_prefix.size()); visualRow <= row; ++visualRow) {
+            cumulativePercent += m_processModel->percentageAt(mapToSource(index(visualRow, 0)).row());
+            m_prefix.push_back(cumulativePercent);
+        }
+    }
+    return m_prefix[row];
+}
+
+void ProcessSortModel::invalidatePrefix() {
+    m_prefix.clear();
+}
+
+void ProcessSortModel::onSnapshotApplied() {
+    // Values may have changed without any reordering, so always drop it
+    m_prefix.clear();
+
+    // Views only repaint the visible part of the column
+    int rows = rowCount();
+    if (rows > 0) {
+        emit dataChanged(index(0, ProcessTableModel::CumulativeColumn),
+                         index(rows - 1, ProcessTableModel::CumulativeColumn));
+    }
+}
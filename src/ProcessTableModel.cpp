@@ -0,0 +1,274 @@
+#include "ProcessTableModel.h"
+#include "Instrumentation.h"
+#include <QColor>
+#include <algorithm>
+
+namespace {
+
+// 0 = not read; otherwise whether the value is older than the threshold
+// at the snapshot's time. Both draw greyed out.
+bool accountingStale(const MemorySnapshot& snapshot, uint32_t index) {
+    const auto& times = snapshot.getAccountedTimes();
+    if (index >= times.size()) {
+        return false;  // no accounting at all: nothing to grey out
+    }
+    return times[index] == 0
+        || snapshot.getTimestampMs() > times[index] + ProcessTableModel::kStaleAccountingMs;
+}
+
+uint64_t accountedAt(const MemorySnapshot& snapshot, uint32_t index) {
+    const auto& times = snapshot.getAccountedTimes();
+    return index < times.size() ? times[index] : 0;
+}
+
+} // namespace
+
+ProcessTableModel::ProcessTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int ProcessTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int ProcessTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+ProcessRef ProcessTableModel::processAt(int row) const {
+    return m_snapshot->process(m_rows[row].index);
+}
+
+double ProcessTableModel::percentageAt(int row) const {
+    return processAt(row).getMemoryPercentage(m_snapshot->getTotalPhysicalRAM());
+}
+
+QVariant ProcessTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= static_cast<int>(m_rows.size())) {
+        return QVariant();
+    }
+
+    const int row = index.row();
+    const ProcessRef proc = processAt(row);
+    if (index.column() >= ProportionalColumn) {
+        return accountingData(proc, index.column(), role);
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case NameColumn: return QString::fromStdString(proc.getName());
+        case PathColumn: return QString::fromStdString(proc.getPath());
+        case MemoryColumn: return formatMemorySize(proc.getResidentSize());
+        case PercentColumn: return formatPercentage(percentageAt(row));
+        case GrowthColumn: return formatGrowthRate(proc.getGrowthRate());
+        }
+        break;
+
+    case SortRole:
+        switch (index.column()) {
+        case NameColumn: return QString::fromStdString(proc.getName());
+        case PathColumn: return QString::fromStdString(proc.getPath());
+        case MemoryColumn: return QVariant::fromValue(proc.getResidentSize());
+        case PercentColumn: return percentageAt(row);
+        case GrowthColumn: return proc.getGrowthRate();
+        }
+        break;
+
+    case Qt::ForegroundRole:
+        if (index.column() == GrowthColumn) {
+            const auto& growing = m_snapshot->getGrowingProcesses();
+            if (std::find(growing.begin(), growing.end(), m_rows[row].index) != growing.end()) {
+                return QColor(Qt::red);
+            }
+        }
+        break;
+    }
+
+    return QVariant();
+}
+
+QVariant ProcessTableModel::accountingData(const ProcessRef& proc, int column, int role) const {
+    if (!m_snapshot->hasAccounting()) {
+        return QVariant();
+    }
+    uint64_t value = column == ProportionalColumn ? proc.getProportionalSize()
+                   : column == UniqueColumn ? proc.getUniqueSize() : proc.getSwapSize();
+    uint64_t readAtMs = proc.getAccountedTimeMs();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return readAtMs ? formatMemorySize(value) : QStringLiteral("\u2013");
+    case SortRole:
+        return QVariant::fromValue(value);
+    case Qt::ForegroundRole:
+        if (accountingStale(*m_snapshot, static_cast<uint32_t>(proc.index()))) {
+            return QColor(Qt::gray);
+        }
+        break;
+    case Qt::ToolTipRole:
+        if (!readAtMs) {
+            return QStringLiteral("Not read yet");
+        }
+        return QString("Read %1 s before this sample")
+            .arg((m_snapshot->getTimestampMs() - std::min(readAtMs, m_snapshot->getTimestampMs())) / 1000.0, 0, 'f', 1);
+    }
+    return QVariant();
+}
+
+QVariant ProcessTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+    case NameColumn: return QStringLiteral("Process Name");
+    case PathColumn: return QStringLiteral("Path");
+    case MemoryColumn: return QStringLiteral("RAM Usage");
+    case PercentColumn: return QStringLiteral("% of Total");
+    case CumulativeColumn: return QStringLiteral("Cumulative %");
+    case GrowthColumn: return QStringLiteral("Growth");
+    case ProportionalColumn: return QStringLiteral("PSS");
+    case UniqueColumn: return QStringLiteral("USS");
+    case SwapColumn: return QStringLiteral("Swap");
+    }
+    return QVariant();
+}
+
+bool ProcessTableModel::findInNext(const MemorySnapshot& next, Row& row) {
+    auto it = m_nextIndexByPid.find(row.key.pid);
+    if (it == m_nextIndexByPid.end() || next.getStartTimes()[it->second] != row.key.startTime) {
+        return false;
+    }
+    row.next = it->second;
+    m_claimed[it->second] = true;
+    return true;
+}
+
+void ProcessTableModel::setSnapshot(SnapshotPtr snapshot) {
+    if (!snapshot) {
+        return;
+    }
+
+    MM_TIME_SCOPE(TableUpdatePhase);
+    const MemorySnapshot& next = *snapshot;
+    const std::vector<pid_t>& nextPids = next.getPids();
+    const std::vector<uint64_t>& nextStartTimes = next.getStartTimes();
+    const uint32_t nextCount = static_cast<uint32_t>(next.getProcessCount());
+
+    if (!m_snapshot) {
+        beginResetModel();
+        m_snapshot = std::move(snapshot);
+        m_rows.clear();
+        for (uint32_t i = 0; i < nextCount; ++i) {
+            m_rows.push_back({{nextPids[i], nextStartTimes[i]}, i, i});
+        }
+        endResetModel();
+        MM_COUNT(RowsTouched, nextCount);
+        emit snapshotApplied();
+        return;
+    }
+
+    m_nextIndexByPid.clear();
+    for (uint32_t i = 0; i < nextCount; ++i) {
+        m_nextIndexByPid[nextPids[i]] = i;
+    }
+    m_claimed.assign(nextCount, false);
+
+    // 1. Exited processes, removed back to front in contiguous runs
+    for (int row = static_cast<int>(m_rows.size()) - 1; row >= 0; --row) {
+        if (findInNext(next, m_rows[row])) {
+            continue;
+        }
+        int last = row;
+        while (row > 0 && !findInNext(next, m_rows[row - 1])) {
+            --row;
+        }
+        beginRemoveRows(QModelIndex(), row, last);
+        m_rows.erase(m_rows.begin() + row, m_rows.begin() + last + 1);
+        endRemoveRows();
+        MM_COUNT(RowsTouched, last - row + 1);
+    }
+
+    // 2. Remap every row to the new snapshot, then report the changed
+    // counters with a single dataChanged over the span of changed rows.
+    // Each dataChanged re-sorts the proxy (reading other rows, so none may
+    // still index the previous snapshot), so one signal costs one re-sort
+    // however scattered the changes are.
+    SnapshotPtr previous = std::move(m_snapshot);
+    const std::vector<uint64_t>& oldSizes = previous->getResidentSizes();
+    const std::vector<uint64_t>& nextSizes = next.getResidentSizes();
+    const std::vector<float>& oldRates = previous->getGrowthRates();
+    const std::vector<float>& nextRates = next.getGrowthRates();
+    auto rateAt = [](const std::vector<float>& rates, uint32_t i) {
+        return i < rates.size() ? rates[i] : 0.0f;  // unanalyzed samples have no rates
+    };
+    bool totalChanged = previous->getTotalPhysicalRAM() != next.getTotalPhysicalRAM();
+
+    int firstChanged = -1;
+    int lastChanged = -1;
+    int changedRows = 0;
+    for (size_t row = 0; row < m_rows.size(); ++row) {
+        Row& r = m_rows[row];
+        bool changed = totalChanged
+            || oldSizes[r.index] != nextSizes[r.next]
+            || rateAt(oldRates, r.index) != rateAt(nextRates, r.next)
+            || accountedAt(*previous, r.index) != accountedAt(next, r.next)
+            || accountingStale(*previous, r.index) != accountingStale(next, r.next);
+        r.index = r.next;
+        if (changed) {
+            firstChanged = firstChanged < 0 ? static_cast<int>(row) : firstChanged;
+            lastChanged = static_cast<int>(row);
+            ++changedRows;
+        }
+    }
+    m_snapshot = std::move(snapshot);
+
+    if (firstChanged >= 0) {
+        emit dataChanged(index(firstChanged, MemoryColumn), index(lastChanged, ColumnCount - 1));
+        MM_COUNT(RowsTouched, changedRows);
+    }
+
+    // 3. New processes, appended in one batch
+    int added = 0;
+    for (bool claimed : m_claimed) {
+        added += claimed ? 0 : 1;
+    }
+    if (added > 0) {
+        int first = static_cast<int>(m_rows.size());
+        beginInsertRows(QModelIndex(), first, first + added - 1);
+        for (uint32_t i = 0; i < nextCount; ++i) {
+            if (!m_claimed[i]) {
+                m_rows.push_back({{nextPids[i], nextStartTimes[i]}, i, i});
+            }
+        }
+        endInsertRows();
+        MM_COUNT(RowsTouched, added);
+    }
+    emit snapshotApplied();
+}
+
+QString ProcessTableModel::formatMemorySize(uint64_t bytes) {
+    const double GB = 1024.0 * 1024.0 * 1024.0;
+    const double MB = 1024.0 * 1024.0;
+
+    if (bytes >= GB) {
+        return QString("%1 GB").arg(bytes / GB, 0, 'f', 2);
+    } else {
+        return QString("%1 MB").arg(bytes / MB, 0, 'f', 1);
+    }
+}
+
+QString ProcessTableModel::formatPercentage(double percentage) {
+    return QString("%1%").arg(percentage, 0, 'f', 2);
+}
+
+QString ProcessTableModel::formatGrowthRate(double bytesPerSecond) {
+    // Under 0.1 MB/h reads as flat
+    double megabytesPerHour = bytesPerSecond * 3600.0 / (1024.0 * 1024.0);
+    if (megabytesPerHour > -0.1 && megabytesPerHour < 0.1) {
+        return QString();
+    }
+    return QString("%1%2 MB/h").arg(megabytesPerHour > 0 ? "+" : "").arg(megabytesPerHour, 0, 'f', 1);
+}
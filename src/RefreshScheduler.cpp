@@ -0,0 +1,90 @@
+#include "RefreshScheduler.h"
+#include <algorithm>
+
+namespace {
+
+// Never sample faster than this, whatever the base interval
+constexpr double kFloorIntervalMs = 250.0;
+constexpr double kMaxStretchMs = 5 * 60 * 1000.0;
+
+// Fraction of physical RAM changing residency per second. 0.1%/s is
+// ~16 MB/s on a 16 GB machine.
+constexpr double kBusyActivity = 0.001;
+constexpr double kQuietActivity = 0.0001;
+constexpr int kQuietSamplesBeforeBackoff = 3;
+
+constexpr double kCostSmoothing = 0.3;
+
+} // namespace
+
+RefreshScheduler::RefreshScheduler()
+    : m_baseMs(0)
+    , m_adaptive(false)
+    , m_cpuBudget(0.0)
+    , m_intervalMs(0.0)
+    , m_cycleCpuNs(0.0)
+    , m_haveCost(false)
+    , m_quietSamples(0)
+{
+}
+
+void RefreshScheduler::setBaseInterval(uint64_t ms) {
+    m_baseMs = ms;
+    m_intervalMs = static_cast<double>(ms);
+    m_quietSamples = 0;
+}
+
+void RefreshScheduler::setAdaptive(bool adaptive) {
+    m_adaptive = adaptive;
+    m_intervalMs = static_cast<double>(m_baseMs);
+    m_quietSamples = 0;
+}
+
+void RefreshScheduler::setCpuBudget(double fraction) {
+    m_cpuBudget = std::max(0.0, fraction);
+}
+
+double RefreshScheduler::minInterval() const {
+    return std::min(static_cast<double>(m_baseMs), std::max(kFloorIntervalMs, m_baseMs / 4.0));
+}
+
+double RefreshScheduler::maxInterval() const {
+    return std::max(static_cast<double>(m_baseMs), std::min(kMaxStretchMs, m_baseMs * 8.0));
+}
+
+void RefreshScheduler::recordSample(uint64_t cycleCpuNs, double activity) {
+    if (m_haveCost) {
+        m_cycleCpuNs += kCostSmoothing * (static_cast<double>(cycleCpuNs) - m_cycleCpuNs);
+    } else {
+        m_cycleCpuNs = static_cast<double>(cycleCpuNs);
+        m_haveCost = true;
+    }
+
+    if (!m_adaptive || m_baseMs == 0) {
+        return;
+    }
+    if (activity >= kBusyActivity) {
+        // Straight back from an idle back-off, then halve per busy sample
+        m_quietSamples = 0;
+        m_intervalMs = std::max(minInterval(), std::min(m_intervalMs, static_cast<double>(m_baseMs)) / 2.0);
+    } else if (activity < kQuietActivity) {
+        if (++m_quietSamples >= kQuietSamplesBeforeBackoff) {
+            m_intervalMs = std::min(maxInterval(), m_intervalMs * 1.5);
+        }
+    } else {
+        // Ordinary churn: drift back to what the user asked for
+        m_quietSamples = 0;
+        m_intervalMs += (static_cast<double>(m_baseMs) - m_intervalMs) / 2.0;
+    }
+}
+
+uint64_t RefreshScheduler::nextInterval() const {
+    if (m_baseMs == 0) {
+        return 0;
+    }
+    double intervalMs = m_adaptive ? m_intervalMs : static_cast<double>(m_baseMs);
+    if (m_cpuBudget > 0.0 && m_haveCost) {
+        intervalMs = std::max(intervalMs, m_cycleCpuNs / 1e6 / m_cpuBudget);
+    }
+    return static_cast<uint64_t>(intervalMs + 0.5);
+}
@@ -0,0 +1,114 @@
+#include "ReplaySource.h"
+#include <algorithm>
+
+namespace {
+
+// Shown + held by the table model while diffing + being decoded
+constexpr size_t kSnapshotPoolSize = 3;
+
+} // namespace
+
+ReplaySource::ReplaySource(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_position(0)
+    , m_speed(1.0)
+    , m_playing(false)
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ReplaySource::onTimer);
+}
+
+bool ReplaySource::open(const QString& path) {
+    pause();
+    m_current.reset();
+    if (!m_recording.open(path.toStdString())) {
+        emit errorOccurred(QString("Cannot read recording %1").arg(path));
+        return false;
+    }
+    return showSample(0);
+}
+
+void ReplaySource::play() {
+    if (!m_recording.isOpen() || m_playing) {
+        return;
+    }
+    if (m_position + 1 >= m_recording.sampleCount()) {
+        showSample(0);  // restart from the beginning
+    }
+    m_playing = true;
+    scheduleNext();
+}
+
+void ReplaySource::pause() {
+    m_playing = false;
+    m_timer->stop();
+}
+
+void ReplaySource::seek(int index) {
+    if (index < 0 || static_cast<size_t>(index) >= m_recording.sampleCount()) {
+        return;
+    }
+    if (showSample(static_cast<size_t>(index)) && m_playing) {
+        scheduleNext();
+    }
+}
+
+void ReplaySource::step() {
+    pause();
+    seek(static_cast<int>(m_position) + 1);
+}
+
+void ReplaySource::setSpeed(double speed) {
+    m_speed = std::max(speed, 0.01);
+    if (m_playing) {
+        scheduleNext();
+    }
+}
+
+bool ReplaySource::showSample(size_t index) {
+    std::shared_ptr<MemorySnapshot> snapshot;
+    for (auto& pooled : m_snapshotPool) {
+        if (pooled.use_count() == 1) {
+            snapshot = pooled;
+            break;
+        }
+    }
+    if (!snapshot) {
+        snapshot = std::make_shared<MemorySnapshot>();
+        if (m_snapshotPool.size() < kSnapshotPoolSize) {
+            m_snapshotPool.push_back(snapshot);
+        }
+    }
+
+    if (!m_recording.readSample(index, *snapshot)) {
+        pause();
+        emit errorOccurred(QString("Recording is damaged at sample %1").arg(index));
+        return false;
+    }
+
+    m_position = index;
+    m_current = std::move(snapshot);
+    emit positionChanged(static_cast<int>(m_position), sampleCount());
+    emit dataReady();
+    return true;
+}
+
+void ReplaySource::scheduleNext() {
+    if (m_position + 1 >= m_recording.sampleCount()) {
+        pause();
+        emit finished();
+        return;
+    }
+    uint64_t now = m_recording.timestampAt(m_position);
+    uint64_t next = m_recording.timestampAt(m_position + 1);
+    double delayMs = next > now ? (next - now) / m_speed : 0.0;
+    m_timer->start(static_cast<int>(std::min(delayMs, 60.0 * 60.0 * 1000.0)));
+}
+
+void ReplaySource::onTimer() {
+    if (m_playing && showSample(m_position + 1)) {
+        scheduleNext();
+    }
+}
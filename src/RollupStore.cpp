@@ -0,0 +1,675 @@
+#include "RollupStore.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "VarInt.h"
+
+// File layout, integers little-endian:
+//
+//   uint32_t magic "MMRU", uint32_t version, uint64_t latestTimestampMs
+//   varint length, bytes: boot id (version 2)
+//   varint nameCount, { varint length, bytes } per name
+//   tier x 2 per system counter (free, active, inactive, wired)
+//   varint seriesCount, { varint pid, varint startTime, varint name, tier x 2 } per series
+//   same again for the detached series (version 2)
+//
+//   tier: varint entryCount, varint lastBucket, then per entry
+//         varint bucket (delta from the previous entry, absolute for the first),
+//         varint min, varint max - min, varint average - min, varint last - min
+//
+// An open bucket is saved as an ordinary entry; samples arriving for the
+// same bucket after a reload are merged into it.
+//
+// Version 1 files carry no boot id; where keys depend on the boot (the
+// store has a boot id) their series load detached.
+
+namespace {
+
+constexpr uint32_t kRollupMagic = 0x55524d4d;  // "MMRU"
+constexpr uint32_t kRollupVersion = 2;
+
+constexpr uint32_t kMinuteRetentionBuckets = 24 * 60;  // 1 day
+constexpr uint32_t kHourRetentionBuckets = 35 * 24;        // 35 days
+
+uint32_t toKiB(uint64_t bytes) {
+    return static_cast<uint32_t>(std::min<uint64_t>(bytes >> 10, UINT32_MAX));
+}
+
+bool writeFile(const std::string& path, const std::string& data) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    const char *p = data.data();
+    size_t remaining = data.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, p, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            return false;
+        }
+        p += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    return ::close(fd) == 0;
+}
+
+bool readFile(const std::string& path, std::string& data) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    data.resize(static_cast<size_t>(info.st_size));
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t got = ::read(fd, &data[done], data.size() - done);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            ::close(fd);
+            return false;
+        }
+        done += static_cast<size_t>(got);
+    }
+    ::close(fd);
+    return true;
+}
+
+bool readVarint32(const uint8_t *&p, const uint8_t *end, uint32_t& value) {
+    uint64_t wide;
+    if (!readVarint(p, end, wide) || wide > UINT32_MAX) {
+        return false;
+    }
+    value = static_cast<uint32_t>(wide);
+    return true;
+}
+
+} // namespace
+
+// Running result of a range query
+struct RollupStore::Accumulator {
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    uint64_t weightedSum = 0;
+    uint64_t buckets = 0;
+    uint64_t last = 0;
+    uint32_t lastBucket = 0;
+
+    void add(uint32_t entryMin, uint32_t entryMax, uint32_t average, uint32_t entryLast,
+             uint64_t weight, uint32_t bucket) {
+        min = std::min<uint64_t>(min, entryMin);
+        max = std::max<uint64_t>(max, entryMax);
+        weightedSum += static_cast<uint64_t>(average) * weight;
+        if (buckets == 0 || bucket >= lastBucket) {
+            last = entryLast;
+            lastBucket = bucket;
+        }
+        buckets += weight;
+    }
+
+    Stats stats() const {
+        Stats result;
+        if (buckets > 0) {
+            result.min = min << 10;
+            result.max = max << 10;
+            result.average = (weightedSum / buckets) << 10;
+            result.last = last << 10;
+            result.buckets = buckets;
+        }
+        return result;
+    }
+};
+
+RollupStore::RollupStore()
+    : m_latestTimestampMs(0)
+    , m_lastSweepHour(0)
+{
+}
+
+uint64_t RollupStore::interval(int tier) {
+    return tier == MinuteTier ? kMinuteMs : kHourMs;
+}
+
+uint32_t RollupStore::retentionBuckets(int tier) {
+    return tier == MinuteTier ? kMinuteRetentionBuckets : kHourRetentionBuckets;
+}
+
+void RollupStore::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    reset();
+}
+
+void RollupStore::setBootId(const std::string& bootId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bootId = bootId;
+}
+
+void RollupStore::reset() {
+    m_series.clear();
+    m_freeSeries.clear();
+    m_seriesByKey.clear();
+    m_detached.clear();
+    m_names.clear();
+    m_seriesByName.clear();
+    m_nameIndex.clear();
+    for (auto& counter : m_system) {
+        for (auto& tier : counter) {
+            tier = TierSeries();
+        }
+    }
+    m_latestTimestampMs = 0;
+    m_lastSweepHour = 0;
+}
+
+void RollupStore::append(const MemorySnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint64_t timestampMs = snapshot.getTimestampMs();
+    m_latestTimestampMs = std::max(m_latestTimestampMs, timestampMs);
+    uint32_t buckets[TierCount];
+    for (int tier = 0; tier < TierCount; ++tier) {
+        buckets[tier] = static_cast<uint32_t>(timestampMs / interval(tier));
+    }
+
+    const uint32_t counters[SystemCounterCount] = {
+        toKiB(snapshot.getFreeMemory()),
+        toKiB(snapshot.getActiveMemory()),
+        toKiB(snapshot.getInactiveMemory()),
+        toKiB(snapshot.getWiredMemory())
+    };
+    for (int counter = 0; counter < SystemCounterCount; ++counter) {
+        for (int tier = 0; tier < TierCount; ++tier) {
+            add(m_system[counter][tier], tier, buckets[tier], counters[counter]);
+        }
+    }
+
+    const auto& pids = snapshot.getPids();
+    const auto& startTimes = snapshot.getStartTimes();
+    const auto& residentSizes = snapshot.getResidentSizes();
+    for (size_t i = 0; i < pids.size(); ++i) {
+        ProcessKey key{pids[i], startTimes[i]};
+        auto it = m_seriesByKey.find(key);
+        uint32_t seriesId = it != m_seriesByKey.end() ? it->second
+                                                      : seriesFor(key, snapshot.process(i).getName());
+        Series& series = m_series[seriesId];
+        uint32_t value = toKiB(residentSizes[i]);
+        for (int tier = 0; tier < TierCount; ++tier) {
+            add(series.tiers[tier], tier, buckets[tier], value);
+        }
+    }
+
+    // Exited processes will not close their buckets by themselves
+    for (const ProcessKey& key : snapshot.getRemovedProcesses()) {
+        auto it = m_seriesByKey.find(key);
+        if (it != m_seriesByKey.end()) {
+            for (int tier = 0; tier < TierCount; ++tier) {
+                close(m_series[it->second].tiers[tier], tier);
+            }
+        }
+    }
+
+    if (buckets[HourTier] != m_lastSweepHour) {
+        sweep(buckets[HourTier]);
+        m_lastSweepHour = buckets[HourTier];
+    }
+}
+
+uint32_t RollupStore::seriesFor(const ProcessKey& key, const std::string& name) {
+    uint32_t seriesId = allocateSeries(key, name);
+    m_seriesByKey.emplace(key, seriesId);
+    return seriesId;
+}
+
+uint32_t RollupStore::allocateSeries(const ProcessKey& key, const std::string& name) {
+    auto inserted = m_nameIndex.try_emplace(name, static_cast<uint32_t>(m_names.size()));
+    if (inserted.second) {
+        m_names.push_back(name);
+        m_seriesByName.emplace_back();
+    }
+    uint32_t nameIndex = inserted.first->second;
+
+    uint32_t seriesId;
+    if (!m_freeSeries.empty()) {
+        seriesId = m_freeSeries.back();
+        m_freeSeries.pop_back();
+    } else {
+        seriesId = static_cast<uint32_t>(m_series.size());
+        m_series.emplace_back();
+    }
+    Series& series = m_series[seriesId];
+    series.key = key;
+    series.name = nameIndex;
+    m_seriesByName[nameIndex].push_back(seriesId);
+    return seriesId;
+}
+
+void RollupStore::releaseSeries(uint32_t seriesId) {
+    Series& series = m_series[seriesId];
+    auto keyed = m_seriesByKey.find(series.key);
+    if (keyed != m_seriesByKey.end() && keyed->second == seriesId) {
+        m_seriesByKey.erase(keyed);
+    } else {
+        // A detached key may equal a live one
+        auto detached = std::find(m_detached.begin(), m_detached.end(), seriesId);
+        if (detached != m_detached.end()) {
+            *detached = m_detached.back();
+            m_detached.pop_back();
+        }
+    }
+    auto& byName = m_seriesByName[series.name];
+    auto it = std::find(byName.begin(), byName.end(), seriesId);
+    if (it != byName.end()) {
+        *it = byName.back();
+        byName.pop_back();
+    }
+    for (auto& tier : series.tiers) {
+        tier = TierSeries();  // frees the deque's blocks
+    }
+    m_freeSeries.push_back(seriesId);
+}
+
+void RollupStore::sweep(uint32_t hour) {
+    // Hourly: exited processes only expire here
+    uint32_t current[TierCount] = {
+        static_cast<uint32_t>(uint64_t(hour) * (kHourMs / kMinuteMs)),
+        hour
+    };
+    for (auto& counter : m_system) {
+        for (int tier = 0; tier < TierCount; ++tier) {
+            expire(counter[tier], tier, current[tier]);
+        }
+    }
+
+    std::vector<uint32_t> empty;
+    std::vector<uint32_t> ids = m_detached;
+    for (const auto& item : m_seriesByKey) {
+        ids.push_back(item.second);
+    }
+    for (uint32_t id : ids) {
+        Series& series = m_series[id];
+        bool keep = false;
+        for (int tier = 0; tier < TierCount; ++tier) {
+            expire(series.tiers[tier], tier, current[tier]);
+            keep = keep || !series.tiers[tier].entries.empty() || series.tiers[tier].open.count > 0;
+        }
+        if (!keep) {
+            empty.push_back(id);
+        }
+    }
+    for (uint32_t id : empty) {
+        releaseSeries(id);
+    }
+}
+
+void RollupStore::add(TierSeries& series, int tier, uint32_t bucket, uint32_t value) {
+    OpenBucket& open = series.open;
+    if (open.count > 0 && bucket > open.bucket) {
+        close(series, tier);
+    }
+    if (open.count == 0) {
+        // Never reopen a bucket before the ones already stored (clock steps)
+        if (!series.entries.empty()) {
+            bucket = std::max(bucket, series.lastBucket);
+        }
+        open = OpenBucket{bucket, value, value, value, 0, 0};
+    }
+    open.min = std::min(open.min, value);
+    open.max = std::max(open.max, value);
+    open.last = value;
+    open.sum += value;
+    ++open.count;
+}
+
+void RollupStore::close(TierSeries& series, int tier) {
+    OpenBucket& open = series.open;
+    if (open.count == 0) {
+        return;
+    }
+    Entry entry{open.bucket, open.min, open.max, static_cast<uint32_t>(open.sum / open.count), open.last};
+    open.count = 0;
+    store(series, entry);
+    expire(series, tier, entry.bucket);
+}
+
+void RollupStore::store(TierSeries& series, const Entry& entry) {
+    auto& entries = series.entries;
+    if (!entries.empty()) {
+        Entry& back = entries.back();
+        if (back.bucket == entry.bucket) {
+            // Same bucket continued after a reload
+            back.min = std::min(back.min, entry.min);
+            back.max = std::max(back.max, entry.max);
+            back.average = static_cast<uint32_t>((uint64_t(back.average) + entry.average) / 2);
+            back.last = entry.last;
+        } else if (back.min != entry.min || back.max != entry.max
+                   || back.average != entry.average || back.last != entry.last) {
+            entries.push_back(entry);
+        }
+        // else: a repeat, covered by extending lastBucket
+    } else {
+        entries.push_back(entry);
+    }
+    series.lastBucket = std::max(series.lastBucket, entry.bucket);
+}
+
+void RollupStore::expire(TierSeries& series, int tier, uint32_t currentBucket) {
+    uint32_t retention = retentionBuckets(tier);
+    if (currentBucket < retention) {
+        return;
+    }
+    uint32_t oldest = currentBucket - retention + 1;
+
+    auto& entries = series.entries;
+    while (entries.size() > 1 && entries[1].bucket <= oldest) {
+        entries.pop_front();
+    }
+    if (!entries.empty()) {
+        if (series.lastBucket < oldest) {
+            entries.clear();
+        } else if (entries.front().bucket < oldest) {
+            entries.front().bucket = oldest;  // still covers the retention edge
+        }
+    }
+}
+
+void RollupStore::collect(const TierSeries& series, uint32_t fromBucket, uint32_t toBucket,
+                          Accumulator& accumulator) {
+    const auto& entries = series.entries;
+    auto it = std::upper_bound(entries.begin(), entries.end(), fromBucket,
+                               [](uint32_t bucket, const Entry& entry) { return bucket < entry.bucket; });
+    if (it != entries.begin()) {
+        --it;
+    }
+    for (; it != entries.end() && it->bucket <= toBucket; ++it) {
+        auto next = it + 1;
+        uint32_t coverageEnd = next != entries.end() ? next->bucket - 1 : series.lastBucket;
+        if (coverageEnd < fromBucket) {
+            continue;
+        }
+        uint32_t start = std::max(it->bucket, fromBucket);
+        uint32_t stop = std::min(coverageEnd, toBucket);
+        accumulator.add(it->min, it->max, it->average, it->last, stop - start + 1, stop);
+    }
+
+    const OpenBucket& open = series.open;
+    if (open.count > 0 && open.bucket >= fromBucket && open.bucket <= toBucket) {
+        accumulator.add(open.min, open.max, static_cast<uint32_t>(open.sum / open.count), open.last,
+                        1, open.bucket);
+    }
+}
+
+int RollupStore::tierFor(uint64_t fromMs, uint64_t toMs, uint64_t latestMs) {
+    uint64_t minuteRetentionMs = uint64_t(kMinuteRetentionBuckets) * kMinuteMs;
+    bool covered = latestMs < minuteRetentionMs || fromMs >= latestMs - minuteRetentionMs;
+    return covered && toMs - fromMs <= 24 * kHourMs ? MinuteTier : HourTier;
+}
+
+RollupStore::Stats RollupStore::processStats(const ProcessKey& key, uint64_t fromMs, uint64_t toMs) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Accumulator accumulator;
+    auto it = m_seriesByKey.find(key);
+    if (it != m_seriesByKey.end() && toMs > fromMs) {
+        int tier = tierFor(fromMs, toMs, m_latestTimestampMs);
+        collect(m_series[it->second].tiers[tier], static_cast<uint32_t>(fromMs / interval(tier)),
+                static_cast<uint32_t>((toMs - 1) / interval(tier)), accumulator);
+    }
+    return accumulator.stats();
+}
+
+RollupStore::Stats RollupStore::nameStats(const std::string& name, uint64_t fromMs, uint64_t toMs) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Accumulator accumulator;
+    auto it = m_nameIndex.find(name);
+    if (it != m_nameIndex.end() && toMs > fromMs) {
+        int tier = tierFor(fromMs, toMs, m_latestTimestampMs);
+        uint32_t fromBucket = static_cast<uint32_t>(fromMs / interval(tier));
+        uint32_t toBucket = static_cast<uint32_t>((toMs - 1) / interval(tier));
+        for (uint32_t seriesId : m_seriesByName[it->second]) {
+            collect(m_series[seriesId].tiers[tier], fromBucket, toBucket, accumulator);
+        }
+    }
+    return accumulator.stats();
+}
+
+RollupStore::Stats RollupStore::systemStats(SystemCounter counter, uint64_t fromMs, uint64_t toMs) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Accumulator accumulator;
+    if (toMs > fromMs) {
+        int tier = tierFor(fromMs, toMs, m_latestTimestampMs);
+        collect(m_system[counter][tier], static_cast<uint32_t>(fromMs / interval(tier)),
+                static_cast<uint32_t>((toMs - 1) / interval(tier)), accumulator);
+    }
+    return accumulator.stats();
+}
+
+uint64_t RollupStore::latestTimestampMs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_latestTimestampMs;
+}
+
+size_t RollupStore::seriesCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_seriesByKey.size() + m_detached.size();
+}
+
+size_t RollupStore::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t entries = 0;
+    for (const auto& counter : m_system) {
+        for (const auto& tier : counter) {
+            entries += tier.entries.size();
+        }
+    }
+    for (const auto& series : m_series) {
+        for (const auto& tier : series.tiers) {
+            entries += tier.entries.size();
+        }
+    }
+    size_t names = 0;
+    for (const auto& name : m_names) {
+        names += name.capacity() + sizeof(std::string);
+    }
+    // Hash nodes estimated as key + value + next pointer + cached hash
+    return entries * sizeof(Entry)
+        + m_series.capacity() * sizeof(Series)
+        + m_seriesByKey.size() * (sizeof(ProcessKey) + sizeof(uint32_t) + 2 * sizeof(void *))
+        + m_seriesByKey.bucket_count() * sizeof(void *)
+        + names * 2;
+}
+
+void RollupStore::writeTier(std::string& out, const TierSeries& series) {
+    bool open = series.open.count > 0;
+    appendVarint(out, series.entries.size() + (open ? 1 : 0));
+    appendVarint(out, open ? std::max(series.lastBucket, series.open.bucket) : series.lastBucket);
+
+    uint32_t previous = 0;
+    auto writeEntry = [&](uint32_t bucket, uint32_t min, uint32_t max, uint32_t average, uint32_t last) {
+        appendVarint(out, bucket - previous);
+        appendVarint(out, min);
+        appendVarint(out, max - min);
+        appendVarint(out, average - min);
+        appendVarint(out, last - min);
+        previous = bucket;
+    };
+    for (const Entry& entry : series.entries) {
+        writeEntry(entry.bucket, entry.min, entry.max, entry.average, entry.last);
+    }
+    if (open) {
+        const OpenBucket& bucket = series.open;
+        writeEntry(bucket.bucket, bucket.min, bucket.max,
+                   static_cast<uint32_t>(bucket.sum / bucket.count), bucket.last);
+    }
+}
+
+bool RollupStore::readTier(const uint8_t *&p, const uint8_t *end, TierSeries& series) {
+    uint64_t count;
+    uint32_t lastBucket;
+    if (!readVarint(p, end, count) || !readVarint32(p, end, lastBucket)
+        || count > static_cast<uint64_t>(end - p)) {
+        return false;
+    }
+    uint32_t bucket = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint32_t delta;
+        Entry entry;
+        uint32_t maxDelta, averageDelta, lastDelta;
+        if (!readVarint32(p, end, delta) || !readVarint32(p, end, entry.min)
+            || !readVarint32(p, end, maxDelta) || !readVarint32(p, end, averageDelta)
+            || !readVarint32(p, end, lastDelta)) {
+            return false;
+        }
+        bucket += delta;
+        entry.bucket = bucket;
+        entry.max = entry.min + maxDelta;
+        entry.average = entry.min + averageDelta;
+        entry.last = entry.min + lastDelta;
+        store(series, entry);
+    }
+    series.lastBucket = std::max(series.lastBucket, lastBucket);
+    return true;
+}
+
+bool RollupStore::save(const std::string& path) const {
+    std::string out;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint32_t header[2] = {kRollupMagic, kRollupVersion};
+        out.append(reinterpret_cast<const char *>(header), sizeof(header));
+        out.append(reinterpret_cast<const char *>(&m_latestTimestampMs), sizeof(m_latestTimestampMs));
+        appendVarint(out, m_bootId.size());
+        out += m_bootId;
+
+        appendVarint(out, m_names.size());
+        for (const std::string& name : m_names) {
+            appendVarint(out, name.size());
+            out += name;
+        }
+        for (const auto& counter : m_system) {
+            for (const auto& tier : counter) {
+                writeTier(out, tier);
+            }
+        }
+
+        auto writeSeries = [&](uint32_t seriesId) {
+            const Series& series = m_series[seriesId];
+            appendVarint(out, static_cast<uint64_t>(series.key.pid));
+            appendVarint(out, series.key.startTime);
+            appendVarint(out, series.name);
+            for (const auto& tier : series.tiers) {
+                writeTier(out, tier);
+            }
+        };
+        appendVarint(out, m_seriesByKey.size());
+        for (const auto& item : m_seriesByKey) {
+            writeSeries(item.second);
+        }
+        appendVarint(out, m_detached.size());
+        for (uint32_t seriesId : m_detached) {
+            writeSeries(seriesId);
+        }
+    }
+
+    std::string temporary = path + ".tmp";
+    if (!writeFile(temporary, out)) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool RollupStore::load(const std::string& path) {
+    std::string data;
+    bool readOk = readFile(path, data);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    reset();
+    if (!readOk || data.size() < 16) {
+        return false;
+    }
+
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data.data());
+    const uint8_t *end = p + data.size();
+    uint32_t header[2];
+    std::copy(p, p + sizeof(header), reinterpret_cast<uint8_t *>(header));
+    if (header[0] != kRollupMagic || header[1] < 1 || header[1] > kRollupVersion) {
+        return false;
+    }
+    std::copy(p + 8, p + 16, reinterpret_cast<uint8_t *>(&m_latestTimestampMs));
+    p += 16;
+
+    bool ok = true;
+    bool sameBoot = m_bootId.empty();  // version 1: only if keys never repeat
+    if (header[1] >= 2) {
+        uint64_t length;
+        ok = readVarint(p, end, length) && length <= static_cast<uint64_t>(end - p);
+        if (ok) {
+            sameBoot = std::string(reinterpret_cast<const char *>(p), length) == m_bootId;
+            p += length;
+        }
+    }
+
+    uint64_t nameCount;
+    ok = ok && readVarint(p, end, nameCount) && nameCount <= static_cast<uint64_t>(end - p);
+    for (uint64_t i = 0; ok && i < nameCount; ++i) {
+        uint64_t length;
+        ok = readVarint(p, end, length) && length <= static_cast<uint64_t>(end - p);
+        if (ok) {
+            std::string name(reinterpret_cast<const char *>(p), length);
+            p += length;
+            m_nameIndex.emplace(name, static_cast<uint32_t>(m_names.size()));
+            m_names.push_back(std::move(name));
+            m_seriesByName.emplace_back();
+        }
+    }
+    for (auto& counter : m_system) {
+        for (auto& tier : counter) {
+            ok = ok && readTier(p, end, tier);
+        }
+    }
+
+    // Keyed series, then (version 2) the detached ones; keyed series from
+    // another boot are detached too
+    for (uint32_t list = 0; ok && list < (header[1] >= 2 ? 2u : 1u); ++list) {
+        bool keyed = list == 0 && sameBoot;
+        uint64_t seriesCount = 0;
+        ok = readVarint(p, end, seriesCount) && seriesCount <= static_cast<uint64_t>(end - p);
+        for (uint64_t i = 0; ok && i < seriesCount; ++i) {
+            uint64_t pid, startTime;
+            uint32_t nameIndex;
+            ok = readVarint(p, end, pid) && readVarint(p, end, startTime)
+                && readVarint32(p, end, nameIndex) && nameIndex < m_names.size();
+            if (!ok) {
+                break;
+            }
+            ProcessKey key{static_cast<pid_t>(pid), startTime};
+            uint32_t seriesId;
+            if (!keyed) {
+                seriesId = allocateSeries(key, m_names[nameIndex]);
+                m_detached.push_back(seriesId);
+            } else {
+                seriesId = m_seriesByKey.count(key) ? m_seriesByKey[key] : seriesFor(key, m_names[nameIndex]);
+            }
+            for (int tier = 0; ok && tier < TierCount; ++tier) {
+                ok = readTier(p, end, m_series[seriesId].tiers[tier]);
+            }
+        }
+    }
+
+    if (!ok || p != end) {
+        reset();
+        return false;
+    }
+    return true;
+}
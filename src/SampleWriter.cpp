@@ -0,0 +1,258 @@
+#include "SampleWriter.h"
+#include <charconv>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+
+namespace {
+
+const char kCsvHeader[] = "seq,timestamp_ms,total,used,free,pid,name,path,rss,vsz\n";
+
+bool needsCsvQuotes(const std::string& value) {
+    return value.find_first_of(",\"\r\n") != std::string::npos;
+}
+
+// Bytes in the well-formed UTF-8 sequence starting at value[i], or 0.
+// Rejects overlong forms, surrogates and code points past U+10FFFF.
+size_t utf8SequenceLength(const std::string& value, size_t i) {
+    auto at = [&value](size_t j) { return static_cast<unsigned char>(value[j]); };
+    unsigned char lead = at(i);
+    size_t length;
+    unsigned char low = 0x80, high = 0xbf;  // allowed range of the second byte
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        low = lead == 0xe0 ? 0xa0 : 0x80;
+        high = lead == 0xed ? 0x9f : 0xbf;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        low = lead == 0xf0 ? 0x90 : 0x80;
+        high = lead == 0xf4 ? 0x8f : 0xbf;
+    } else {
+        return 0;
+    }
+    if (i + length > value.size() || at(i + 1) < low || at(i + 1) > high) {
+        return 0;
+    }
+    for (size_t j = i + 2; j < i + length; ++j) {
+        if ((at(j) & 0xc0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+} // namespace
+
+SampleWriter::SampleWriter(int fd, Format format, size_t bufferSize)
+    : m_fd(fd)
+    , m_format(format)
+    , m_bufferSize(bufferSize)
+    , m_headerWritten(false)
+{
+    m_buffer.reserve(bufferSize + 4096);
+}
+
+SampleWriter::~SampleWriter() {
+    flush();
+}
+
+bool SampleWriter::write(const MemorySnapshot& snapshot, uint64_t timestampMs, size_t topCount) {
+    if (m_format == Format::Ndjson) {
+        appendNdjson(snapshot, timestampMs, topCount);
+    } else {
+        appendCsv(snapshot, timestampMs, topCount);
+    }
+
+    if (m_buffer.size() >= m_bufferSize) {
+        return flush();
+    }
+    return true;
+}
+
+bool SampleWriter::flush() {
+    const char *data = m_buffer.data();
+    size_t remaining = m_buffer.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(m_fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            m_buffer.clear();
+            return false;
+        }
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    m_buffer.clear();
+    return true;
+}
+
+void SampleWriter::appendNdjson(const MemorySnapshot& snapshot, uint64_t timestampMs, size_t topCount) {
+    m_buffer += "{\"seq\":";
+    appendNumber(snapshot.getSequence());
+    m_buffer += ",\"timestamp_ms\":";
+    appendNumber(timestampMs);
+    m_buffer += ",\"total\":";
+    appendNumber(snapshot.getTotalPhysicalRAM());
+    m_buffer += ",\"used\":";
+    appendNumber(snapshot.getUsedMemory());
+    m_buffer += ",\"free\":";
+    appendNumber(snapshot.getFreeMemory());
+    m_buffer += ",\"active\":";
+    appendNumber(snapshot.getActiveMemory());
+    m_buffer += ",\"inactive\":";
+    appendNumber(snapshot.getInactiveMemory());
+    m_buffer += ",\"wired\":";
+    appendNumber(snapshot.getWiredMemory());
+    m_buffer += ",\"process_count\":";
+    appendNumber(snapshot.getProcessCount());
+    if (snapshot.hasMemoryPressure()) {
+        const PressureStats& pressure = snapshot.getMemoryPressure();
+        m_buffer += ",\"pressure\":{\"some_avg10\":";
+        appendDecimal(pressure.someAvg10);
+        m_buffer += ",\"full_avg10\":";
+        appendDecimal(pressure.fullAvg10);
+        m_buffer += ",\"some_total_us\":";
+        appendNumber(pressure.someTotalUs);
+        m_buffer += ",\"full_total_us\":";
+        appendNumber(pressure.fullTotalUs);
+        m_buffer += '}';
+    }
+    if (snapshot.getPressureStallCount() > 0) {
+        m_buffer += ",\"pressure_stalls\":";
+        appendNumber(snapshot.getPressureStallCount());
+    }
+    m_buffer += ",\"processes\":[";
+
+    if (topCount > 0) {
+        ProcessView top = snapshot.getTopProcessesByMemory(topCount);
+        for (size_t i = 0; i < top.size(); ++i) {
+            appendNdjsonProcess(top[i], i == 0);
+        }
+    } else {
+        for (size_t i = 0; i < snapshot.getProcessCount(); ++i) {
+            appendNdjsonProcess(snapshot.process(i), i == 0);
+        }
+    }
+
+    m_buffer += "]}\n";
+}
+
+void SampleWriter::appendNdjsonProcess(const ProcessRef& process, bool first) {
+    m_buffer += first ? "{\"pid\":" : ",{\"pid\":";
+    appendNumber(static_cast<uint64_t>(process.getPid()));
+    m_buffer += ",\"name\":";
+    appendJsonString(process.getName());
+    m_buffer += ",\"path\":";
+    appendJsonString(process.getPath());
+    m_buffer += ",\"rss\":";
+    appendNumber(process.getResidentSize());
+    m_buffer += ",\"vsz\":";
+    appendNumber(process.getVirtualSize());
+    m_buffer += '}';
+}
+
+void SampleWriter::appendCsv(const MemorySnapshot& snapshot, uint64_t timestampMs, size_t topCount) {
+    if (!m_headerWritten) {
+        m_buffer += kCsvHeader;
+        m_headerWritten = true;
+    }
+
+    // Columns shared by every row of this sample, formatted once
+    size_t start = m_buffer.size();
+    appendNumber(snapshot.getSequence());
+    m_buffer += ',';
+    appendNumber(timestampMs);
+    m_buffer += ',';
+    appendNumber(snapshot.getTotalPhysicalRAM());
+    m_buffer += ',';
+    appendNumber(snapshot.getUsedMemory());
+    m_buffer += ',';
+    appendNumber(snapshot.getFreeMemory());
+    m_buffer += ',';
+    std::string samplePrefix = m_buffer.substr(start);
+    m_buffer.resize(start);
+
+    if (topCount > 0) {
+        ProcessView top = snapshot.getTopProcessesByMemory(topCount);
+        for (ProcessRef process : top) {
+            appendCsvProcess(samplePrefix, process);
+        }
+    } else {
+        for (size_t i = 0; i < snapshot.getProcessCount(); ++i) {
+            appendCsvProcess(samplePrefix, snapshot.process(i));
+        }
+    }
+}
+
+void SampleWriter::appendCsvProcess(const std::string& samplePrefix, const ProcessRef& process) {
+    m_buffer += samplePrefix;
+    appendNumber(static_cast<uint64_t>(process.getPid()));
+    m_buffer += ',';
+    appendCsvField(process.getName());
+    m_buffer += ',';
+    appendCsvField(process.getPath());
+    m_buffer += ',';
+    appendNumber(process.getResidentSize());
+    m_buffer += ',';
+    appendNumber(process.getVirtualSize());
+    m_buffer += '\n';
+}
+
+void SampleWriter::appendNumber(uint64_t value) {
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, result.ptr);
+}
+
+void SampleWriter::appendDecimal(double value) {
+    // PSI reports two decimals
+    char digits[32];
+    int length = std::snprintf(digits, sizeof(digits), "%.2f", value);
+    m_buffer.append(digits, static_cast<size_t>(length));
+}
+
+void SampleWriter::appendJsonString(const std::string& value) {
+    static const char hex[] = "0123456789abcdef";
+    m_buffer += '"';
+    for (size_t i = 0; i < value.size();) {
+        unsigned char byte = static_cast<unsigned char>(value[i]);
+        if (byte == '"' || byte == '\\') {
+            m_buffer += '\\';
+            m_buffer += value[i++];
+        } else if (byte < 0x20) {
+            m_buffer += "\\u00";
+            m_buffer += hex[byte >> 4];
+            m_buffer += hex[byte & 0xf];
+            ++i;
+        } else if (byte < 0x80) {
+            m_buffer += value[i++];
+        } else if (size_t length = utf8SequenceLength(value, i)) {
+            m_buffer.append(value, i, length);
+            i += length;
+        } else {
+            // comm and exe paths are arbitrary bytes; keep the line valid JSON
+            m_buffer += "\\ufffd";
+            ++i;
+        }
+    }
+    m_buffer += '"';
+}
+
+void SampleWriter::appendCsvField(const std::string& value) {
+    if (!needsCsvQuotes(value)) {
+        m_buffer += value;
+        return;
+    }
+    m_buffer += '"';
+    for (char c : value) {
+        if (c == '"') {
+            m_buffer += '"';
+        }
+        m_buffer += c;
+    }
+    m_buffer += '"';
+}
@@ -0,0 +1,236 @@
+#include "SmapsParser.h"
+#include <cstring>
+
+namespace {
+
+constexpr size_t kNoRegion = static_cast<size_t>(-1);
+
+bool startsWith(const char *p, const char *end, const char *prefix, size_t prefixLength) {
+    return static_cast<size_t>(end - p) >= prefixLength && memcmp(p, prefix, prefixLength) == 0;
+}
+
+// Value of a "Key:   123 kB" line, p just past the colon
+uint64_t parseKilobytes(const char *p, const char *end) {
+    while (p < end && *p == ' ') {
+        ++p;
+    }
+    uint64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+    }
+    return value * 1024;
+}
+
+// Shared objects are named lib.so, lib.so.6, lib.so.6.0.1 ...
+bool isSharedObject(const char *name, const char *end) {
+    for (const char *p = name; (p = static_cast<const char *>(memchr(p, '.', end - p))); ++p) {
+        if (end - p >= 3 && p[1] == 's' && p[2] == 'o' && (end - p == 3 || p[3] == '.' || p[3] == ' ')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MappingKind classify(const char *name, const char *end) {
+    if (name == end) {
+        return MappingKind::Anonymous;
+    }
+    if (*name == '[') {
+        if (startsWith(name, end, "[heap]", 6)) return MappingKind::Heap;
+        if (startsWith(name, end, "[stack", 6)) return MappingKind::Stack;
+        if (startsWith(name, end, "[anon:", 6)) return MappingKind::Anonymous;
+        if (startsWith(name, end, "[anon_shmem:", 12)) return MappingKind::SharedMemory;
+        return MappingKind::Other;
+    }
+    if (*name == '/') {
+        if (startsWith(name, end, "/dev/shm/", 9) || startsWith(name, end, "/memfd:", 7)
+                || startsWith(name, end, "/SYSV", 5)) {
+            return MappingKind::SharedMemory;
+        }
+        return isSharedObject(name, end) ? MappingKind::Library : MappingKind::File;
+    }
+    return MappingKind::Other;  // anon_inode:..., dmabuf and friends
+}
+
+void add(MappingBreakdown::Totals& to, const MappingBreakdown::Totals& from) {
+    to.size += from.size;
+    to.resident += from.resident;
+    to.proportional += from.proportional;
+    to.unique += from.unique;
+    to.swap += from.swap;
+    to.mappings += from.mappings;
+}
+
+} // namespace
+
+const char *mappingKindName(MappingKind kind) {
+    switch (kind) {
+    case MappingKind::Heap: return "Heap";
+    case MappingKind::Stack: return "Stack";
+    case MappingKind::Anonymous: return "Anonymous";
+    case MappingKind::Library: return "Library";
+    case MappingKind::File: return "File";
+    case MappingKind::SharedMemory: return "Shared Memory";
+    case MappingKind::Other: return "Other";
+    case MappingKind::KindCount: break;
+    }
+    return "";
+}
+
+void MappingBreakdown::clear() {
+    regions.clear();
+    for (Totals& kind : kinds) {
+        kind = Totals();
+    }
+    total = Totals();
+}
+
+SmapsParser::SmapsParser()
+    : m_out(nullptr)
+    , m_currentRegion(kNoRegion)
+    , m_inMapping(false)
+    , m_bytesParsed(0)
+{
+}
+
+void SmapsParser::begin(MappingBreakdown& out) {
+    m_out = &out;
+    m_out->clear();
+    m_regionByName.clear();
+    m_partial.clear();
+    m_currentRegion = kNoRegion;
+    m_inMapping = false;
+    m_bytesParsed = 0;
+}
+
+void SmapsParser::feed(const char *data, size_t length) {
+    m_bytesParsed += length;
+    const char *p = data;
+    const char *end = data + length;
+
+    // Complete the line left over from the previous chunk
+    if (!m_partial.empty()) {
+        const char *newline = static_cast<const char *>(memchr(p, '\n', length));
+        if (!newline) {
+            m_partial.append(p, length);
+            return;
+        }
+        m_partial.append(p, newline);
+        parseLine(m_partial.data(), m_partial.data() + m_partial.size());
+        m_partial.clear();
+        p = newline + 1;
+    }
+
+    while (p < end) {
+        const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!newline) {
+            m_partial.assign(p, end);
+            break;
+        }
+        parseLine(p, newline);
+        p = newline + 1;
+    }
+}
+
+void SmapsParser::finish() {
+    if (!m_partial.empty()) {
+        parseLine(m_partial.data(), m_partial.data() + m_partial.size());
+        m_partial.clear();
+    }
+    endMapping();
+}
+
+void SmapsParser::parseLine(const char *line, const char *end) {
+    if (line == end) {
+        return;
+    }
+
+    // Mapping headers start with the (lowercase hex) address range, field
+    // lines with a capitalized key
+    char first = *line;
+    if ((first >= '0' && first <= '9') || (first >= 'a' && first <= 'f')) {
+        beginMapping(line, end);
+        return;
+    }
+    if (!m_inMapping) {
+        return;
+    }
+
+    switch (first) {
+    case 'S':
+        if (startsWith(line, end, "Size:", 5)) {
+            m_current.size = parseKilobytes(line + 5, end);
+        } else if (startsWith(line, end, "Swap:", 5)) {
+            m_current.swap = parseKilobytes(line + 5, end);
+        }
+        break;
+    case 'R':
+        if (startsWith(line, end, "Rss:", 4)) {
+            m_current.resident = parseKilobytes(line + 4, end);
+        }
+        break;
+    case 'P':
+        if (startsWith(line, end, "Pss:", 4)) {
+            m_current.proportional = parseKilobytes(line + 4, end);
+        } else if (startsWith(line, end, "Private_Clean:", 14)
+                || startsWith(line, end, "Private_Dirty:", 14)) {
+            m_current.unique += parseKilobytes(line + 14, end);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void SmapsParser::beginMapping(const char *line, const char *end) {
+    endMapping();
+
+    // "start-end perms offset dev inode", padding, then the optional name
+    const char *name = line;
+    for (int field = 0; field < 5 && name; ++field) {
+        name = static_cast<const char *>(memchr(name, ' ', end - name));
+        if (name) {
+            ++name;
+        }
+    }
+    if (!name) {
+        name = end;
+    }
+    while (name < end && *name == ' ') {
+        ++name;
+    }
+    size_t nameLength = end - name;
+
+    // Segments of one file are adjacent, so most lookups hit the last region
+    std::vector<MappingBreakdown::Region>& regions = m_out->regions;
+    if (m_currentRegion == kNoRegion || regions[m_currentRegion].name.size() != nameLength
+            || memcmp(regions[m_currentRegion].name.data(), name, nameLength) != 0) {
+        m_key.assign(name, nameLength);
+        auto it = m_regionByName.find(m_key);
+        if (it != m_regionByName.end()) {
+            m_currentRegion = it->second;
+        } else {
+            m_currentRegion = regions.size();
+            regions.emplace_back();
+            regions.back().kind = classify(name, end);
+            regions.back().name = m_key;
+            m_regionByName.emplace(m_key, m_currentRegion);
+        }
+    }
+
+    m_current = MappingBreakdown::Totals();
+    m_current.mappings = 1;
+    m_inMapping = true;
+}
+
+void SmapsParser::endMapping() {
+    if (!m_inMapping) {
+        return;
+    }
+    MappingBreakdown::Region& region = m_out->regions[m_currentRegion];
+    add(region.totals, m_current);
+    add(m_out->kinds[static_cast<size_t>(region.kind)], m_current);
+    add(m_out->total, m_current);
+    m_inMapping = false;
+}
@@ -0,0 +1,199 @@
+#include "SnapshotRecorder.h"
+#include "RecordingFormat.h"
+#include "VarInt.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+SnapshotRecorder::SnapshotRecorder(uint32_t keyframeInterval)
+    : m_fd(-1)
+    , m_keyframeInterval(keyframeInterval > 0 ? keyframeInterval : 1)
+    , m_fileSize(0)
+    , m_sinceKeyframe(0)
+    , m_stringCount(0)
+{
+}
+
+SnapshotRecorder::~SnapshotRecorder() {
+    close();
+}
+
+bool SnapshotRecorder::open(const std::string& path, uint64_t totalPhysicalRAM) {
+    close();
+
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        return false;
+    }
+
+    m_fileSize = 0;
+    m_sinceKeyframe = 0;
+    m_stringCount = 0;
+    m_strings.reset();
+    m_recorded = std::make_unique<StringPool>();
+    m_recordedIds.clear();
+    m_offsets.clear();
+    m_previous.clear();
+
+    RecordingFileHeader header = {};
+    header.magic = kRecordingMagic;
+    header.version = kRecordingVersion;
+    header.headerSize = sizeof(RecordingFileHeader);
+    header.keyframeInterval = m_keyframeInterval;
+    header.totalPhysicalRAM = totalPhysicalRAM;
+    if (!writeAll(&header, sizeof(header))) {
+        ::close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotRecorder::append(const MemorySnapshot& snapshot) {
+    if (m_fd < 0) {
+        return false;
+    }
+    if (m_strings != snapshot.getStringPool()) {
+        m_strings = snapshot.getStringPool();
+        m_recordedIds.clear();
+    }
+    for (size_t id = m_recordedIds.size(); id < m_strings->size(); ++id) {
+        m_recordedIds.push_back(m_recorded->intern(m_strings->str(static_cast<uint32_t>(id))));
+    }
+
+    bool keyframe = m_offsets.empty() || m_sinceKeyframe >= m_keyframeInterval;
+    if (keyframe) {
+        m_previous.clear();
+        m_sinceKeyframe = 0;
+    }
+
+    // Header slot first, filled in once the body size is known
+    m_buffer.assign(sizeof(RecordingSampleHeader), '\0');
+
+    uint32_t stringTotal = static_cast<uint32_t>(m_recorded->size());
+    for (uint32_t id = m_stringCount; id < stringTotal; ++id) {
+        const std::string& value = m_recorded->str(id);
+        appendVarint(m_buffer, value.size());
+        m_buffer += value;
+    }
+
+    const std::vector<pid_t>& pids = snapshot.getPids();
+    const std::vector<uint64_t>& startTimes = snapshot.getStartTimes();
+    const std::vector<uint32_t>& nameIds = snapshot.getNameIds();
+    const std::vector<uint32_t>& pathIds = snapshot.getPathIds();
+    const std::vector<uint64_t>& residentSizes = snapshot.getResidentSizes();
+    const std::vector<uint64_t>& virtualSizes = snapshot.getVirtualSizes();
+    size_t count = pids.size();
+
+    // Rows whose identity differs from the same row last time
+    m_changedRows.clear();
+    for (size_t row = 0; row < count; ++row) {
+        if (row >= m_previous.size() || m_previous[row].pid != pids[row]
+            || m_previous[row].startTime != startTimes[row]) {
+            m_changedRows.push_back(static_cast<uint32_t>(row));
+        }
+    }
+    m_previous.resize(count);
+
+    appendVarint(m_buffer, m_changedRows.size());
+    int64_t lastRow = -1;
+    for (uint32_t row : m_changedRows) {
+        appendVarint(m_buffer, static_cast<uint64_t>(row - lastRow));
+        appendVarint(m_buffer, static_cast<uint64_t>(pids[row]));
+        appendVarint(m_buffer, startTimes[row]);
+        uint32_t nameId = m_recordedIds[nameIds[row]];
+        uint32_t pathId = m_recordedIds[pathIds[row]];
+        appendVarint(m_buffer, nameId);
+        appendVarint(m_buffer, pathId);
+        m_previous[row] = {pids[row], startTimes[row], nameId, pathId, 0, 0};
+        lastRow = row;
+    }
+
+    for (size_t row = 0; row < count; ++row) {
+        int64_t delta = static_cast<int64_t>(residentSizes[row] - m_previous[row].residentSize);
+        appendVarint(m_buffer, zigzagEncode(delta));
+        m_previous[row].residentSize = residentSizes[row];
+    }
+    for (size_t row = 0; row < count; ++row) {
+        int64_t delta = static_cast<int64_t>(virtualSizes[row] - m_previous[row].virtualSize);
+        appendVarint(m_buffer, zigzagEncode(delta));
+        m_previous[row].virtualSize = virtualSizes[row];
+    }
+
+    RecordingSampleHeader header = {};
+    header.magic = kRecordingSampleMagic;
+    header.flags = keyframe ? static_cast<uint32_t>(RecordingKeyframe) : 0u;
+    header.sequence = snapshot.getSequence();
+    header.timestampMs = snapshot.getTimestampMs();
+    header.freeMemory = snapshot.getFreeMemory();
+    header.activeMemory = snapshot.getActiveMemory();
+    header.inactiveMemory = snapshot.getInactiveMemory();
+    header.wiredMemory = snapshot.getWiredMemory();
+    header.processCount = static_cast<uint32_t>(count);
+    header.newStringCount = stringTotal - m_stringCount;
+    header.keyframeDistance = m_sinceKeyframe;
+    header.bodySize = static_cast<uint32_t>(m_buffer.size() - sizeof(header));
+    std::memcpy(&m_buffer[0], &header, sizeof(header));
+
+    uint64_t offset = m_fileSize;
+    if (!writeAll(m_buffer.data(), m_buffer.size())) {
+        return false;
+    }
+    m_offsets.push_back(offset);
+    m_stringCount = stringTotal;
+    ++m_sinceKeyframe;
+    return true;
+}
+
+bool SnapshotRecorder::close() {
+    if (m_fd < 0) {
+        return true;
+    }
+
+    RecordingFooter footer = {};
+    footer.magic = kRecordingFooterMagic;
+    footer.sampleCount = m_offsets.size();
+    footer.stringsOffset = m_fileSize;
+
+    m_buffer.clear();
+    appendVarint(m_buffer, m_stringCount);
+    for (uint32_t id = 0; id < m_stringCount; ++id) {
+        const std::string& value = m_recorded->str(id);
+        appendVarint(m_buffer, value.size());
+        m_buffer += value;
+    }
+    // Keep the index 8-byte aligned for readers that cast the mapping
+    while ((m_fileSize + m_buffer.size()) % alignof(uint64_t) != 0) {
+        m_buffer += '\0';
+    }
+    footer.indexOffset = m_fileSize + m_buffer.size();
+
+    bool ok = writeAll(m_buffer.data(), m_buffer.size())
+        && writeAll(m_offsets.data(), m_offsets.size() * sizeof(uint64_t))
+        && writeAll(&footer, sizeof(footer));
+
+    ok = ::close(m_fd) == 0 && ok;
+    m_fd = -1;
+    m_strings.reset();
+    m_recorded.reset();
+    m_recordedIds.clear();
+    return ok;
+}
+
+bool SnapshotRecorder::writeAll(const void *data, size_t size) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = ::write(m_fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        size -= static_cast<size_t>(written);
+        m_fileSize += static_cast<uint64_t>(written);
+    }
+    return true;
+}
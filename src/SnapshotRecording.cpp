@@ -0,0 +1,281 @@
+#include "SnapshotRecording.h"
+#include "VarInt.h"
+#include <cstring>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+SnapshotRecording::SnapshotRecording()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_totalPhysicalRAM(0)
+    , m_sampleCount(0)
+    , m_indexData(nullptr)
+    , m_decodedIndex(0)
+    , m_decodedValid(false)
+{
+}
+
+SnapshotRecording::~SnapshotRecording() {
+    close();
+}
+
+bool SnapshotRecording::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(RecordingFileHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void *mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    m_data = static_cast<const uint8_t *>(mapping);
+    m_size = static_cast<size_t>(status.st_size);
+
+    RecordingFileHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if (header.magic != kRecordingMagic || header.version != kRecordingVersion) {
+        close();
+        return false;
+    }
+    m_totalPhysicalRAM = header.totalPhysicalRAM;
+    m_strings = std::make_shared<StringPool>();
+
+    if (!readFooter() && !scanSamples()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SnapshotRecording::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_sampleCount = 0;
+    m_indexData = nullptr;
+    m_scannedIndex.clear();
+    m_strings.reset();
+    m_rows.clear();
+    m_decodedValid = false;
+}
+
+uint64_t SnapshotRecording::offsetAt(size_t index) const {
+    if (m_indexData) {
+        uint64_t offset;
+        std::memcpy(&offset, m_indexData + index * sizeof(uint64_t), sizeof(offset));
+        return offset;
+    }
+    return m_scannedIndex[index];
+}
+
+bool SnapshotRecording::sampleHeaderAt(size_t index, RecordingSampleHeader& header) const {
+    if (index >= m_sampleCount) {
+        return false;
+    }
+    uint64_t offset = offsetAt(index);
+    if (offset + sizeof(header) > m_size) {
+        return false;
+    }
+    std::memcpy(&header, m_data + offset, sizeof(header));
+    return header.magic == kRecordingSampleMagic
+        && offset + sizeof(header) + header.bodySize <= m_size;
+}
+
+uint64_t SnapshotRecording::timestampAt(size_t index) const {
+    RecordingSampleHeader header;
+    return sampleHeaderAt(index, header) ? header.timestampMs : 0;
+}
+
+size_t SnapshotRecording::indexAtTime(uint64_t timestampMs) const {
+    size_t low = 0, high = m_sampleCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (timestampAt(middle) < timestampMs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+bool SnapshotRecording::readFooter() {
+    if (m_size < sizeof(RecordingFileHeader) + sizeof(RecordingFooter)) {
+        return false;
+    }
+    RecordingFooter footer;
+    std::memcpy(&footer, m_data + m_size - sizeof(footer), sizeof(footer));
+    uint64_t indexEnd = footer.indexOffset + footer.sampleCount * sizeof(uint64_t);
+    if (footer.magic != kRecordingFooterMagic || footer.stringsOffset > footer.indexOffset
+        || indexEnd != m_size - sizeof(footer)) {
+        return false;
+    }
+
+    const uint8_t *p = m_data + footer.stringsOffset;
+    const uint8_t *end = m_data + footer.indexOffset;
+    uint64_t stringCount;
+    if (!readVarint(p, end, stringCount) || !readStrings(p, end, stringCount)) {
+        return false;
+    }
+
+    m_indexData = m_data + footer.indexOffset;
+    m_sampleCount = footer.sampleCount;
+    return true;
+}
+
+bool SnapshotRecording::scanSamples() {
+    m_strings = std::make_shared<StringPool>();
+    m_scannedIndex.clear();
+
+    uint64_t offset = sizeof(RecordingFileHeader);
+    RecordingSampleHeader header;
+    while (offset + sizeof(header) <= m_size) {
+        std::memcpy(&header, m_data + offset, sizeof(header));
+        uint64_t bodyOffset = offset + sizeof(header);
+        if (header.magic != kRecordingSampleMagic || bodyOffset + header.bodySize > m_size) {
+            break;  // torn final write or trailing footer
+        }
+        const uint8_t *p = m_data + bodyOffset;
+        if (!readStrings(p, p + header.bodySize, header.newStringCount)) {
+            break;
+        }
+        m_scannedIndex.push_back(offset);
+        offset = bodyOffset + header.bodySize;
+    }
+
+    m_sampleCount = m_scannedIndex.size();
+    return m_sampleCount > 0;
+}
+
+bool SnapshotRecording::readStrings(const uint8_t *&p, const uint8_t *end, uint64_t count) {
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t length;
+        if (!readVarint(p, end, length) || length > static_cast<uint64_t>(end - p)) {
+            return false;
+        }
+        // Ids are assigned in file order; id 0 ("") already exists
+        m_strings->intern(std::string_view(reinterpret_cast<const char *>(p), length));
+        p += length;
+    }
+    return true;
+}
+
+bool SnapshotRecording::applySample(size_t index) {
+    RecordingSampleHeader header;
+    if (!sampleHeaderAt(index, header)) {
+        return false;
+    }
+    const uint8_t *p = m_data + offsetAt(index) + sizeof(header);
+    const uint8_t *end = p + header.bodySize;
+
+    // Strings were loaded at open; skip over them
+    for (uint32_t i = 0; i < header.newStringCount; ++i) {
+        uint64_t length;
+        if (!readVarint(p, end, length) || length > static_cast<uint64_t>(end - p)) {
+            return false;
+        }
+        p += length;
+    }
+
+    if (header.flags & RecordingKeyframe) {
+        m_rows.clear();
+    }
+    size_t previousCount = m_rows.size();
+    m_rows.resize(header.processCount);
+
+    uint64_t changedCount;
+    if (!readVarint(p, end, changedCount)) {
+        return false;
+    }
+    int64_t row = -1;
+    size_t appendedRows = 0;
+    for (uint64_t i = 0; i < changedCount; ++i) {
+        uint64_t rowDelta, pid, startTime, nameId, pathId;
+        if (!readVarint(p, end, rowDelta) || !readVarint(p, end, pid)
+            || !readVarint(p, end, startTime) || !readVarint(p, end, nameId)
+            || !readVarint(p, end, pathId)) {
+            return false;
+        }
+        row += static_cast<int64_t>(rowDelta);
+        if (row < 0 || row >= static_cast<int64_t>(header.processCount)
+            || nameId >= m_strings->size() || pathId >= m_strings->size()) {
+            return false;
+        }
+        m_rows[row] = {static_cast<pid_t>(pid), static_cast<uint32_t>(nameId),
+                       static_cast<uint32_t>(pathId), startTime, 0, 0};
+        appendedRows += static_cast<size_t>(row) >= previousCount ? 1 : 0;
+    }
+    // Rows past the previous sample have no base and must all be listed
+    if (header.processCount > previousCount && appendedRows != header.processCount - previousCount) {
+        return false;
+    }
+
+    for (ProcessRecord& record : m_rows) {
+        uint64_t delta;
+        if (!readVarint(p, end, delta)) {
+            return false;
+        }
+        record.residentSize += static_cast<uint64_t>(zigzagDecode(delta));
+    }
+    for (ProcessRecord& record : m_rows) {
+        uint64_t delta;
+        if (!readVarint(p, end, delta)) {
+            return false;
+        }
+        record.virtualSize += static_cast<uint64_t>(zigzagDecode(delta));
+    }
+    return true;
+}
+
+bool SnapshotRecording::readSample(size_t index, MemorySnapshot& snapshot) {
+    RecordingSampleHeader header;
+    if (!sampleHeaderAt(index, header)) {
+        return false;
+    }
+
+    // A corrupt distance would decode deltas onto the wrong base
+    RecordingSampleHeader keyframe;
+    if (header.keyframeDistance > index
+        || !sampleHeaderAt(index - header.keyframeDistance, keyframe)
+        || !(keyframe.flags & RecordingKeyframe)) {
+        return false;
+    }
+
+    // Continue from the decoded sample when possible, else from the keyframe
+    size_t first = index - header.keyframeDistance;
+    if (m_decodedValid && m_decodedIndex < index && m_decodedIndex >= first) {
+        first = m_decodedIndex + 1;
+    } else if (m_decodedValid && m_decodedIndex == index) {
+        first = index + 1;
+    }
+    for (size_t i = first; i <= index; ++i) {
+        if (!applySample(i)) {
+            m_decodedValid = false;
+            return false;
+        }
+        m_decodedIndex = i;
+        m_decodedValid = true;
+    }
+
+    SystemMemoryInfo memory;
+    memory.freeMemory = header.freeMemory;
+    memory.activeMemory = header.activeMemory;
+    memory.inactiveMemory = header.inactiveMemory;
+    memory.wiredMemory = header.wiredMemory;
+    snapshot.assignSystemMemory(header.sequence, header.timestampMs, m_totalPhysicalRAM, memory);
+    snapshot.assignProcesses(m_rows, m_strings);
+    return true;
+}
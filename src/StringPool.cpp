@@ -0,0 +1,46 @@
+#include "StringPool.h"
+
+StringPool::StringPool()
+    : m_count(0)
+{
+    intern(std::string_view());
+}
+
+uint32_t StringPool::intern(std::string_view value) {
+    auto it = m_index.find(value);
+    if (it != m_index.end()) {
+        return it->second;
+    }
+
+    if (m_count == kChunkSize * kMaxChunks) {
+        // Full; ProcessCache counts these and compacts before long
+        return 0;
+    }
+
+    uint32_t id = m_count;
+    std::unique_ptr<std::string[]>& chunk = m_chunks[id >> kChunkBits];
+    if (!chunk) {
+        chunk.reset(new std::string[kChunkSize]);
+    }
+    std::string& stored = chunk[id & (kChunkSize - 1)];
+    stored.assign(value.data(), value.size());
+
+    m_index.emplace(std::string_view(stored), id);
+    ++m_count;
+    return id;
+}
+
+size_t StringPool::memoryUsage() const {
+    size_t chunks = (m_count + kChunkSize - 1) / kChunkSize;
+    size_t bytes = sizeof(*this) + chunks * kChunkSize * sizeof(std::string);
+    for (uint32_t id = 0; id < m_count; ++id) {
+        const std::string& value = str(id);
+        if (value.capacity() > 15) {  // beyond the small-string buffer
+            bytes += value.capacity() + 1;
+        }
+    }
+    // Node plus bucket per index entry
+    bytes += m_index.size() * (sizeof(void *) * 2 + sizeof(std::string_view) + sizeof(uint32_t))
+           + m_index.bucket_count() * sizeof(void *);
+    return bytes;
+}
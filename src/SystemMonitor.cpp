@@ -1,121 +1,412 @@
 #include "SystemMonitor.h"
-#include <sys/sysctl.h>
-#include <mach/mach.h>
-#include <libproc.h>
+#include "Instrumentation.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
 #include <QDebug>
+#include <QFile>
+#include <QTimer>
+
+namespace {
+
+// Published + being read by the UI + being built
+constexpr size_t kSnapshotPoolSize = 3;
+
+constexpr uint64_t kRollupSaveIntervalMs = 15 * 60 * 1000;
+
+// Progressive first scan: provisional samples no more often than this
+constexpr uint64_t kPartialPublishIntervalMs = 100;
+
+uint64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CPU time of the whole process: scan workers, UI and metrics threads
+// included, which is what the CPU budget limits
+uint64_t processCpuNs() {
+    timespec now;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+}
+
+} // namespace
 
 SystemMonitor::SystemMonitor(QObject *parent)
     : QObject(parent)
     , m_totalPhysicalRAM(0)
-    , m_freeMemory(0)
-    , m_activeMemory(0)
-    , m_inactiveMemory(0)
-    , m_wiredMemory(0)
+    , m_sequence(0)
+    , m_reportedDroppedStrings(0)
+    , m_seenCompactions(0)
+    , m_stringTableFull(false)
+    , m_accountingEnabled(false)
+    , m_lastRollupSaveMs(0)
+    , m_hasPressure(false)
+    , m_pendingStalls(0)
+    , m_refreshTimer(new QTimer(this))
+    , m_collectRequested(false)
+    , m_lastCollectStartMs(0)
+    , m_lastCycleCpuNs(0)
+    , m_lastFreeMemory(0)
+    , m_announcedIntervalMs(0)
+    , m_progressiveScan(false)
+    , m_cancelled(false)
 {
     // Get total physical RAM (this doesn't change)
-    int mib[2] = {CTL_HW, HW_MEMSIZE};
-    size_t length = sizeof(m_totalPhysicalRAM);
-    sysctl(mib, 2, &m_totalPhysicalRAM, &length, nullptr, 0);
+    m_totalPhysicalRAM = m_scanPool.collector().queryTotalPhysicalRAM();
+    m_rollups.setBootId(m_scanPool.collector().queryBootId());
+    m_alerts.setSink(this);
+    setProcessEvents(true);
+
+    // A child, so it moves to the worker thread along with the monitor
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_refreshTimer, &QTimer::timeout, this, &SystemMonitor::collectData);
+}
+
+SystemMonitor::~SystemMonitor() {
+    // Its handler calls back into the monitor
+    m_pressureMonitor.reset();
+    if (!m_rollupPath.empty()) {
+        saveRollups();
+    }
+}
+
+void SystemMonitor::requestCollect() {
+    if (!m_collectRequested.exchange(true)) {
+        QMetaObject::invokeMethod(this, &SystemMonitor::runRequestedCollect, Qt::QueuedConnection);
+    }
+}
+
+void SystemMonitor::cancel() {
+    m_cancelled.store(true);
+}
+
+void SystemMonitor::runRequestedCollect() {
+    // Already served if the timer fired after the request was queued
+    if (m_collectRequested.load()) {
+        collectData();
+    }
 }
 
 void SystemMonitor::collectData() {
-    bool success = collectSystemMemoryInfo();
-    if (!success) {
-        emit errorOccurred("Failed to collect system memory information");
+    if (m_cancelled.load()) {
+        m_refreshTimer->stop();
         return;
     }
 
-    success = collectAllProcesses();
-    if (!success) {
-        emit errorOccurred("Failed to collect process information");
+    // Requests arriving from here on need a fresh sample, so they queue again
+    m_collectRequested.store(false);
+    m_refreshTimer->stop();
+    uint64_t startMs = steadyMs();
+
+    MM_INSTRUMENT(uint64_t allocationsBefore = Instrumentation::threadAllocations());
+    bool success;
+    {
+        MM_TIME_SCOPE(CollectPhase);
+        success = collectAndPublish();
+    }
+    MM_COUNT(Allocations, Instrumentation::threadAllocations() - allocationsBefore);
+
+    // Activity: resident memory that moved per second since the last
+    // sample, from process RSS or system free memory, whichever is larger
+    uint64_t cpuNs = processCpuNs();
+    double activity = 0.0;
+    if (success && m_lastCollectStartMs != 0 && m_totalPhysicalRAM > 0 && startMs > m_lastCollectStartMs) {
+        uint64_t freeMemory = m_memory.freeMemory;
+        uint64_t freeChange = freeMemory > m_lastFreeMemory
+            ? freeMemory - m_lastFreeMemory : m_lastFreeMemory - freeMemory;
+        double moved = static_cast<double>(std::max(m_cache.residentChange(), freeChange));
+        double seconds = (startMs - m_lastCollectStartMs) / 1000.0;
+        activity = moved / static_cast<double>(m_totalPhysicalRAM) / seconds;
+    }
+    m_scheduler.recordSample(m_lastCycleCpuNs != 0 ? cpuNs - m_lastCycleCpuNs : 0, activity);
+    m_lastCycleCpuNs = cpuNs;
+    m_lastCollectStartMs = startMs;
+    m_lastFreeMemory = m_memory.freeMemory;
+
+    scheduleNext(startMs);
+    if (success) {
+        emit dataReady();
+    }
+}
+
+void SystemMonitor::scheduleNext(uint64_t startMs) {
+    uint64_t intervalMs = m_scheduler.nextInterval();
+    if (intervalMs != m_announcedIntervalMs) {
+        m_announcedIntervalMs = intervalMs;
+        emit refreshIntervalChanged(static_cast<int>(intervalMs));
+    }
+    if (intervalMs == 0 || startMs == 0) {
+        m_refreshTimer->stop();
         return;
     }
+    // Measured from the start of the last collection, so the cadence does
+    // not drift by the scan time
+    uint64_t elapsedMs = steadyMs() - startMs;
+    m_refreshTimer->start(static_cast<int>(intervalMs > elapsedMs ? intervalMs - elapsedMs : 0));
+}
 
-    emit dataReady();
+void SystemMonitor::setRefreshInterval(int ms) {
+    m_scheduler.setBaseInterval(ms > 0 ? static_cast<uint64_t>(ms) : 0);
+    scheduleNext(m_lastCollectStartMs);
 }
 
-bool SystemMonitor::collectSystemMemoryInfo() {
-    vm_size_t page_size;
-    host_page_size(mach_host_self(), &page_size);
+void SystemMonitor::setAdaptiveRefresh(bool adaptive) {
+    m_scheduler.setAdaptive(adaptive);
+    scheduleNext(m_lastCollectStartMs);
+}
 
-    vm_statistics64_data_t vm_stats;
-    mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+void SystemMonitor::setCpuBudget(double percent) {
+    m_scheduler.setCpuBudget(percent / 100.0);
+    scheduleNext(m_lastCollectStartMs);
+}
 
-    kern_return_t result = host_statistics64(
-        mach_host_self(),
-        HOST_VM_INFO64,
-        (host_info64_t)&vm_stats,
-        &count
-    );
+bool SystemMonitor::collectAndPublish() {
+    bool success = collectSystemMemoryInfo();
+    if (!success) {
+        emit errorOccurred("Failed to collect system memory information");
+        return false;
+    }
 
-    if (result != KERN_SUCCESS) {
+    success = collectAllProcesses();
+    if (!success) {
+        if (!m_cancelled.load()) {
+            emit errorOccurred("Failed to collect process information");
+        }
         return false;
     }
+    // Reported once: a full table keeps dropping every refresh until a
+    // compaction frees space, and each report is a modal dialog in the GUI
+    if (m_cache.stringCompactions() != m_seenCompactions) {
+        m_seenCompactions = m_cache.stringCompactions();
+        m_stringTableFull = false;
+    }
+    if (m_cache.droppedStrings() != m_reportedDroppedStrings && !m_stringTableFull) {
+        emit errorOccurred(QString("String table full; %1 process names or paths left blank")
+                           .arg(m_cache.droppedStrings() - m_reportedDroppedStrings));
+        m_stringTableFull = true;
+    }
+    m_reportedDroppedStrings = m_cache.droppedStrings();
 
-    m_freeMemory = vm_stats.free_count * page_size;
-    m_activeMemory = vm_stats.active_count * page_size;
-    m_inactiveMemory = vm_stats.inactive_count * page_size;
-    m_wiredMemory = vm_stats.wire_count * page_size;
+    publishSnapshot();
+    {
+        MM_TIME_SCOPE(AlertPhase);
+        m_alerts.evaluate(*m_published);
+    }
+    {
+        MM_TIME_SCOPE(HistoryPhase);
+        m_history.append(*m_published);
+    }
+    {
+        MM_TIME_SCOPE(RollupPhase);
+        m_rollups.append(*m_published);
+        if (!m_rollupPath.empty() && m_published->getTimestampMs() >= m_lastRollupSaveMs + kRollupSaveIntervalMs) {
+            saveRollups();
+        }
+    }
 
+    if (m_recorder.isOpen() && !m_recorder.append(*m_published)) {
+        m_recorder.close();
+        emit errorOccurred("Failed to write recording; recording stopped");
+    }
     return true;
 }
 
-bool SystemMonitor::collectAllProcesses() {
-    // Get number of processes
-    int numProcs = proc_listallpids(nullptr, 0);
-    if (numProcs <= 0) {
+void SystemMonitor::setProgressiveScan(bool progressive) {
+    m_progressiveScan = progressive;
+}
+
+void SystemMonitor::setAccountingEnabled(bool enabled) {
+    m_accountingEnabled = enabled;
+    if (!enabled) {
+        m_accounting.clear();
+    }
+}
+
+void SystemMonitor::setAccountingBudget(int microseconds) {
+    m_accounting.setBudget(microseconds > 0 ? static_cast<uint64_t>(microseconds) : 0);
+}
+
+void SystemMonitor::setScanWorkerCount(int count) {
+    m_scanPool.setWorkerCount(count > 0 ? static_cast<size_t>(count) : 0);
+}
+
+void SystemMonitor::setProcessEvents(bool enabled) {
+    m_cache.setEventSource(enabled ? ProcessEventSource::create(ProcessCollector::procRoot()) : nullptr);
+}
+
+void SystemMonitor::setBatchedReads(bool enabled) {
+    m_cache.setBatchedReads(enabled);
+}
+
+bool SystemMonitor::setPressureTrigger(int stallMs, int windowMs, const QStringList& cgroups,
+                                       QString *error) {
+    m_pressureMonitor.reset();
+    if (stallMs <= 0) {
+        return true;
+    }
+
+    auto monitor = std::make_unique<PressureMonitor>([this](const PressureEvent& event) {
+        onPressureStall(event);
+    });
+    uint64_t stallUs = static_cast<uint64_t>(stallMs) * 1000;
+    uint64_t windowUs = static_cast<uint64_t>(std::max(windowMs, stallMs)) * 1000;
+    std::string message;
+    bool watching = monitor->watch("system", ProcessCollector::procRoot() + "/pressure/memory",
+                                   stallUs, windowUs, message);
+    for (const QString& cgroup : cgroups) {
+        watching = watching && monitor->watch(cgroup.toStdString(),
+                                              cgroup.toStdString() + "/memory.pressure",
+                                              stallUs, windowUs, message);
+    }
+    if (!watching || !monitor->start(message)) {
+        if (error) {
+            *error = QString::fromStdString(message);
+        }
         return false;
     }
+    m_pressureMonitor = std::move(monitor);
+    return true;
+}
+
+void SystemMonitor::onPressureStall(const PressureEvent& event) {
+    // Pressure thread: count it for the next sample, which is requested at
+    // once so it shows the processes that were large during the stall
+    m_pendingStalls.fetch_add(1);
+    emit pressureStall(QString::fromStdString(event.source),
+                       QString("memory stall: some %1% full %2% (10 s average), %3 ms stalled in total")
+                           .arg(event.stats.someAvg10, 0, 'f', 2)
+                           .arg(event.stats.fullAvg10, 0, 'f', 2)
+                           .arg(event.stats.someTotalUs / 1000));
+    requestCollect();
+}
 
-    // Get all process IDs
-    std::vector<pid_t> pids(numProcs);
-    numProcs = proc_listallpids(pids.data(), static_cast<int>(pids.size() * sizeof(pid_t)));
+void SystemMonitor::setGrowthThreshold(double bytesPerSecond) {
+    m_growth.setThreshold(bytesPerSecond);
+}
 
-    if (numProcs <= 0) {
+bool SystemMonitor::startRecording(const QString& path) {
+    if (!m_recorder.open(path.toStdString(), m_totalPhysicalRAM)) {
+        emit errorOccurred(QString("Cannot create recording %1").arg(path));
         return false;
     }
+    return true;
+}
 
-    // Resize to actual number of processes
-    pids.resize(numProcs);
+void SystemMonitor::stopRecording() {
+    if (!m_recorder.close()) {
+        emit errorOccurred("Failed to finish recording");
+    }
+}
 
-    // Clear previous process list
-    m_processes.clear();
-    m_processes.reserve(numProcs);
+void SystemMonitor::setRollupPath(const QString& path) {
+    m_rollupPath = path.toStdString();
+    m_lastRollupSaveMs = wallClockMs();
+    if (!m_rollupPath.empty() && !m_rollups.load(m_rollupPath) && QFile::exists(path)) {
+        emit errorOccurred(QString("Cannot read rollups from %1; starting empty").arg(path));
+    }
+}
 
-    // Collect information for each process
-    for (pid_t pid : pids) {
-        ProcessInfo procInfo(pid);
-        if (procInfo.isValid()) {
-            // Show ALL processes (no filtering)
-            m_processes.push_back(std::move(procInfo));
-        }
+void SystemMonitor::setAlertRules(const QString& rules) {
+    std::string error;
+    if (!m_alerts.compile(rules.toStdString(), error)) {
+        emit errorOccurred(QString("Alert rules not applied: %1").arg(QString::fromStdString(error)));
     }
+}
 
-    // Sort by resident memory size (descending)
-    std::sort(m_processes.begin(), m_processes.end(),
-        [](const ProcessInfo& a, const ProcessInfo& b) {
-            return a.getResidentSize() > b.getResidentSize();
-        });
+void SystemMonitor::onAlert(const AlertEvent& event) {
+    emit alertChanged(QString::fromStdString(event.rule), event.active,
+                      QString::fromStdString(event.message));
+}
 
-    return true;
+void SystemMonitor::saveRollups() {
+    m_lastRollupSaveMs = wallClockMs();
+    if (!m_rollups.save(m_rollupPath)) {
+        qWarning() << "Failed to save rollups to" << QString::fromStdString(m_rollupPath);
+    }
 }
 
-uint64_t SystemMonitor::getUsedMemory() const {
-    // Used memory = Active + Wired + Inactive
-    // (Inactive is cached but still occupies RAM)
-    return m_activeMemory + m_wiredMemory + m_inactiveMemory;
+bool SystemMonitor::collectSystemMemoryInfo() {
+    MM_TIME_SCOPE(SystemMemoryPhase);
+    m_hasPressure = m_scanPool.collector().collectMemoryPressure(m_pressure);
+    return m_scanPool.collector().collectSystemMemoryInfo(m_memory);
 }
 
-std::vector<ProcessInfo> SystemMonitor::getTopProcessesByMemory(size_t count) const {
-    std::vector<ProcessInfo> topProcesses;
+bool SystemMonitor::collectAllProcesses() {
+    // Known processes only get their counters refreshed. No sorting here:
+    // consumers ask the snapshot for the order they need.
+    if (!m_progressiveScan || m_published) {
+        return m_cache.refresh(m_scanPool);
+    }
+
+    // First scan: publish what has been read so far, the first batch at
+    // once and then every kPartialPublishIntervalMs
+    uint64_t lastPartialMs = 0;
+    return m_cache.refresh(m_scanPool, [this, &lastPartialMs](size_t scanned, size_t total) {
+        if (m_cancelled.load()) {
+            return false;
+        }
+        uint64_t nowMs = steadyMs();
+        if (lastPartialMs == 0 || nowMs - lastPartialMs >= kPartialPublishIntervalMs) {
+            lastPartialMs = nowMs;
+            publishSnapshot(total - scanned);
+            emit dataReady();
+        }
+        return true;
+    });
+}
 
-    size_t numToReturn = std::min(count, m_processes.size());
-    topProcesses.reserve(numToReturn);
+void SystemMonitor::publishSnapshot(size_t pendingCount) {
+    MM_TIME_SCOPE(PublishPhase);
 
-    for (size_t i = 0; i < numToReturn; ++i) {
-        topProcesses.push_back(m_processes[i]);
+    // Reuse a retired snapshot nobody else references. Readers can only
+    // obtain the published one, so a pooled snapshot with a use count of 1
+    // can't be picked up again behind our back.
+    std::shared_ptr<MemorySnapshot> snapshot;
+    for (auto& pooled : m_snapshotPool) {
+        if (pooled.use_count() == 1) {
+            // Pairs with the release in the last reader's reference drop
+            std::atomic_thread_fence(std::memory_order_acquire);
+            snapshot = pooled;
+            break;
+        }
+    }
+    if (!snapshot) {
+        snapshot = std::make_shared<MemorySnapshot>();
+        if (m_snapshotPool.size() < kSnapshotPoolSize) {
+            m_snapshotPool.push_back(snapshot);
+        }
+    }
+
+    snapshot->assignSystemMemory(++m_sequence, wallClockMs(), m_totalPhysicalRAM, m_memory);
+    snapshot->assignProcesses(m_cache.processes(), m_cache.strings());
+    snapshot->m_added = m_cache.added();
+    snapshot->m_removed = m_cache.removed();
+    snapshot->m_shortLivedCount = m_cache.shortLivedCount();
+    snapshot->m_hasPressure = m_hasPressure;
+    snapshot->m_pressure = m_pressure;
+    snapshot->m_pressureStalls = pendingCount == 0 ? m_pendingStalls.exchange(0) : 0;
+    snapshot->m_pendingCount = pendingCount;
+    if (pendingCount == 0) {
+        // Provisional samples would read as every unread process exiting
+        MM_TIME_SCOPE(GrowthPhase);
+        m_growth.update(*snapshot, snapshot->m_growthRates, snapshot->m_growing);
+    }
+    if (pendingCount == 0 && m_accountingEnabled) {
+        MM_TIME_SCOPE(AccountingPhase);
+        m_accounting.update(*snapshot, m_scanPool.collector(), snapshot->getTimestampMs());
+        m_accounting.fill(*snapshot, snapshot->m_proportionalSizes, snapshot->m_uniqueSizes,
+                          snapshot->m_swapSizes, snapshot->m_accountedAtMs);
     }
 
-    return topProcesses;
+    std::atomic_store(&m_published, SnapshotPtr(std::move(snapshot)));
 }
@@ -0,0 +1,437 @@
+// Benchmarks for the collection, ordering and table population hot paths.
+//
+// Live benchmarks read the running system; synthetic ones build process
+// tables of the requested sizes in memory, so results are comparable
+// between machines. Every benchmark prints one JSON object per line:
+//
+//   {"name":"synthetic/top_k","size":10000,"iterations":412,
+//    "ns_per_op":3.1,"p50_ns":30512,"p90_ns":33001,"p99_ns":41220,
+//    "allocs_per_sample":1.0}
+//
+// ns_per_op divides the mean sample time by the operations in a sample
+// (pids read, rows updated, ...); percentiles and allocations are per sample.
+//
+// With the GUI enabled, the table benchmarks drive a QTableView on the
+// offscreen platform and include its layout and repaint of the visible rows.
+//
+// Live benchmarks read --proc-root (or $MEMORYMONITOR_PROC_ROOT) when given,
+// e.g. a tree written by ProcFixture.
+//
+// Usage: MemoryBench [--filter text] [--sizes 1000,10000,100000] [--time-ms 500]
+//                    [--proc-root dir]
+
+#include <QCoreApplication>
+#if MEMORYMONITOR_BENCH_VIEW
+#include <QApplication>
+#include <QTableView>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "AlertEngine.h"
+#include "GrowthAnalyzer.h"
+#include "Instrumentation.h"
+#include "MemorySnapshot.h"
+#include "MetricsFormatter.h"
+#include "ProcessCache.h"
+#include "ProcessHistory.h"
+#include "ProcessInfo.h"
+#include "ProcessScanPool.h"
+#include "ProcessSortModel.h"
+#include "ProcessTableModel.h"
+#include "SmapsParser.h"
+#include "SystemMonitor.h"
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+
+} // namespace
+
+// Every heap allocation in the process goes through here
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kMinSamples = 5;
+constexpr int kMaxSamples = 100000;
+constexpr size_t kTopCount = 20;
+constexpr size_t kAlertRuleCount = 200;
+
+struct Options {
+    std::string filter;
+    std::vector<size_t> sizes{1000, 10000, 100000};
+    double timeBudgetMs = 500.0;
+};
+
+Options options;
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+// Runs body until the time budget is spent (within sample limits) and prints
+// the result line. setup runs untimed before every sample but counts against
+// the budget.
+void measure(const std::string& name, size_t size, size_t opsPerSample,
+             const std::function<void()>& setup, const std::function<void()>& body) {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+        return;
+    }
+
+    // Warm-up: first-touch page faults, lazy buffers
+    setup();
+    body();
+
+    std::vector<double> samples;
+    uint64_t allocations = 0;
+    double totalNs = 0.0;
+    auto deadline = Clock::now() + std::chrono::duration<double, std::milli>(options.timeBudgetMs);
+    while (static_cast<int>(samples.size()) < kMaxSamples
+           && (static_cast<int>(samples.size()) < kMinSamples || Clock::now() < deadline)) {
+        setup();
+        uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        body();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        allocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        samples.push_back(ns);
+        totalNs += ns;
+    }
+
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    double meanNs = totalNs / samples.size();
+    std::printf("{\"name\":\"%s\",\"size\":%zu,\"iterations\":%zu,\"ns_per_op\":%.1f,"
+                "\"p50_ns\":%.0f,\"p90_ns\":%.0f,\"p99_ns\":%.0f,\"allocs_per_sample\":%.1f}\n",
+                name.c_str(), size, samples.size(), meanNs / std::max<size_t>(opsPerSample, 1),
+                percentile(sorted, 0.50), percentile(sorted, 0.90), percentile(sorted, 0.99),
+                static_cast<double>(allocations) / samples.size());
+    std::fflush(stdout);
+}
+
+void noSetup() {}
+
+// Process table shaped like a busy host: few distinct names, long-tailed RSS
+struct SyntheticTable {
+    std::shared_ptr<StringPool> strings = std::make_shared<StringPool>();
+    std::vector<ProcessRecord> current;
+    std::vector<ProcessRecord> next;  // current after one sample of churn
+};
+
+SyntheticTable makeSyntheticTable(size_t size) {
+    std::mt19937_64 random(size);
+    std::lognormal_distribution<double> residentSize(16.0, 1.5);  // median ~9 MB
+    SyntheticTable table;
+
+    std::vector<uint32_t> nameIds, pathIds;
+    for (int i = 0; i < 400; ++i) {
+        std::string name = "worker-" + std::to_string(i);
+        nameIds.push_back(table.strings->intern(name));
+        pathIds.push_back(table.strings->intern("/usr/lib/service-" + std::to_string(i % 300) + "/bin/" + name));
+    }
+
+    pid_t pid = 1;
+    auto makeRecord = [&]() {
+        size_t kind = random() % nameIds.size();
+        uint64_t rss = static_cast<uint64_t>(residentSize(random)) & ~uint64_t(4095);
+        return ProcessRecord{pid, nameIds[kind], pathIds[kind], static_cast<uint64_t>(pid) * 100,
+                             rss, rss * 4};
+    };
+    for (size_t i = 0; i < size; ++i, ++pid) {
+        table.current.push_back(makeRecord());
+    }
+
+    // 1% of processes replaced, 10% with a new RSS
+    table.next = table.current;
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t roll = random() % 100;
+        if (roll == 0) {
+            table.next[i] = makeRecord();
+            ++pid;
+        } else if (roll <= 10) {
+            table.next[i].residentSize += 4096 * (1 + random() % 256);
+        }
+    }
+    return table;
+}
+
+// A mix of the rule kinds, mostly per-name and per-path filters
+std::string makeAlertRules(size_t count) {
+    std::string rules;
+    for (size_t i = 0; i < count; ++i) {
+        std::string n = std::to_string(i);
+        switch (i % 5) {
+        case 0: rules += "process name \"worker-" + n + "\" rss > 2GB\n"; break;
+        case 1: rules += "sum rss name \"worker-" + n + "*\" > 5% for 30s\n"; break;
+        case 2: rules += "count path \"/usr/lib/service-" + n + "/*\" > 100\n"; break;
+        case 3: rules += "process growth > " + n + "MB/h for 1m\n"; break;
+        default: rules += "system free < " + std::to_string(i % 20) + "% for 10s\n"; break;
+        }
+    }
+    return rules;
+}
+
+// smaps text for count mappings: mostly anonymous, with library segments
+// and a heap mixed in, every field a current kernel prints
+std::string makeSmapsText(size_t count) {
+    static const char *const fields[] = {
+        "Size", "KernelPageSize", "MMUPageSize", "Rss", "Pss", "Pss_Dirty", "Shared_Clean",
+        "Shared_Dirty", "Private_Clean", "Private_Dirty", "Referenced", "Anonymous", "KSM",
+        "LazyFree", "AnonHugePages", "ShmemPmdMapped", "FilePmdMapped", "Shared_Hugetlb",
+        "Private_Hugetlb", "Swap", "SwapPss", "Locked",
+    };
+    std::string text;
+    char line[256];
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t start = 0x7f0000000000ull + i * 0x21000;
+        const char *name = i % 50 == 0 ? "/usr/lib/x86_64-linux-gnu/libc.so.6"
+                         : i % 1000 == 1 ? "[heap]" : "";
+        std::snprintf(line, sizeof(line), "%llx-%llx rw-p 00000000 00:00 0                          %s\n",
+                      static_cast<unsigned long long>(start),
+                      static_cast<unsigned long long>(start + 0x21000), name);
+        text += line;
+        for (const char *field : fields) {
+            std::snprintf(line, sizeof(line), "%s:%*d kB\n",
+                          field, static_cast<int>(24 - std::strlen(field)), static_cast<int>(i % 132));
+            text += line;
+        }
+        text += "THPeligible:    0\nVmFlags: rd wr mr mw me ac sd \n";
+    }
+    return text;
+}
+
+std::shared_ptr<MemorySnapshot> makeSnapshot(const SyntheticTable& table,
+                                             const std::vector<ProcessRecord>& records,
+                                             uint64_t sequence) {
+    auto snapshot = std::make_shared<MemorySnapshot>();
+    SystemMemoryInfo memory;
+    snapshot->assignSystemMemory(sequence, sequence * 1000, uint64_t(1) << 40, memory);
+    snapshot->assignProcesses(records, table.strings);
+    return snapshot;
+}
+
+void benchLive() {
+    std::vector<pid_t> pids;
+    ProcessScanPool pool(1);
+    pool.collector().listProcesses(pids);
+    size_t liveCount = pids.size();
+
+    measure("live/collect_process_info", liveCount, liveCount, noSetup, [&]() {
+        ProcessInfo info;
+        for (pid_t pid : pids) {
+            info.setPid(pid);
+            info.update();
+        }
+    });
+
+    measure("live/cache_refresh_cold", liveCount, liveCount, noSetup, [&]() {
+        ProcessCache cache;
+        cache.refresh(pool);
+    });
+
+    ProcessCache warmCache;
+    warmCache.refresh(pool);
+    measure("live/cache_refresh_warm", liveCount, liveCount, noSetup, [&]() {
+        warmCache.refresh(pool);
+    });
+
+    SystemMonitor monitor;
+    monitor.setScanWorkerCount(1);
+    measure("live/collect_data", liveCount, 1, noSetup, [&]() {
+        monitor.collectData();
+    });
+}
+
+void benchSynthetic(size_t size) {
+    SyntheticTable table = makeSyntheticTable(size);
+    auto current = makeSnapshot(table, table.current, 1);
+    auto next = makeSnapshot(table, table.next, 2);
+
+    MemorySnapshot target;
+    measure("synthetic/publish", size, size, noSetup, [&]() {
+        target.assignProcesses(table.current, table.strings);
+    });
+
+    measure("synthetic/top_k", size, size, [&]() {
+        target.assignProcesses(table.current, table.strings);  // drop the cached order
+    }, [&]() {
+        target.getTopProcessesByMemory(kTopCount);
+    });
+
+    measure("synthetic/sort_all", size, size, [&]() {
+        target.assignProcesses(table.current, table.strings);
+    }, [&]() {
+        target.getProcessesByMemory();
+    });
+
+    // Alternating samples: 10% of rows change, 1% are new processes
+    ProcessHistory history;
+    bool appendNext = true;
+    measure("synthetic/history_append", size, size, noSetup, [&]() {
+        history.append(appendNext ? *next : *current);
+        appendNext = !appendNext;
+    });
+
+    // One sample a second, alternating tables
+    GrowthAnalyzer growth;
+    MemorySnapshot sample;
+    std::vector<float> rates;
+    std::vector<uint32_t> growing;
+    uint64_t sequence = 0;
+    measure("synthetic/growth_update", size, size, [&]() {
+        ++sequence;
+        sample.assignSystemMemory(sequence, sequence * 1000, uint64_t(1) << 40, SystemMemoryInfo());
+        sample.assignProcesses(sequence % 2 ? table.next : table.current, table.strings);
+    }, [&]() {
+        growth.update(sample, rates, growing);
+    });
+
+#if MEMORYMONITOR_INSTRUMENTATION
+    // What one MM_TIME_SCOPE costs, per scope
+    measure("synthetic/phase_timer", size, size, noSetup, [&]() {
+        for (size_t i = 0; i < size; ++i) {
+            MM_TIME_SCOPE(SortPhase);
+        }
+    });
+#endif
+
+    AlertEngine alerts;
+    std::string error;
+    alerts.compile(makeAlertRules(kAlertRuleCount), error);
+    measure("synthetic/alert_evaluate", size, size, [&]() {
+        ++sequence;
+        sample.assignSystemMemory(sequence, sequence * 1000, uint64_t(1) << 40, SystemMemoryInfo());
+        sample.assignProcesses(sequence % 2 ? table.next : table.current, table.strings);
+    }, [&]() {
+        alerts.evaluate(sample);
+    });
+
+    // One scrape body per new sample, top 20 as served by default
+    MetricsFormatter metrics;
+    std::string exposition;
+    measure("synthetic/metrics_render", size, size, [&]() {
+        ++sequence;
+        sample.assignSystemMemory(sequence, sequence * 1000, uint64_t(1) << 40, SystemMemoryInfo());
+        sample.assignProcesses(sequence % 2 ? table.next : table.current, table.strings);
+    }, [&]() {
+        metrics.render(sample, exposition);
+    });
+
+    // size mappings fed in read()-sized chunks, as MappingMonitor does
+    std::string smaps = makeSmapsText(size);
+    SmapsParser parser;
+    MappingBreakdown breakdown;
+    measure("synthetic/smaps_parse", size, size, noSetup, [&]() {
+        parser.begin(breakdown);
+        for (size_t offset = 0; offset < smaps.size(); offset += 256 * 1024) {
+            parser.feed(smaps.data() + offset, std::min<size_t>(256 * 1024, smaps.size() - offset));
+        }
+        parser.finish();
+    });
+
+    // Model plus sorted proxy, as wired up in MainWindow
+    ProcessTableModel model;
+    ProcessSortModel proxy;
+    proxy.setSourceModel(&model);
+    proxy.sort(ProcessTableModel::MemoryColumn, Qt::DescendingOrder);
+    model.setSnapshot(current);
+#if MEMORYMONITOR_BENCH_VIEW
+    QTableView view;
+    view.setModel(&proxy);
+    view.setSortingEnabled(true);
+    view.resize(1000, 700);
+    view.show();
+    QApplication::processEvents();
+#endif
+
+    bool showNext = true;
+    measure("synthetic/table_update", size, size, noSetup, [&]() {
+        model.setSnapshot(showNext ? next : current);
+        showNext = !showNext;
+#if MEMORYMONITOR_BENCH_VIEW
+        QApplication::processEvents();  // the view's relayout and repaint
+#endif
+    });
+
+    int lastRow = proxy.rowCount() - 1;
+    measure("synthetic/cumulative", size, size, [&]() {
+        model.setSnapshot(showNext ? next : current);  // invalidates the prefix sum
+        showNext = !showNext;
+    }, [&]() {
+        proxy.data(proxy.index(lastRow, ProcessTableModel::CumulativeColumn), ProcessTableModel::SortRole);
+    });
+}
+
+std::vector<size_t> parseSizes(const char *list) {
+    std::vector<size_t> sizes;
+    while (*list) {
+        char *end;
+        size_t size = std::strtoul(list, &end, 10);
+        if (end == list) {
+            break;
+        }
+        sizes.push_back(size);
+        list = *end == ',' ? end + 1 : end;
+    }
+    return sizes;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+#if MEMORYMONITOR_BENCH_VIEW
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+#else
+    QCoreApplication app(argc, argv);
+#endif
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--filter") == 0) {
+            options.filter = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--sizes") == 0) {
+            options.sizes = parseSizes(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--time-ms") == 0) {
+            options.timeBudgetMs = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--proc-root") == 0) {
+            ProcessCollector::setProcRoot(argv[i + 1]);
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    benchLive();
+    for (size_t size : options.sizes) {
+        benchSynthetic(size);
+    }
+    return 0;
+}
@@ -0,0 +1,354 @@
+// Writes a synthetic procfs-shaped tree for LinuxProcessCollector.
+//
+// The tree holds meminfo plus, per process, a "<pid>/stat" line and an
+// "exe" symlink (dangling, only its target is read). Names and paths follow
+// a skewed distribution over common server binaries, ~10% of entries are
+// kernel threads without exe, and RSS is log-normal.
+//
+// Every generation is derived from the seed alone: generation g is
+// generation 0 after g rounds of churn (exits, new pids, RSS drift), so two
+// runs with the same arguments produce identical trees. Writing a generation
+// over an existing root updates it in place: exited pid directories are
+// removed and stat files are replaced by rename, which lets a collector that
+// is scanning the root at the same time see processes disappear mid-scan.
+//
+// Usage: ProcFixture <root> <processes> [--generation g] [--churn percent]
+//                    [--vanished percent] [--seed n]
+//
+// --vanished leaves that share of pid directories without a stat file, as
+// if the process exited between the directory listing and the read.
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace {
+
+constexpr uint64_t kPageSize = 4096;
+constexpr pid_t kPidMax = 4194304;
+constexpr uint64_t kTotalRAM = uint64_t(256) << 30;
+constexpr uint64_t kTicksPerGeneration = 100;
+
+struct Binary {
+    const char *name;
+    const char *path;
+};
+
+// Ordered most to least common
+const Binary kBinaries[] = {
+    {"postgres", "/usr/lib/postgresql/16/bin/postgres"},
+    {"python3.12", "/usr/bin/python3.12"},
+    {"java", "/usr/lib/jvm/java-21-openjdk-amd64/bin/java"},
+    {"node", "/usr/local/bin/node"},
+    {"nginx", "/usr/sbin/nginx"},
+    {"php-fpm8.3", "/usr/sbin/php-fpm8.3"},
+    {"bash", "/usr/bin/bash"},
+    {"sshd", "/usr/sbin/sshd"},
+    {"containerd-shim-runc-v2", "/usr/bin/containerd-shim-runc-v2"},
+    {"redis-server", "/usr/bin/redis-server"},
+    {"systemd", "/usr/lib/systemd/systemd"},
+    {"chrome", "/opt/google/chrome/chrome"},
+    {"gunicorn", "/srv/app/venv/bin/python3"},
+    {"envoy", "/usr/local/bin/envoy"},
+    {"rsyslogd", "/usr/sbin/rsyslogd"},
+    {"cron", "/usr/sbin/cron"},
+    {"dockerd", "/usr/bin/dockerd"},
+    {"memcached", "/usr/bin/memcached"},
+    {"prometheus-node-exporter", "/usr/bin/prometheus-node-exporter"},
+    {"my app (worker)", "/opt/my app/bin/my app (worker)"},
+};
+
+const char *const kKernelThreads[] = {
+    "kworker/0:1H", "ksoftirqd/3", "rcu_preempt", "migration/7", "kswapd0", "jbd2/nvme0n1p2-8",
+};
+
+struct Process {
+    pid_t pid;
+    uint64_t startTime;  // ticks since boot
+    uint64_t residentSize;
+    uint64_t virtualSize;
+    int binary;          // index into kBinaries, -1 for a kernel thread
+    int kernelThread;
+    bool vanished;
+};
+
+struct Options {
+    std::string root;
+    size_t processes = 0;
+    unsigned generation = 0;
+    unsigned churnPercent = 2;
+    unsigned vanishedPercent = 0;
+    uint64_t seed = 1;
+};
+
+// Portable distributions: std:: ones differ between standard libraries
+class Random {
+public:
+    explicit Random(uint64_t seed) : m_engine(seed) {}
+
+    uint64_t below(uint64_t bound) { return m_engine() % bound; }
+    double uniform() { return (m_engine() >> 11) * (1.0 / 9007199254740992.0); }
+
+    double normal() {
+        double u = std::max(uniform(), 1e-12);
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * uniform());
+    }
+
+    // Rank r drawn with weight 1 / (r + 1)
+    int skewed(int count) {
+        double total = 0.0;
+        for (int r = 0; r < count; ++r) {
+            total += 1.0 / (r + 1);
+        }
+        double pick = uniform() * total;
+        for (int r = 0; r < count; ++r) {
+            pick -= 1.0 / (r + 1);
+            if (pick <= 0.0) {
+                return r;
+            }
+        }
+        return count - 1;
+    }
+
+private:
+    std::mt19937_64 m_engine;
+};
+
+class Generator {
+public:
+    Generator(const Options& options)
+        : m_options(options), m_random(options.seed) {}
+
+    std::vector<Process> run() {
+        for (size_t i = 0; i < m_options.processes; ++i) {
+            m_processes.push_back(spawn(0));
+        }
+        for (unsigned generation = 1; generation <= m_options.generation; ++generation) {
+            churn(generation);
+        }
+        for (Process& process : m_processes) {
+            process.vanished = m_random.below(100) < m_options.vanishedPercent;
+        }
+        return m_processes;
+    }
+
+private:
+    const Options& m_options;
+    Random m_random;
+    std::vector<Process> m_processes;
+    pid_t m_nextPid = 1;
+
+    Process spawn(unsigned generation) {
+        Process process{};
+        process.pid = m_nextPid;
+        m_nextPid = m_nextPid % (kPidMax - 1) + 1;
+        process.startTime = generation * kTicksPerGeneration + m_random.below(kTicksPerGeneration);
+        if (m_random.below(10) == 0) {
+            process.binary = -1;
+            process.kernelThread = static_cast<int>(m_random.below(std::size(kKernelThreads)));
+        } else {
+            process.binary = m_random.skewed(static_cast<int>(std::size(kBinaries)));
+            // Median ~12 MB, long tail into the GBs
+            double rss = std::exp(16.3 + 1.6 * m_random.normal());
+            process.residentSize = static_cast<uint64_t>(rss) / kPageSize * kPageSize;
+            process.virtualSize = process.residentSize * (2 + m_random.below(30));
+        }
+        return process;
+    }
+
+    void churn(unsigned generation) {
+        size_t exits = 0;
+        for (size_t i = 0; i < m_processes.size();) {
+            if (m_random.below(100) < m_options.churnPercent) {
+                m_processes[i] = m_processes.back();
+                m_processes.pop_back();
+                ++exits;
+            } else {
+                Process& process = m_processes[i];
+                if (process.binary >= 0 && m_random.below(4) == 0) {
+                    // +-12% drift
+                    double factor = 0.88 + 0.24 * m_random.uniform();
+                    process.residentSize = static_cast<uint64_t>(process.residentSize * factor)
+                                           / kPageSize * kPageSize;
+                }
+                ++i;
+            }
+        }
+        for (size_t i = 0; i < exits; ++i) {
+            m_processes.push_back(spawn(generation));
+        }
+        std::sort(m_processes.begin(), m_processes.end(),
+                  [](const Process& a, const Process& b) { return a.pid < b.pid; });
+    }
+};
+
+bool writeFile(const std::string& path, const std::string& contents) {
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = write(fd, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size());
+    close(fd);
+    return ok && rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+std::string statLine(const Process& process) {
+    const char *comm = process.binary >= 0 ? kBinaries[process.binary].name
+                                           : kKernelThreads[process.kernelThread];
+    char line[512];
+    // Fields 3-21, then 22 starttime, 23 vsize, 24 rss (pages), then the rest
+    snprintf(line, sizeof(line),
+             "%d (%.15s) S 1 %d %d 0 -1 4194560 100 0 0 0 5 3 0 0 20 0 1 0 %llu %llu %llu "
+             "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0\n",
+             process.pid, comm, process.pid, process.pid,
+             static_cast<unsigned long long>(process.startTime),
+             static_cast<unsigned long long>(process.virtualSize),
+             static_cast<unsigned long long>(process.residentSize / kPageSize));
+    return line;
+}
+
+std::string meminfo(const std::vector<Process>& processes) {
+    uint64_t resident = 0;
+    for (const Process& process : processes) {
+        resident += process.residentSize;
+    }
+    uint64_t totalKb = kTotalRAM / 1024;
+    uint64_t activeKb = std::min(resident / 1024, totalKb / 2);
+    uint64_t inactiveKb = totalKb / 8;
+    uint64_t freeKb = totalKb - std::min(totalKb, activeKb + inactiveKb + totalKb / 16);
+
+    char text[512];
+    snprintf(text, sizeof(text),
+             "MemTotal:       %llu kB\nMemFree:        %llu kB\nActive:         %llu kB\n"
+             "Inactive:       %llu kB\nUnevictable:    %llu kB\nSUnreclaim:     %llu kB\n"
+             "KernelStack:    %llu kB\nPageTables:     %llu kB\n",
+             static_cast<unsigned long long>(totalKb), static_cast<unsigned long long>(freeKb),
+             static_cast<unsigned long long>(activeKb), static_cast<unsigned long long>(inactiveKb),
+             static_cast<unsigned long long>(totalKb / 256), static_cast<unsigned long long>(totalKb / 128),
+             static_cast<unsigned long long>(processes.size() * 16),
+             static_cast<unsigned long long>(totalKb / 512));
+    return text;
+}
+
+void removeTree(const std::string& directory) {
+    for (const char *name : {"stat", "stat.tmp", "exe"}) {
+        unlink((directory + '/' + name).c_str());
+    }
+    rmdir(directory.c_str());
+}
+
+// Drops pid directories that are not part of the new generation
+void removeExited(const std::string& root, const std::vector<Process>& processes) {
+    std::unordered_set<pid_t> alive;
+    for (const Process& process : processes) {
+        alive.insert(process.pid);
+    }
+
+    DIR *dir = opendir(root.c_str());
+    if (!dir) {
+        return;
+    }
+    std::vector<std::string> stale;
+    while (dirent *entry = readdir(dir)) {
+        char *end;
+        long pid = std::strtol(entry->d_name, &end, 10);
+        if (*end == '\0' && pid > 0 && !alive.count(static_cast<pid_t>(pid))) {
+            stale.push_back(root + '/' + entry->d_name);
+        }
+    }
+    closedir(dir);
+    for (const std::string& directory : stale) {
+        removeTree(directory);
+    }
+}
+
+bool writeProcess(const std::string& root, const Process& process) {
+    std::string directory = root + '/' + std::to_string(process.pid);
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        return false;
+    }
+
+    std::string exe = directory + "/exe";
+    unlink(exe.c_str());
+    if (process.binary >= 0 && symlink(kBinaries[process.binary].path, exe.c_str()) != 0) {
+        return false;
+    }
+
+    if (process.vanished) {
+        unlink((directory + "/stat").c_str());
+        return true;
+    }
+    return writeFile(directory + "/stat", statLine(process));
+}
+
+bool parseArguments(int argc, char *argv[], Options& options) {
+    if (argc < 3) {
+        return false;
+    }
+    options.root = argv[1];
+    options.processes = std::strtoul(argv[2], nullptr, 10);
+    for (int i = 3; i + 1 < argc; i += 2) {
+        unsigned long value = std::strtoul(argv[i + 1], nullptr, 10);
+        if (std::strcmp(argv[i], "--generation") == 0) {
+            options.generation = static_cast<unsigned>(value);
+        } else if (std::strcmp(argv[i], "--churn") == 0) {
+            options.churnPercent = static_cast<unsigned>(std::min(value, 100ul));
+        } else if (std::strcmp(argv[i], "--vanished") == 0) {
+            options.vanishedPercent = static_cast<unsigned>(std::min(value, 100ul));
+        } else if (std::strcmp(argv[i], "--seed") == 0) {
+            options.seed = value;
+        } else {
+            return false;
+        }
+    }
+    return options.processes > 0 && options.processes < static_cast<size_t>(kPidMax);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s <root> <processes> [--generation g] [--churn percent] "
+                             "[--vanished percent] [--seed n]\n", argv[0]);
+        return 1;
+    }
+
+    if (mkdir(options.root.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::perror(options.root.c_str());
+        return 1;
+    }
+
+    Generator generator(options);
+    std::vector<Process> processes = generator.run();
+
+    removeExited(options.root, processes);
+    for (const Process& process : processes) {
+        if (!writeProcess(options.root, process)) {
+            std::perror(std::to_string(process.pid).c_str());
+            return 1;
+        }
+    }
+    if (!writeFile(options.root + "/meminfo", meminfo(processes))) {
+        std::perror("meminfo");
+        return 1;
+    }
+
+    std::printf("%zu processes, generation %u, in %s\n",
+                processes.size(), options.generation, options.root.c_str());
+    return 0;
+}
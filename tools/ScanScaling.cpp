@@ -0,0 +1,162 @@
+// Scaling report for the parallel process scan.
+//
+// Runs a cold (every pid new) and a warm (counters only) ProcessCache refresh
+// with 1, 2, 4, ... N workers against the live system and prints the median
+// wall time of each. Also checks that every worker count yields the same
+// process set as the serial scan.
+//
+// Then compares the plain and the batched (io_uring) read path on warm
+// refreshes at 1 and N workers: median wall time and, in instrumented
+// builds, file system syscalls per refresh.
+//
+// Usage: ScanScaling [--proc-root dir] [maxWorkers] [iterations]
+//
+// --proc-root (or $MEMORYMONITOR_PROC_ROOT) reads a procfs-shaped tree such
+// as one written by ProcFixture instead of /proc.
+
+#include "Instrumentation.h"
+#include "ProcessCache.h"
+#include "ProcessCollector.h"
+#include "ProcessScanPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// Identity of every process, independent of the order they were read in
+std::vector<std::string> processSet(const ProcessCache& cache) {
+    std::vector<std::string> set;
+    const StringPool& strings = *cache.strings();
+    for (const ProcessRecord& record : cache.processes()) {
+        set.push_back(std::to_string(record.pid) + ' ' + strings.str(record.pathId)
+                      + ' ' + strings.str(record.nameId));
+    }
+    std::sort(set.begin(), set.end());
+    return set;
+}
+
+struct WarmResult {
+    double wallMs;
+    double syscalls;  // per refresh, 0 without instrumentation
+    std::vector<std::string> set;
+};
+
+WarmResult warmRefreshes(ProcessScanPool& pool, bool batched, int iterations) {
+    ProcessCache cache;
+    cache.setBatchedReads(batched);
+    cache.refresh(pool);
+    cache.refresh(pool);  // first batch sets up the ring outside the timing
+
+    Instrumentation& instrumentation = Instrumentation::instance();
+    uint64_t syscallsBefore = instrumentation.counter(Instrumentation::Syscalls);
+    std::vector<double> wall;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = Clock::now();
+        cache.refresh(pool);
+        wall.push_back(elapsedMs(start));
+    }
+    uint64_t syscalls = instrumentation.counter(Instrumentation::Syscalls) - syscallsBefore;
+    return {median(wall), static_cast<double>(syscalls) / iterations, processSet(cache)};
+}
+
+int usage(const char *program) {
+    std::fprintf(stderr, "Usage: %s [--proc-root dir] [maxWorkers] [iterations]\n", program);
+    return 1;
+}
+
+// Positive count from text, or 0
+unsigned long parseCount(const char *text) {
+    char *end = nullptr;
+    unsigned long value = std::strtoul(text, &end, 10);
+    return end != text && *end == '\0' && text[0] != '-' ? value : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::vector<const char *> positional;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--proc-root") == 0 && i + 1 < argc) {
+            ProcessCollector::setProcRoot(argv[++i]);
+        } else if (argv[i][0] == '-' || positional.size() == 2) {
+            return usage(argv[0]);
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+
+    size_t maxWorkers = positional.size() > 0 ? parseCount(positional[0])
+                                              : std::max(1u, std::thread::hardware_concurrency());
+    int iterations = positional.size() > 1 ? static_cast<int>(parseCount(positional[1])) : 10;
+    if (maxWorkers == 0 || iterations <= 0) {
+        return usage(argv[0]);
+    }
+
+    std::vector<std::string> serialSet;
+    std::printf("%8s %10s %12s %12s %8s\n", "workers", "processes", "cold ms", "warm ms", "match");
+
+    // 1, 2, 4, ... and always finish with maxWorkers itself
+    for (size_t workers = 1;; workers = std::min(workers * 2, maxWorkers)) {
+        ProcessScanPool pool(workers);
+        std::vector<double> cold, warm;
+        std::vector<std::string> set;
+
+        for (int i = 0; i < iterations; ++i) {
+            ProcessCache cache;
+            auto start = Clock::now();
+            cache.refresh(pool);
+            cold.push_back(elapsedMs(start));
+
+            start = Clock::now();
+            cache.refresh(pool);
+            warm.push_back(elapsedMs(start));
+
+            if (i == 0) {
+                set = processSet(cache);
+            }
+        }
+
+        if (workers == 1) {
+            serialSet = set;
+        }
+        std::printf("%8zu %10zu %12.3f %12.3f %8s\n", workers, set.size(),
+                    median(cold), median(warm), set == serialSet ? "yes" : "NO");
+
+        if (workers == maxWorkers) {
+            break;
+        }
+    }
+
+    std::printf("\n%8s %10s %12s %14s %12s %14s %8s\n", "workers", "processes",
+                "plain ms", "plain calls", "batched ms", "batched calls", "match");
+    for (size_t workers : {static_cast<size_t>(1), maxWorkers}) {
+        ProcessScanPool pool(workers);
+        WarmResult plain = warmRefreshes(pool, false, iterations);
+        WarmResult batched = warmRefreshes(pool, true, iterations);
+        std::printf("%8zu %10zu %12.3f %14.0f %12.3f %14.0f %8s\n", workers, plain.set.size(),
+                    plain.wallMs, plain.syscalls, batched.wallMs, batched.syscalls,
+                    plain.set == batched.set ? "yes" : "NO");
+        if (maxWorkers == 1) {
+            break;
+        }
+    }
+
+    return 0;
+}